@@ -0,0 +1,242 @@
+#include "thread_tests.h"
+#include "perfutils.h"
+#include "worker_pool.h"
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+
+using steady_clock = std::chrono::steady_clock;
+using nanoseconds = std::chrono::nanoseconds;
+
+namespace perf::threads
+{
+	namespace
+	{
+		// per thread; high enough to swamp the start barrier, low enough that 64 threads hammering one line finish in ~1s
+		constexpr size_t kOpsPerThread = 1u << 18;
+		constexpr size_t kLatencySamplesPerThread = 1u << 14;
+
+		struct alignas(64) padded_counter
+		{
+			std::atomic<uint64_t> _value{ 0 };
+		};
+
+		enum class atomic_op
+		{
+			kFetchAddRelaxed,
+			kFetchAddSeqCst,
+			kCasLoop,
+			kExchange,
+			kStoreRelaxed,
+			kStoreRelease,
+			kStoreSeqCst,
+			kLoadRelaxed,
+			kLoadAcquire,
+			kLoadSeqCst,
+			// every thread increments its own cache line, readers would sum the shards
+			kShardedPadded,
+			// same, but the shards are packed together so they share cache lines
+			kShardedFalseSharing,
+		};
+
+		const char* atomic_op_name(atomic_op op)
+		{
+			switch (op)
+			{
+			case atomic_op::kFetchAddRelaxed: return "fetch_add(relaxed)";
+			case atomic_op::kFetchAddSeqCst: return "fetch_add(seq_cst)";
+			case atomic_op::kCasLoop: return "CAS retry loop";
+			case atomic_op::kExchange: return "exchange";
+			case atomic_op::kStoreRelaxed: return "store(relaxed)";
+			case atomic_op::kStoreRelease: return "store(release)";
+			case atomic_op::kStoreSeqCst: return "store(seq_cst)";
+			case atomic_op::kLoadRelaxed: return "load(relaxed)";
+			case atomic_op::kLoadAcquire: return "load(acquire)";
+			case atomic_op::kLoadSeqCst: return "load(seq_cst)";
+			case atomic_op::kShardedPadded: return "sharded fetch_add (padded)";
+			case atomic_op::kShardedFalseSharing: return "sharded fetch_add (false sharing)";
+			}
+			return "?";
+		}
+
+		struct contention_state
+		{
+			explicit contention_state(size_t threads)
+				: _padded(threads)
+				, _packed(threads)
+				, _cas_retries(threads)
+			{
+			}
+
+			padded_counter _shared;
+			std::vector<padded_counter> _padded;
+			std::vector<std::atomic<uint64_t>> _packed;
+			std::vector<padded_counter> _cas_retries;
+		};
+
+		// returns something derived from the op so that loads can't be discarded
+		template<atomic_op kOp>
+		inline uint64_t do_op(contention_state& state, size_t thread, uint64_t i)
+		{
+			auto& shared = state._shared._value;
+			if constexpr (kOp == atomic_op::kFetchAddRelaxed)
+				return shared.fetch_add(1, std::memory_order_relaxed);
+			else if constexpr (kOp == atomic_op::kFetchAddSeqCst)
+				return shared.fetch_add(1);
+			else if constexpr (kOp == atomic_op::kCasLoop)
+			{
+				auto expected = shared.load(std::memory_order_relaxed);
+				uint64_t retries = 0;
+				while (!shared.compare_exchange_weak(expected, expected + 1))
+					++retries;
+				if (retries)
+					state._cas_retries[thread]._value.fetch_add(retries, std::memory_order_relaxed);
+				return expected;
+			}
+			else if constexpr (kOp == atomic_op::kExchange)
+				return shared.exchange(i);
+			else if constexpr (kOp == atomic_op::kStoreRelaxed)
+			{
+				shared.store(i, std::memory_order_relaxed);
+				return i;
+			}
+			else if constexpr (kOp == atomic_op::kStoreRelease)
+			{
+				shared.store(i, std::memory_order_release);
+				return i;
+			}
+			else if constexpr (kOp == atomic_op::kStoreSeqCst)
+			{
+				shared.store(i);
+				return i;
+			}
+			else if constexpr (kOp == atomic_op::kLoadRelaxed)
+				return shared.load(std::memory_order_relaxed);
+			else if constexpr (kOp == atomic_op::kLoadAcquire)
+				return shared.load(std::memory_order_acquire);
+			else if constexpr (kOp == atomic_op::kLoadSeqCst)
+				return shared.load();
+			else if constexpr (kOp == atomic_op::kShardedPadded)
+				return state._padded[thread]._value.fetch_add(1, std::memory_order_relaxed);
+			else
+				return state._packed[thread].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// cost of back-to-back rdtsc reads, subtracted from the per-op samples
+		uint64_t rdtsc_overhead()
+		{
+			static const uint64_t _overhead = []() {
+				RunningStat stat;
+				for (auto n = 0u; n < 10000; ++n)
+				{
+					const auto t0 = rdtsc();
+					const auto t1 = rdtsc();
+					stat.push(double(t1 - t0));
+				}
+				return uint64_t(stat.median());
+			}();
+			return _overhead;
+		}
+
+		template<atomic_op kOp>
+		void run_contention(worker_pool& pool, placement policy)
+		{
+			const auto threads = pool.size();
+			contention_state state{ threads };
+			std::vector<uint64_t> elapsed_ns(threads);
+			std::vector<uint64_t> sinks(threads);
+
+			// throughput; nothing but the ops in the loop
+			pool.run([&](size_t thread) {
+				uint64_t sink = 0;
+				const auto start = steady_clock::now();
+				for (uint64_t i = 0; i < kOpsPerThread; ++i)
+					sink += do_op<kOp>(state, thread, i);
+				elapsed_ns[thread] = uint64_t(std::chrono::duration_cast<nanoseconds>(steady_clock::now() - start).count());
+				sinks[thread] = sink;
+			});
+			const auto cas_retries_throughput = [&state]() {
+				uint64_t retries = 0;
+				for (auto& r : state._cas_retries)
+					retries += r._value.exchange(0);
+				return retries;
+			}();
+
+			// latency; every op individually stamped
+			std::vector<std::vector<uint64_t>> ticks(threads, std::vector<uint64_t>(kLatencySamplesPerThread));
+			pool.run([&](size_t thread) {
+				auto& samples = ticks[thread];
+				uint64_t sink = 0;
+				for (uint64_t i = 0; i < kLatencySamplesPerThread; ++i)
+				{
+					const auto t0 = rdtsc();
+					sink += do_op<kOp>(state, thread, i);
+					const auto t1 = rdtsc();
+					samples[i] = t1 - t0;
+				}
+				sinks[thread] += sink;
+			});
+
+			const auto slowest_ns = *std::max_element(elapsed_ns.begin(), elapsed_ns.end());
+			const auto mops = double(kOpsPerThread * threads) / double(slowest_ns) * 1000.0;
+
+			const auto overhead = rdtsc_overhead();
+			const auto ticks_per_ns = tsc_ticks_per_ns();
+			Stats latency;
+			for (const auto& samples : ticks)
+				for (auto t : samples)
+					latency.push(double(t > overhead ? t - overhead : 0) / ticks_per_ns);
+
+			std::cout << "\t" << std::setw(9) << placement_name(policy)
+				<< std::setw(9) << threads
+				<< std::setw(12) << std::setprecision(2) << mops
+				<< std::setw(10) << std::setprecision(1) << mops / double(threads)
+				<< std::setw(10) << latency.percentile(0.5)
+				<< std::setw(10) << latency.percentile(0.99)
+				<< std::setw(10) << latency.percentile(0.999);
+			if constexpr (kOp == atomic_op::kCasLoop)
+				std::cout << std::setw(10) << std::setprecision(3) << double(cas_retries_throughput) / double(kOpsPerThread * threads);
+			std::cout << "\n";
+		}
+
+		template<atomic_op kOp>
+		void sweep_contention()
+		{
+			std::cout << "\n" << atomic_op_name(kOp) << "\n";
+			std::cout << "\t" << std::setw(9) << "placement" << std::setw(9) << "threads"
+				<< std::setw(12) << "Mops/s" << std::setw(10) << "/thread"
+				<< std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(10) << "p99.9 ns";
+			if constexpr (kOp == atomic_op::kCasLoop)
+				std::cout << std::setw(10) << "retry/op";
+			std::cout << "\n" << std::fixed;
+
+			for (auto policy : { placement::kCompact, placement::kScatter, placement::kNone })
+			{
+				for (auto threads : thread_count_sweep())
+				{
+					worker_pool pool{ threads, policy };
+					run_contention<kOp>(pool, policy);
+				}
+			}
+		}
+	}
+
+	void test_atomic_contention()
+	{
+		std::cout << "atomic RMW contention, " << kOpsPerThread << " ops per thread, "
+			<< kLatencySamplesPerThread << " latency samples per thread (rdtsc overhead of " << rdtsc_overhead() << " ticks removed)\n";
+
+		sweep_contention<atomic_op::kFetchAddRelaxed>();
+		sweep_contention<atomic_op::kFetchAddSeqCst>();
+		sweep_contention<atomic_op::kCasLoop>();
+		sweep_contention<atomic_op::kExchange>();
+		sweep_contention<atomic_op::kStoreRelaxed>();
+		sweep_contention<atomic_op::kStoreRelease>();
+		sweep_contention<atomic_op::kStoreSeqCst>();
+		sweep_contention<atomic_op::kLoadRelaxed>();
+		sweep_contention<atomic_op::kLoadAcquire>();
+		sweep_contention<atomic_op::kLoadSeqCst>();
+		sweep_contention<atomic_op::kShardedPadded>();
+		sweep_contention<atomic_op::kShardedFalseSharing>();
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "hayai/hayai.hpp"
+#include "core_clock.h"
+
+// a hayai clock probe on top of system_info::core_clock, so that every benchmark result comes with the effective
+// frequency it ran at and its cycles per iteration.
+// usage:
+// static perf::core_clock_probe probe;
+// if (probe.open() != system_info::clock_source::kNone)
+//     hayai::Benchmarker::SetClockProbe(&probe);
+namespace perf
+{
+    class core_clock_probe : public hayai::ClockProbe
+    {
+    public:
+        system_info::clock_source open()
+        {
+            return _clock.open();
+        }
+
+        void Start() override
+        {
+            _valid = _clock.read(_start);
+        }
+
+        void Stop() override
+        {
+            _valid = _valid && _clock.read(_end);
+        }
+
+        bool Read(uint64_t& cycles, uint64_t& activeTime) const override
+        {
+            return _valid && system_info::clock_elapsed(_start, _end, cycles, activeTime);
+        }
+
+    private:
+        system_info::core_clock _clock;
+        system_info::clock_reading _start;
+        system_info::clock_reading _end;
+        bool _valid = false;
+    };
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perfutils.h"
+
+// what the core clock of the calling thread is up to: how many cycles it has run for, and for how many nanoseconds it
+// has actually been running, so that cycles / ns is the effective frequency with turbo and throttling included.
+// read through perf_event (cycles and task-clock, which follow the thread from CPU to CPU) or, where that isn't
+// allowed, the APERF/MPERF MSRs of whichever CPU we're on via /dev/cpu/N/msr (which only makes sense for a pinned
+// thread, and needs the msr module and read access to it).
+// usage:
+// system_info::core_clock clock;
+// system_info::clock_reading start, end;
+// if (clock.open() != system_info::clock_source::kNone && clock.read(start))
+// {
+//     ...work...
+//     uint64_t cycles, active_ns;
+//     if (clock.read(end) && system_info::clock_elapsed(start, end, cycles, active_ns))
+//         std::cout << double(cycles) / double(active_ns) << " GHz\n";
+// }
+namespace system_info
+{
+    enum class clock_source
+    {
+        kNone,
+        kPerfEvent,
+        kMsr,
+    };
+
+    inline const char* clock_source_name(clock_source source)
+    {
+        switch (source)
+        {
+        case clock_source::kPerfEvent: return "perf_event";
+        case clock_source::kMsr: return "APERF/MPERF";
+        default: return "none";
+        }
+    }
+
+    // cumulative counts; only the difference between two readings means anything
+    struct clock_reading
+    {
+        uint64_t _cycles = 0;
+        uint64_t _active_ns = 0;
+        // the CPU whose MSRs were read, or ~0u for perf_event readings which aren't tied to a CPU
+        unsigned _cpu = ~0u;
+    };
+
+    // what happened between two readings; false if there's nothing sensible to say, e.g. if the thread moved to
+    // another CPU in between MSR readings
+    inline bool clock_elapsed(const clock_reading& start, const clock_reading& end, uint64_t& cycles, uint64_t& active_ns)
+    {
+        if (start._cpu != end._cpu || end._cycles < start._cycles || end._active_ns <= start._active_ns)
+            return false;
+        cycles = end._cycles - start._cycles;
+        active_ns = end._active_ns - start._active_ns;
+        return true;
+    }
+
+    // the counters belong to the thread that opened them; reading them from any other thread, including the main
+    // thread of a forked child, quietly reopens them for that thread first
+    class core_clock
+    {
+    public:
+        core_clock() = default;
+        core_clock(const core_clock&) = delete;
+        core_clock& operator=(const core_clock&) = delete;
+
+        ~core_clock()
+        {
+            close();
+        }
+
+        // perf_event first, then the MSRs
+        clock_source open()
+        {
+            close();
+#if defined(__linux__)
+            _tid = current_tid();
+            if (open_perf_event(false) || open_perf_event(true))
+                _source = clock_source::kPerfEvent;
+            else
+            {
+                clock_reading reading;
+                _source = clock_source::kMsr;
+                if (!read_msrs(reading))
+                {
+                    close();
+                    _source = clock_source::kNone;
+                }
+            }
+#endif
+            return _source;
+        }
+
+        void close()
+        {
+#if defined(__linux__)
+            for (auto fd : { _cycles_fd, _task_clock_fd })
+            {
+                if (fd >= 0)
+                    ::close(fd);
+            }
+            for (auto fd : _msr_fds)
+            {
+                if (fd >= 0)
+                    ::close(fd);
+            }
+#endif
+            _cycles_fd = _task_clock_fd = -1;
+            _msr_fds.clear();
+            _source = clock_source::kNone;
+        }
+
+        clock_source source() const
+        {
+            return _source;
+        }
+
+        bool read(clock_reading& reading)
+        {
+#if defined(__linux__)
+            if (_source != clock_source::kNone && _tid != current_tid())
+                open();
+            switch (_source)
+            {
+            case clock_source::kPerfEvent:
+                return read_perf_event(reading);
+            case clock_source::kMsr:
+                return read_msrs(reading);
+            default:
+                break;
+            }
+#else
+            (void)reading;
+#endif
+            return false;
+        }
+
+    private:
+        clock_source _source = clock_source::kNone;
+        int _cycles_fd = -1;
+        int _task_clock_fd = -1;
+        // by CPU, opened as we get to them
+        std::vector<int> _msr_fds;
+        long _tid = 0;
+
+#if defined(__linux__)
+        static constexpr uint32_t kMsrMPerf = 0xe7;
+        static constexpr uint32_t kMsrAPerf = 0xe8;
+
+        static long current_tid()
+        {
+            return long(syscall(SYS_gettid));
+        }
+
+        static int open_counter(uint32_t type, uint64_t config, bool exclude_kernel)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.exclude_kernel = exclude_kernel;
+            attr.exclude_hv = 1;
+            // if the PMU is oversubscribed the kernel multiplexes and we scale by how long we were actually counting
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        // user-only counting is all that perf_event_paranoid 2 allows
+        bool open_perf_event(bool exclude_kernel)
+        {
+            _cycles_fd = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, exclude_kernel);
+            _task_clock_fd = open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, exclude_kernel);
+            if (_cycles_fd >= 0 && _task_clock_fd >= 0)
+                return true;
+            for (auto fd : { _cycles_fd, _task_clock_fd })
+            {
+                if (fd >= 0)
+                    ::close(fd);
+            }
+            _cycles_fd = _task_clock_fd = -1;
+            return false;
+        }
+
+        static bool read_counter(int fd, uint64_t& value)
+        {
+            // value, time enabled, time running
+            uint64_t values[3];
+            if (::read(fd, values, sizeof(values)) != ssize_t(sizeof(values)) || !values[2])
+                return false;
+            value = values[2] == values[1] ? values[0] : uint64_t(double(values[0]) * double(values[1]) / double(values[2]));
+            return true;
+        }
+
+        bool read_perf_event(clock_reading& reading)
+        {
+            reading._cpu = ~0u;
+            return read_counter(_cycles_fd, reading._cycles) && read_counter(_task_clock_fd, reading._active_ns);
+        }
+
+        // APERF counts at the actual clock and MPERF at the TSC rate, both only while the core is in C0
+        bool read_msrs(clock_reading& reading)
+        {
+            const auto cpu = sched_getcpu();
+            if (cpu < 0)
+                return false;
+            if (size_t(cpu) >= _msr_fds.size())
+                _msr_fds.resize(size_t(cpu) + 1, -1);
+            auto& fd = _msr_fds[size_t(cpu)];
+            if (fd < 0)
+                fd = ::open(("/dev/cpu/" + std::to_string(cpu) + "/msr").c_str(), O_RDONLY);
+            uint64_t aperf = 0, mperf = 0;
+            if (fd < 0
+                || pread(fd, &aperf, sizeof(aperf), kMsrAPerf) != ssize_t(sizeof(aperf))
+                || pread(fd, &mperf, sizeof(mperf), kMsrMPerf) != ssize_t(sizeof(mperf)))
+                return false;
+            reading._cpu = unsigned(cpu);
+            reading._cycles = aperf;
+            reading._active_ns = uint64_t(double(mperf) / perf::tsc_ticks_per_ns());
+            return true;
+        }
+#endif
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "cpu_set_context.h"
+
+// hayai execution contexts that pin the benchmarking thread to one P-core or one E-core, so that on hybrid parts
+// each benchmark gets a result per core type instead of a bimodal mix of whatever the scheduler picked.
+// usage:
+// if (!perf::add_core_type_contexts()) ...not a hybrid part
+// hayai::Benchmarker::RunAllTests();
+namespace perf
+{
+    // register one context per core type, each pinned to the first logical processor of that type (preferring
+    // hw thread 0 of a core so an idle sibling doesn't matter).
+    // returns false, and registers nothing, unless there are both P- and E-cores available to us
+    inline bool add_core_type_contexts()
+    {
+        static std::vector<std::unique_ptr<cpu_set_context>> _contexts;
+        if (!_contexts.empty())
+            return true;
+
+        std::vector<std::unique_ptr<cpu_set_context>> contexts;
+        for (auto type : { system_info::core_type::kPerformance, system_info::core_type::kEfficient })
+        {
+            const system_info::logical_processor* pick = nullptr;
+            for (const auto& lp : system_info::topology())
+            {
+                if (lp._core_type != type)
+                    continue;
+                if (!pick || (pick->_smt_id && !lp._smt_id))
+                    pick = &lp;
+            }
+            if (!pick)
+                return false;
+            contexts.emplace_back(new cpu_set_context(system_info::core_type_name(type), { pick->_os_index }));
+        }
+
+        _contexts = std::move(contexts);
+        for (auto& context : _contexts)
+            hayai::Benchmarker::AddExecutionContext(*context);
+        return true;
+    }
+}
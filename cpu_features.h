@@ -0,0 +1,258 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+#include "cpuid.h"
+
+namespace system_info
+{
+    // bit positions in features; add to the end, before kCount, and to feature_name
+    enum class feature : unsigned
+    {
+        // SIMD; the AVX family is only reported if the OS also saves the register state (XCR0)
+        kSSE,
+        kSSE2,
+        kSSE3,
+        kSSSE3,
+        kSSE41,
+        kSSE42,
+        kPOPCNT,
+        kAVX,
+        kF16C,
+        kFMA,
+        kAVX2,
+        kAVX512F,
+        kAVX512DQ,
+        kAVX512CD,
+        kAVX512BW,
+        kAVX512VL,
+        kAVX512IFMA,
+        kAVX512VBMI,
+        kAVX512VBMI2,
+        kAVX512VNNI,
+        kAVX512BITALG,
+        kAVX512VPOPCNTDQ,
+        // bit manipulation
+        kBMI1,
+        kBMI2,
+        kLZCNT,
+        // timing
+        kTSC,
+        kRDTSCP,
+        // TSC runs at a constant rate in all P-, C- and T-states
+        kInvariantTSC,
+        // umonitor/umwait/tpause
+        kWaitPkg,
+        kMovDiri,
+        kMovDir64B,
+        // topology and platform
+        kHTT,
+        // mixed core types (P and E cores)
+        kHybrid,
+        // Resource Director Technology; cache/bandwidth monitoring and allocation (CAT/MBA)
+        kRDTMonitoring,
+        kRDTAllocation,
+
+        kCount
+    };
+
+    static_assert(unsigned(feature::kCount) <= 64, "features is a 64 bit set");
+
+    // a set of CPU features. Everything is constexpr so required feature sets can be spelled out at compile time:
+    // constexpr auto kNeeds = features{} | feature::kAVX2 | feature::kFMA;
+    // if (cpu_features().has_all(kNeeds)) ...
+    class features
+    {
+    public:
+        constexpr features() = default;
+
+        constexpr explicit features(uint64_t bits)
+            : _bits(bits)
+        {
+        }
+
+        constexpr bool has(feature f) const
+        {
+            return (_bits >> unsigned(f)) & 1;
+        }
+
+        constexpr bool has_all(features required) const
+        {
+            return (_bits & required._bits) == required._bits;
+        }
+
+        constexpr features& set(feature f, bool on = true)
+        {
+            if (on)
+                _bits |= uint64_t(1) << unsigned(f);
+            else
+                _bits &= ~(uint64_t(1) << unsigned(f));
+            return *this;
+        }
+
+        constexpr features operator|(feature f) const
+        {
+            return features{ _bits | (uint64_t(1) << unsigned(f)) };
+        }
+
+        constexpr features operator|(features other) const
+        {
+            return features{ _bits | other._bits };
+        }
+
+        constexpr features operator&(features other) const
+        {
+            return features{ _bits & other._bits };
+        }
+
+        constexpr bool operator==(features other) const
+        {
+            return _bits == other._bits;
+        }
+
+        constexpr bool operator!=(features other) const
+        {
+            return _bits != other._bits;
+        }
+
+        constexpr uint64_t bits() const
+        {
+            return _bits;
+        }
+
+    private:
+        uint64_t _bits = 0;
+    };
+
+    inline const char* feature_name(feature f)
+    {
+        static const char* const _names[] = {
+            "sse", "sse2", "sse3", "ssse3", "sse4.1", "sse4.2", "popcnt", "avx", "f16c", "fma", "avx2",
+            "avx512f", "avx512dq", "avx512cd", "avx512bw", "avx512vl", "avx512ifma", "avx512vbmi", "avx512vbmi2",
+            "avx512vnni", "avx512bitalg", "avx512vpopcntdq",
+            "bmi1", "bmi2", "lzcnt",
+            "tsc", "rdtscp", "invariant_tsc",
+            "waitpkg", "movdiri", "movdir64b",
+            "htt", "hybrid", "rdt_m", "rdt_a",
+        };
+        static_assert(sizeof(_names) / sizeof(_names[0]) == size_t(feature::kCount), "feature_name is out of sync with feature");
+        return unsigned(f) < unsigned(feature::kCount) ? _names[unsigned(f)] : "?";
+    }
+
+    namespace detail
+    {
+        // XCR0; which register state the OS saves on a context switch. Only valid if cpuid reports OSXSAVE.
+        inline uint64_t xgetbv0()
+        {
+#ifdef _WIN32
+            return _xgetbv(0);
+#else
+            uint32_t eax, edx;
+            __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (uint64_t(edx) << 32) | eax;
+#endif
+        }
+
+        inline features decode_features()
+        {
+            features f;
+            cpuid cpu_id{ 0 };
+            const auto max_leaf = cpu_id.eax();
+
+            cpu_id = 1;
+            const auto bit = [&cpu_id](cpuid::regs r, unsigned b) { return cpu_id.bits_set(r, 1u << b); };
+            f.set(feature::kTSC, bit(cpuid::regs::edx, 4));
+            f.set(feature::kSSE, bit(cpuid::regs::edx, 25));
+            f.set(feature::kSSE2, bit(cpuid::regs::edx, 26));
+            f.set(feature::kHTT, bit(cpuid::regs::edx, 28));
+            f.set(feature::kSSE3, bit(cpuid::regs::ecx, 0));
+            f.set(feature::kSSSE3, bit(cpuid::regs::ecx, 9));
+            f.set(feature::kSSE41, bit(cpuid::regs::ecx, 19));
+            f.set(feature::kSSE42, bit(cpuid::regs::ecx, 20));
+            f.set(feature::kPOPCNT, bit(cpuid::regs::ecx, 23));
+
+            // XMM | YMM, and for AVX-512 also opmask | ZMM_Hi256 | Hi16_ZMM
+            const auto xcr0 = bit(cpuid::regs::ecx, 27) ? xgetbv0() : 0;
+            const auto ymm_state = (xcr0 & 0x6) == 0x6;
+            const auto zmm_state = (xcr0 & 0xe6) == 0xe6;
+            f.set(feature::kAVX, ymm_state && bit(cpuid::regs::ecx, 28));
+            f.set(feature::kF16C, ymm_state && bit(cpuid::regs::ecx, 29));
+            f.set(feature::kFMA, ymm_state && bit(cpuid::regs::ecx, 12));
+
+            if (max_leaf >= 7)
+            {
+                cpu_id = std::make_pair(7, 0);
+                f.set(feature::kBMI1, bit(cpuid::regs::ebx, 3));
+                f.set(feature::kAVX2, ymm_state && bit(cpuid::regs::ebx, 5));
+                f.set(feature::kBMI2, bit(cpuid::regs::ebx, 8));
+                f.set(feature::kRDTMonitoring, bit(cpuid::regs::ebx, 12));
+                f.set(feature::kRDTAllocation, bit(cpuid::regs::ebx, 15));
+                f.set(feature::kAVX512F, zmm_state && bit(cpuid::regs::ebx, 16));
+                f.set(feature::kAVX512DQ, zmm_state && bit(cpuid::regs::ebx, 17));
+                f.set(feature::kAVX512IFMA, zmm_state && bit(cpuid::regs::ebx, 21));
+                f.set(feature::kAVX512CD, zmm_state && bit(cpuid::regs::ebx, 28));
+                f.set(feature::kAVX512BW, zmm_state && bit(cpuid::regs::ebx, 30));
+                f.set(feature::kAVX512VL, zmm_state && bit(cpuid::regs::ebx, 31));
+                f.set(feature::kAVX512VBMI, zmm_state && bit(cpuid::regs::ecx, 1));
+                f.set(feature::kWaitPkg, bit(cpuid::regs::ecx, 5));
+                f.set(feature::kAVX512VBMI2, zmm_state && bit(cpuid::regs::ecx, 6));
+                f.set(feature::kAVX512VNNI, zmm_state && bit(cpuid::regs::ecx, 11));
+                f.set(feature::kAVX512BITALG, zmm_state && bit(cpuid::regs::ecx, 12));
+                f.set(feature::kAVX512VPOPCNTDQ, zmm_state && bit(cpuid::regs::ecx, 14));
+                f.set(feature::kMovDiri, bit(cpuid::regs::ecx, 27));
+                f.set(feature::kMovDir64B, bit(cpuid::regs::ecx, 28));
+                f.set(feature::kHybrid, bit(cpuid::regs::edx, 15));
+            }
+
+            cpu_id = int(0x80000000);
+            const auto max_ext_leaf = cpu_id.eax();
+            if (max_ext_leaf >= 0x80000001)
+            {
+                cpu_id = int(0x80000001);
+                f.set(feature::kLZCNT, bit(cpuid::regs::ecx, 5));
+                f.set(feature::kRDTSCP, bit(cpuid::regs::edx, 27));
+            }
+            if (max_ext_leaf >= 0x80000007)
+            {
+                cpu_id = int(0x80000007);
+                f.set(feature::kInvariantTSC, bit(cpuid::regs::edx, 8));
+            }
+            return f;
+        }
+    }
+
+    // the features of the processor we're running on, decoded on first use
+    inline const features& cpu_features()
+    {
+        static const features _features = detail::decode_features();
+        return _features;
+    }
+
+    // the processor brand string (cpuid leaves 0x80000002-4), e.g. "Intel(R) Core(TM) i9-12900K", or empty
+    inline std::string cpu_brand()
+    {
+        cpuid cpu_id{ int(0x80000000) };
+        if (cpu_id.eax() < 0x80000004)
+            return {};
+        char brand[49] = {};
+        for (int leaf = 0; leaf < 3; ++leaf)
+        {
+            cpu_id = int(0x80000002 + leaf);
+            memcpy(brand + leaf * 16 + 0, &cpu_id.eax(), 4);
+            memcpy(brand + leaf * 16 + 4, &cpu_id.ebx(), 4);
+            memcpy(brand + leaf * 16 + 8, &cpu_id.ecx(), 4);
+            memcpy(brand + leaf * 16 + 12, &cpu_id.edx(), 4);
+        }
+        std::string name{ brand };
+        name.erase(0, name.find_first_not_of(' '));
+        name.erase(name.find_last_not_of(' ') + 1);
+        return name;
+    }
+}
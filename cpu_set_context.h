@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "hayai/hayai.hpp"
+#include "topology.h"
+
+// hayai execution contexts that confine the benchmarking thread, and any threads it starts, to a set of logical
+// processors; used to pin benchmarks to a core type, to give each parallel shard (--jobs) cores of its own, and to
+// keep both sides of a paired comparison on one CPU.
+// usage:
+// runner.ShardContexts = perf::core_shard_contexts(runner.Jobs);
+// runner.Run();
+namespace perf
+{
+    class cpu_set_context : public hayai::ExecutionContext
+    {
+    public:
+        cpu_set_context(std::string name, std::vector<unsigned> os_indices)
+            : _name(std::move(name))
+            , _os_indices(std::move(os_indices))
+        {
+        }
+
+        std::string Name() const override
+        {
+            return _name;
+        }
+
+        bool Enter() override
+        {
+#if defined(_WIN32)
+            DWORD_PTR mask = 0;
+            for (auto os_index : _os_indices)
+                mask |= DWORD_PTR(1) << os_index;
+            _previous = SetThreadAffinityMask(GetCurrentThread(), mask);
+            return _previous != 0;
+#elif defined(__linux__)
+            pthread_getaffinity_np(pthread_self(), sizeof(_previous), &_previous);
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (auto os_index : _os_indices)
+                CPU_SET(os_index, &set);
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            return false;
+#endif
+        }
+
+        void Leave() override
+        {
+#if defined(_WIN32)
+            SetThreadAffinityMask(GetCurrentThread(), _previous);
+#elif defined(__linux__)
+            pthread_setaffinity_np(pthread_self(), sizeof(_previous), &_previous);
+#endif
+        }
+
+    private:
+        std::string _name;
+        std::vector<unsigned> _os_indices;
+#if defined(_WIN32)
+        DWORD_PTR _previous = 0;
+#elif defined(__linux__)
+        cpu_set_t _previous;
+#endif
+    };
+
+    // a context pinned to a single logical processor, hw thread 0 of the first core we're allowed on, so that
+    // whatever runs in it always sees the same core and caches; the context lives until the program exits
+    inline hayai::ExecutionContext* single_cpu_context()
+    {
+        static std::unique_ptr<cpu_set_context> _context;
+        if (_context)
+            return _context.get();
+
+        const system_info::logical_processor* pick = nullptr;
+        for (const auto& lp : system_info::topology())
+        {
+            if (!pick || (pick->_smt_id && !lp._smt_id))
+                pick = &lp;
+        }
+        if (!pick)
+            return nullptr;
+        _context.reset(new cpu_set_context("cpu " + std::to_string(pick->_os_index), { pick->_os_index }));
+        return _context.get();
+    }
+
+    // split the physical cores we're allowed to run on into up to count shards of whole cores, i.e. every hw thread
+    // of a core goes to the same shard, so no shard ever shares a core with another. cores are taken in
+    // (package, L3, core) order and handed out in contiguous runs so that a shard stays within one L3 if it can.
+    // returns fewer shards than asked for if there aren't enough cores; the contexts live until the program exits
+    inline std::vector<hayai::ExecutionContext*> core_shard_contexts(size_t count)
+    {
+        static std::vector<std::unique_ptr<cpu_set_context>> _contexts;
+
+        std::vector<system_info::logical_processor> procs = system_info::topology();
+        std::sort(procs.begin(), procs.end(), [](const auto& a, const auto& b) {
+            return std::make_tuple(a._package_id, a._l3_id, a._core_id, a._smt_id) < std::make_tuple(b._package_id, b._l3_id, b._core_id, b._smt_id);
+        });
+
+        // the hw threads of each core
+        std::vector<std::vector<unsigned>> cores;
+        for (size_t n = 0; n < procs.size(); ++n)
+        {
+            if (!n || procs[n]._package_id != procs[n - 1]._package_id || procs[n]._core_id != procs[n - 1]._core_id)
+                cores.emplace_back();
+            cores.back().push_back(procs[n]._os_index);
+        }
+
+        count = std::min(count, cores.size());
+        std::vector<hayai::ExecutionContext*> shards;
+        for (size_t shard = 0, first = 0; shard < count; ++shard)
+        {
+            // the first cores.size() % count shards get one extra core
+            const size_t last = first + cores.size() / count + (shard < cores.size() % count ? 1 : 0);
+            std::vector<unsigned> os_indices;
+            std::string name = "shard " + std::to_string(shard) + ": cpu";
+            for (; first < last; ++first)
+            {
+                for (auto os_index : cores[first])
+                {
+                    name += (os_indices.empty() ? " " : ",") + std::to_string(os_index);
+                    os_indices.push_back(os_index);
+                }
+            }
+            _contexts.emplace_back(new cpu_set_context(std::move(name), std::move(os_indices)));
+            shards.push_back(_contexts.back().get());
+        }
+        return shards;
+    }
+}
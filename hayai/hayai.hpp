@@ -8,6 +8,11 @@
 #include "hayai_console_outputter.hpp"
 #include "hayai_json_outputter.hpp"
 #include "hayai_junit_xml_outputter.hpp"
+#include "hayai_baseline_outputter.hpp"
+#include "hayai_binary_outputter.hpp"
+#include "hayai_binary_reader.hpp"
+#include "hayai_trace_outputter.hpp"
+#include "hayai_openmetrics_outputter.hpp"
 
 
 #define HAYAI_VERSION "1.0.1"
@@ -132,5 +137,172 @@
 #define BENCHMARK_P_INSTANCE(fixture_name, benchmark_name, arguments)   \
     BENCHMARK_P_INSTANCE1(fixture_name, benchmark_name, arguments, BENCHMARK_P_ID_)
 
+// Range benchmarks, fitted to complexities. Sizes go from low, at least 1, to
+// high, at least low, by multiplier; see Benchmarker::RegisterRange.
+#define BENCHMARK_RANGE_(fixture_name,                                  \
+                         benchmark_name,                                \
+                         fixture_class_name,                            \
+                         runs,                                          \
+                         iterations,                                    \
+                         low,                                           \
+                         high,                                          \
+                         multiplier)                                    \
+    class BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)           \
+        :   public fixture_class_name                                   \
+    {                                                                   \
+    public:                                                             \
+        BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)(std::size_t n) \
+            :   _n(n)                                                   \
+        {                                                               \
+                                                                        \
+        }                                                               \
+    protected:                                                          \
+        virtual void TestBody()                                         \
+        {                                                               \
+            TestPayload(_n);                                            \
+        }                                                               \
+                                                                        \
+        inline void TestPayload(std::size_t n);                         \
+    private:                                                            \
+        std::size_t _n;                                                 \
+        static const ::hayai::RangeDescriptor* _range;                  \
+    };                                                                  \
+                                                                        \
+    const ::hayai::RangeDescriptor*                                     \
+    BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)::_range =       \
+        ::hayai::Benchmarker::RegisterRange<                            \
+            BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)         \
+        >(                                                              \
+            #fixture_name,                                              \
+            #benchmark_name,                                            \
+            runs,                                                       \
+            iterations,                                                 \
+            low,                                                        \
+            high,                                                       \
+            multiplier);                                                \
+                                                                        \
+    void BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)::TestPayload( \
+        std::size_t n)
+
+#define BENCHMARK_RANGE_F(fixture_name,                  \
+                          benchmark_name,                \
+                          runs,                          \
+                          iterations,                    \
+                          low,                           \
+                          high,                          \
+                          multiplier)                    \
+    BENCHMARK_RANGE_(fixture_name,                       \
+                     benchmark_name,                     \
+                     fixture_name,                       \
+                     runs,                               \
+                     iterations,                         \
+                     low,                                \
+                     high,                               \
+                     multiplier)
+
+#define BENCHMARK_RANGE(fixture_name,                    \
+                        benchmark_name,                  \
+                        runs,                            \
+                        iterations,                      \
+                        low,                             \
+                        high,                            \
+                        multiplier)                      \
+    BENCHMARK_RANGE_(fixture_name,                       \
+                     benchmark_name,                     \
+                     ::hayai::Test,                      \
+                     runs,                               \
+                     iterations,                         \
+                     low,                                \
+                     high,                               \
+                     multiplier)
+
+#define BENCHMARK_RANGE_COMPLEXITY_NAME_(fixture_name, benchmark_name)  \
+    fixture_name ## _ ## benchmark_name ## _Complexity
+
+#define BENCHMARK_RANGE_COMPLEXITY(fixture_name,                        \
+                                   benchmark_name,                      \
+                                   complexity)                          \
+    static const ::hayai::RangeDescriptor*                              \
+    BENCHMARK_RANGE_COMPLEXITY_NAME_(fixture_name, benchmark_name) =    \
+        ::hayai::Benchmarker::SetRangeComplexity(                       \
+            #fixture_name,                                              \
+            #benchmark_name,                                            \
+            complexity)
+
+// Typed benchmarks, one per type of a type list.
+#define BENCHMARK_T_(fixture_name,                                      \
+                     benchmark_name,                                    \
+                     fixture_class_name,                                \
+                     runs,                                              \
+                     iterations,                                        \
+                     ...)                                               \
+    template<class TypeParam>                                           \
+    class BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)           \
+        :   public fixture_class_name                                   \
+    {                                                                   \
+    protected:                                                          \
+        virtual void TestBody();                                        \
+    };                                                                  \
+                                                                        \
+    static const std::size_t                                            \
+    BENCHMARK_TYPED_NAME_(fixture_name, benchmark_name) =               \
+        ::hayai::Benchmarker::RegisterTyped<                            \
+            BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)         \
+        >(                                                              \
+            #fixture_name,                                              \
+            #benchmark_name,                                            \
+            runs,                                                       \
+            iterations,                                                 \
+            __VA_ARGS__());                                             \
+                                                                        \
+    template<class TypeParam>                                           \
+    void BENCHMARK_CLASS_NAME_(fixture_name, benchmark_name)<TypeParam>:: \
+        TestBody()
+
+#define BENCHMARK_TYPED_NAME_(fixture_name, benchmark_name)             \
+    fixture_name ## _ ## benchmark_name ## _Types
+
+#define BENCHMARK_T_F(fixture_name,                      \
+                      benchmark_name,                    \
+                      runs,                              \
+                      iterations,                        \
+                      ...)                               \
+    BENCHMARK_T_(fixture_name,                           \
+                 benchmark_name,                         \
+                 fixture_name,                           \
+                 runs,                                   \
+                 iterations,                             \
+                 __VA_ARGS__)
+
+#define BENCHMARK_T(fixture_name,                        \
+                    benchmark_name,                      \
+                    runs,                                \
+                    iterations,                          \
+                    ...)                                 \
+    BENCHMARK_T_(fixture_name,                           \
+                 benchmark_name,                         \
+                 ::hayai::Test,                          \
+                 runs,                                   \
+                 iterations,                             \
+                 __VA_ARGS__)
+
+// Paired comparisons.
+#define BENCHMARK_COMPARISON_NAME_(fixture_name,                        \
+                                   baseline_name,                       \
+                                   candidate_name)                      \
+    fixture_name ## _ ## baseline_name ## _ ## candidate_name ## _Comparison
+
+#define BENCHMARK_COMPARE(fixture_name,                                 \
+                          baseline_name,                                \
+                          candidate_name)                               \
+    static const ::hayai::ComparisonDescriptor*                         \
+    BENCHMARK_COMPARISON_NAME_(fixture_name,                            \
+                               baseline_name,                           \
+                               candidate_name) =                        \
+        ::hayai::Benchmarker::Instance().RegisterComparison(            \
+            #fixture_name,                                              \
+            #baseline_name,                                             \
+            #candidate_name)
+
 
 #endif
@@ -0,0 +1,438 @@
+#ifndef __HAYAI_ASYNCOUTPUTTER
+#define __HAYAI_ASYNCOUTPUTTER
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "hayai_outputter.hpp"
+
+
+namespace hayai
+{
+    /// Asynchronous outputter.
+
+    /// Forwards every call to a set of outputters on a dedicated I/O thread,
+    /// so console coloring, file I/O and formatting happen off the
+    /// benchmarking thread instead of between its measurements.
+    ///
+    /// Calls are queued as records in a fixed ring shared by the two threads
+    /// alone. The benchmarking thread copies the arguments into the next
+    /// free record and publishes it with a single store; records, and the
+    /// buffers in them, are reused, so once the ring has gone round there is
+    /// nothing left to allocate. The I/O thread is not pinned, and sleeps
+    /// while there is nothing to output rather than competing with the
+    /// benchmarks for a core.
+    ///
+    /// @ref End waits for the I/O thread to finish, so all output has been
+    /// written when it returns. Outputters that have to be called on the
+    /// benchmarking thread, see @ref Outputter::Synchronous, should not be
+    /// forwarded.
+    class AsyncOutputter
+        :   public Outputter
+    {
+    public:
+        /// Initialize asynchronous outputter.
+
+        /// @param outputters Outputters to forward to. Must exist for the
+        /// entire duration of the outputter's use.
+        AsyncOutputter(const std::vector<Outputter*>& outputters)
+            :   _outputters(outputters),
+                _records(Capacity),
+                _head(0),
+                _tail(0),
+                _stopping(false)
+        {
+
+        }
+
+
+        virtual ~AsyncOutputter()
+        {
+            Stop();
+        }
+
+
+        virtual void Begin(const std::size_t& enabledCount,
+                           const std::size_t& disabledCount)
+        {
+            if (!_thread.joinable())
+            {
+                _stopping.store(false, std::memory_order_relaxed);
+                _thread = std::thread(&AsyncOutputter::Drain, this);
+            }
+
+            Record& record = Acquire(RecordBegin);
+            record.First = enabledCount;
+            record.Second = disabledCount;
+            Publish();
+        }
+
+
+        virtual void End(const std::size_t& executedCount,
+                         const std::size_t& disabledCount)
+        {
+            Record& record = Acquire(RecordEnd);
+            record.First = executedCount;
+            record.Second = disabledCount;
+            Publish();
+
+            Stop();
+        }
+
+
+        virtual void Environment(const EnvironmentProperties& properties)
+        {
+            Record& record = Acquire(RecordEnvironment);
+            record.Environment = properties;
+            Publish();
+        }
+
+
+        virtual void BeginTest(const std::string& fixtureName,
+                               const std::string& testName,
+                               const TestParametersDescriptor& parameters,
+                               const std::size_t& runsCount,
+                               const std::size_t& iterationsCount)
+        {
+            Record& record = Acquire(RecordBeginTest);
+            SetTest(record, fixtureName, testName, parameters);
+            record.First = runsCount;
+            record.Second = iterationsCount;
+            Publish();
+        }
+
+
+        virtual void EndTest(const std::string& fixtureName,
+                             const std::string& testName,
+                             const TestParametersDescriptor& parameters,
+                             const TestResult& result)
+        {
+            Record& record = Acquire(RecordEndTest);
+            SetTest(record, fixtureName, testName, parameters);
+            record.Result = result;
+            Publish();
+        }
+
+
+        virtual void SkipDisabledTest(const std::string& fixtureName,
+                                      const std::string& testName,
+                                      const TestParametersDescriptor&
+                                          parameters,
+                                      const std::size_t& runsCount,
+                                      const std::size_t& iterationsCount)
+        {
+            Record& record = Acquire(RecordSkipDisabledTest);
+            SetTest(record, fixtureName, testName, parameters);
+            record.First = runsCount;
+            record.Second = iterationsCount;
+            Publish();
+        }
+
+
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            Record& record = Acquire(RecordFailTest);
+            SetTest(record, fixtureName, testName, parameters);
+            record.Context = context;
+            record.Text = reason;
+            Publish();
+        }
+
+
+        virtual void EndComparison(const std::string& fixtureName,
+                                   const std::string& baselineName,
+                                   const std::string& candidateName,
+                                   const ComparisonResult& result)
+        {
+            Record& record = Acquire(RecordEndComparison);
+            record.FixtureName = fixtureName;
+            record.TestName = baselineName;
+            record.Text = candidateName;
+            record.Comparison = result;
+            Publish();
+        }
+
+
+        virtual void EndComplexity(const std::string& fixtureName,
+                                   const std::string& testName,
+                                   const ComplexityResult& result)
+        {
+            Record& record = Acquire(RecordEndComplexity);
+            record.FixtureName = fixtureName;
+            record.TestName = testName;
+            record.Complexity = result;
+            Publish();
+        }
+    private:
+        enum
+        {
+            /// Number of records in the ring, a power of two.
+            Capacity = 64
+        };
+
+
+        /// Record types, one for each outputter call.
+        enum RecordType
+        {
+            RecordBegin,
+            RecordEnd,
+            RecordEnvironment,
+            RecordBeginTest,
+            RecordEndTest,
+            RecordSkipDisabledTest,
+            RecordFailTest,
+            RecordEndComparison,
+            RecordEndComplexity
+        };
+
+
+        /// Queued outputter call.
+
+        /// Holds the arguments of any of the calls; which of them are used
+        /// depends on the type.
+        struct Record
+        {
+            Record()
+                :   Type(RecordBegin),
+                    First(0),
+                    Second(0),
+                    Result(std::vector<uint64_t>(), 1),
+                    Comparison(std::vector<double>(),
+                               std::vector<double>(),
+                               std::string()),
+                    Complexity(std::vector<double>(),
+                               std::vector<double>())
+            {
+
+            }
+
+
+            RecordType Type;
+
+
+            /// Fixture name.
+            std::string FixtureName;
+
+
+            /// Test name, or baseline name for comparisons.
+            std::string TestName;
+
+
+            /// Test parameters.
+            TestParametersDescriptor Parameters;
+
+
+            /// Enabled, executed or runs count.
+            std::size_t First;
+
+
+            /// Disabled or iterations count.
+            std::size_t Second;
+
+
+            /// Failure reason, or candidate name for comparisons.
+            std::string Text;
+
+
+            /// Execution context name of a failed test.
+            std::string Context;
+
+
+            EnvironmentProperties Environment;
+            TestResult Result;
+            ComparisonResult Comparison;
+            ComplexityResult Complexity;
+        };
+
+
+        /// Next free record, waiting for the I/O thread if the ring is full.
+        Record& Acquire(RecordType type)
+        {
+            const uint64_t head = _head.load(std::memory_order_relaxed);
+
+            while (head - _tail.load(std::memory_order_acquire) >= Capacity)
+                std::this_thread::yield();
+
+            Record& record = _records[head & (Capacity - 1)];
+            record.Type = type;
+            return record;
+        }
+
+
+        /// Hand the acquired record to the I/O thread.
+        void Publish()
+        {
+            _head.store(_head.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_release);
+        }
+
+
+        static void SetTest(Record& record,
+                            const std::string& fixtureName,
+                            const std::string& testName,
+                            const TestParametersDescriptor& parameters)
+        {
+            record.FixtureName = fixtureName;
+            record.TestName = testName;
+            record.Parameters = parameters;
+        }
+
+
+        /// Wait for the I/O thread to output everything queued and exit.
+        void Stop()
+        {
+            if (!_thread.joinable())
+                return;
+
+            _stopping.store(true, std::memory_order_release);
+            _thread.join();
+        }
+
+
+        /// I/O thread.
+        void Drain()
+        {
+            Unpin();
+
+            while (true)
+            {
+                const uint64_t tail = _tail.load(std::memory_order_relaxed);
+
+                if (tail == _head.load(std::memory_order_acquire))
+                {
+                    if (_stopping.load(std::memory_order_acquire))
+                    {
+                        // Catch a record published just before stopping.
+                        if (tail == _head.load(std::memory_order_acquire))
+                            return;
+                        continue;
+                    }
+
+                    std::this_thread::sleep_for(
+                        std::chrono::milliseconds(1)
+                    );
+                    continue;
+                }
+
+                Dispatch(_records[tail & (Capacity - 1)]);
+                _tail.store(tail + 1, std::memory_order_release);
+            }
+        }
+
+
+        /// Make the calling thread eligible to run on any CPU.
+
+        /// Threads inherit the affinity of the thread that created them,
+        /// which is likely the benchmarking thread pinned to a core.
+        static void Unpin()
+        {
+#if defined(_WIN32)
+            DWORD_PTR processMask;
+            DWORD_PTR systemMask;
+
+            if (GetProcessAffinityMask(GetCurrentProcess(),
+                                       &processMask,
+                                       &systemMask))
+                SetThreadAffinityMask(GetCurrentThread(), processMask);
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                CPU_SET(cpu, &set);
+
+            // CPUs that are not available are left out by the kernel.
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+        }
+
+
+        void Dispatch(const Record& record)
+        {
+            for (std::size_t i = 0; i < _outputters.size(); ++i)
+            {
+                Outputter& outputter = *_outputters[i];
+
+                switch (record.Type)
+                {
+                case RecordBegin:
+                    outputter.Begin(record.First, record.Second);
+                    break;
+
+                case RecordEnd:
+                    outputter.End(record.First, record.Second);
+                    break;
+
+                case RecordEnvironment:
+                    outputter.Environment(record.Environment);
+                    break;
+
+                case RecordBeginTest:
+                    outputter.BeginTest(record.FixtureName,
+                                        record.TestName,
+                                        record.Parameters,
+                                        record.First,
+                                        record.Second);
+                    break;
+
+                case RecordEndTest:
+                    outputter.EndTest(record.FixtureName,
+                                      record.TestName,
+                                      record.Parameters,
+                                      record.Result);
+                    break;
+
+                case RecordSkipDisabledTest:
+                    outputter.SkipDisabledTest(record.FixtureName,
+                                               record.TestName,
+                                               record.Parameters,
+                                               record.First,
+                                               record.Second);
+                    break;
+
+                case RecordFailTest:
+                    outputter.FailTest(record.FixtureName,
+                                       record.TestName,
+                                       record.Parameters,
+                                       record.Context,
+                                       record.Text);
+                    break;
+
+                case RecordEndComparison:
+                    outputter.EndComparison(record.FixtureName,
+                                            record.TestName,
+                                            record.Text,
+                                            record.Comparison);
+                    break;
+
+                case RecordEndComplexity:
+                    outputter.EndComplexity(record.FixtureName,
+                                            record.TestName,
+                                            record.Complexity);
+                    break;
+                }
+            }
+        }
+
+
+        std::vector<Outputter*> _outputters;
+        std::vector<Record> _records;
+        std::atomic<uint64_t> _head;
+        std::atomic<uint64_t> _tail;
+        std::atomic<bool> _stopping;
+        std::thread _thread;
+    };
+}
+#endif
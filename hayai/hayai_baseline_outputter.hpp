@@ -0,0 +1,418 @@
+#ifndef __HAYAI_BASELINEOUTPUTTER
+#define __HAYAI_BASELINEOUTPUTTER
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hayai_outputter.hpp"
+#include "hayai_console.hpp"
+#include "hayai_json_reader.hpp"
+
+
+namespace hayai
+{
+    /// Baseline comparison outputter.
+
+    /// Compares every test against the same test in the output of an earlier
+    /// run by @ref JsonOutputter, matched by fixture, name and parameters, and
+    /// prints a summary once all tests have run.
+    ///
+    /// The iteration times of the two runs are compared with a two-sided
+    /// Mann-Whitney U test, which makes no assumptions about how the times
+    /// are distributed, so the odd outlier does not decide the outcome. The
+    /// change is that of the median iteration time. A test has regressed if it
+    /// is slower by more than the threshold and the difference is significant.
+    class BaselineOutputter
+        :   public Outputter
+    {
+    public:
+        /// Initialize baseline outputter.
+
+        /// @param stream Output stream. Must exist for the entire duration of
+        /// the outputter's use.
+        /// @param threshold Relative slowdown beyond which a significant
+        /// change is a regression, e.g. 0.05 for 5%.
+        /// @param significance Largest p-value for a change to be considered
+        /// significant.
+        BaselineOutputter(std::ostream& stream,
+                          double threshold = 0.05,
+                          double significance = 0.05)
+            :   _stream(stream),
+                _threshold(threshold),
+                _significance(significance),
+                _regressionCount(0)
+        {
+
+        }
+
+
+        /// Load the baseline.
+
+        /// @param path Path of a file written by @ref JsonOutputter.
+        /// @throws std::runtime_error if the file cannot be read or parsed.
+        void Load(const char* path)
+        {
+            const JsonValue root = JsonValue::ParseFile(path);
+            const JsonValue& benchmarks = root["benchmarks"];
+
+            if (benchmarks.GetType() != JsonValue::Array)
+                throw std::runtime_error(
+                    std::string(path) + ": not a hayai JSON result file"
+                );
+
+            _path = path;
+            _baseline.clear();
+
+            for (std::size_t i = 0; i < benchmarks.Size(); ++i)
+            {
+                const JsonValue& benchmark = benchmarks[i];
+                const JsonValue& runs = benchmark["runs"];
+                const double iterations =
+                    benchmark["iterations_per_run"].AsNumber();
+
+                if ((runs.GetType() != JsonValue::Array) ||
+                    (iterations <= 0.0))
+                    continue;
+
+                std::string key = benchmark["fixture"].AsString() + "." +
+                    benchmark["name"].AsString();
+                const JsonValue& parameters = benchmark["parameters"];
+                for (std::size_t p = 0; p < parameters.Size(); ++p)
+                    key += std::string(p ? ", " : "(") +
+                        parameters[p]["declaration"].AsString() + " = " +
+                        parameters[p]["value"].AsString();
+                if (parameters.Size())
+                    key += ")";
+
+                // Results from execution contexts are told apart by context.
+                if (!benchmark["context"].AsString().empty())
+                    key += " [" + benchmark["context"].AsString() + "]";
+
+                std::vector<double>& times = _baseline[key];
+                times.clear();
+                for (std::size_t r = 0; r < runs.Size(); ++r)
+                    times.push_back(runs[r]["duration"].AsNumber() *
+                                    1000000.0 / iterations);
+            }
+        }
+
+
+        /// Number of tests that regressed.
+        std::size_t RegressionCount() const
+        {
+            return _regressionCount;
+        }
+
+
+        virtual void Begin(const std::size_t& enabledCount,
+                           const std::size_t& disabledCount)
+        {
+            (void)enabledCount;
+            (void)disabledCount;
+
+            _comparisons.clear();
+            _regressionCount = 0;
+        }
+
+
+        virtual void End(const std::size_t& executedCount,
+                         const std::size_t& disabledCount)
+        {
+            (void)executedCount;
+            (void)disabledCount;
+
+            std::size_t improvementCount = 0;
+            std::size_t matchedCount = 0;
+
+            for (std::size_t i = 0; i < _comparisons.size(); ++i)
+            {
+                if (_comparisons[i].Matched)
+                    ++matchedCount;
+                if (_comparisons[i].Verdict == Improvement)
+                    ++improvementCount;
+            }
+
+            _stream << std::fixed
+                    << Console::TextGreen << "[ BASELINE ]"
+                    << Console::TextDefault << " Compared "
+                    << matchedCount
+                    << (matchedCount == 1 ? " benchmark" : " benchmarks")
+                    << " against " << _path << " (threshold "
+                    << std::setprecision(1) << (_threshold * 100.0)
+                    << " %, p < " << std::setprecision(3) << _significance
+                    << ")" << std::endl;
+
+            for (std::size_t i = 0; i < _comparisons.size(); ++i)
+                WriteComparison(_comparisons[i]);
+
+            _stream << Console::TextGreen << "[ BASELINE ]"
+                    << Console::TextDefault << " "
+                    << _regressionCount
+                    << (_regressionCount == 1 ?
+                        " regression, " :
+                        " regressions, ")
+                    << improvementCount
+                    << (improvementCount == 1 ?
+                        " improvement." :
+                        " improvements.")
+                    << std::endl;
+        }
+
+
+        virtual void BeginTest(const std::string& fixtureName,
+                               const std::string& testName,
+                               const TestParametersDescriptor& parameters,
+                               const std::size_t& runsCount,
+                               const std::size_t& iterationsCount)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)runsCount;
+            (void)iterationsCount;
+        }
+
+
+        virtual void SkipDisabledTest(const std::string& fixtureName,
+                                      const std::string& testName,
+                                      const TestParametersDescriptor&
+                                          parameters,
+                                      const std::size_t& runsCount,
+                                      const std::size_t& iterationsCount)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)runsCount;
+            (void)iterationsCount;
+        }
+
+
+        virtual void EndTest(const std::string& fixtureName,
+                             const std::string& testName,
+                             const TestParametersDescriptor& parameters,
+                             const TestResult& result)
+        {
+            std::stringstream name;
+            WriteTestNameToStream(name, fixtureName, testName, parameters);
+            if (!result.Context().empty())
+                name << " [" << result.Context() << "]";
+
+            Comparison comparison;
+            comparison.Name = name.str();
+
+            std::map<std::string, std::vector<double> >::const_iterator it =
+                _baseline.find(comparison.Name);
+
+            if ((it != _baseline.end()) && (!it->second.empty()) &&
+                (!result.RunTimes().empty()))
+            {
+                std::vector<double> times;
+                for (std::size_t r = 0; r < result.RunTimes().size(); ++r)
+                    times.push_back(double(result.RunTimes()[r]) /
+                                    double(result.Iterations()));
+
+                comparison.Matched = true;
+                comparison.BaselineMedian = Median(it->second);
+                comparison.Median = Median(times);
+                comparison.Change = (comparison.BaselineMedian > 0.0) ?
+                    (comparison.Median / comparison.BaselineMedian - 1.0) :
+                    0.0;
+                comparison.PValue = MannWhitneyU(it->second, times);
+
+                if (comparison.PValue < _significance)
+                {
+                    if (comparison.Change > _threshold)
+                        comparison.Verdict = Regression;
+                    else if (comparison.Change < -_threshold)
+                        comparison.Verdict = Improvement;
+                    else
+                        comparison.Verdict = (comparison.Change > 0.0) ?
+                            Slower :
+                            Faster;
+                }
+
+                if (comparison.Verdict == Regression)
+                    ++_regressionCount;
+            }
+
+            _comparisons.push_back(comparison);
+        }
+
+
+        /// Two-sided p-value of the Mann-Whitney U test.
+
+        /// Uses the normal approximation with continuity and tie corrections,
+        /// which is accurate enough from about 8 samples on each side.
+        ///
+        /// @param a First sample.
+        /// @param b Second sample.
+        /// @returns the probability of seeing a difference at least this
+        /// large if both samples came from the same distribution.
+        static double MannWhitneyU(const std::vector<double>& a,
+                                   const std::vector<double>& b)
+        {
+            const double na = double(a.size());
+            const double nb = double(b.size());
+            const double n = na + nb;
+
+            if ((a.empty()) || (b.empty()))
+                return 1.0;
+
+            // Rank the pooled samples, giving ties their average rank.
+            std::vector<std::pair<double, bool> > pooled;
+            for (std::size_t i = 0; i < a.size(); ++i)
+                pooled.push_back(std::make_pair(a[i], true));
+            for (std::size_t i = 0; i < b.size(); ++i)
+                pooled.push_back(std::make_pair(b[i], false));
+            std::sort(pooled.begin(), pooled.end());
+
+            double rankSumA = 0.0;
+            double tieTerm = 0.0;
+            std::size_t i = 0;
+
+            while (i < pooled.size())
+            {
+                std::size_t j = i;
+                while ((j < pooled.size()) &&
+                       (pooled[j].first == pooled[i].first))
+                    ++j;
+
+                const double ties = double(j - i);
+                const double rank = (double(i + 1) + double(j)) / 2.0;
+                for (std::size_t k = i; k < j; ++k)
+                    if (pooled[k].second)
+                        rankSumA += rank;
+
+                tieTerm += ties * ties * ties - ties;
+                i = j;
+            }
+
+            const double u = rankSumA - na * (na + 1.0) / 2.0;
+            const double mean = na * nb / 2.0;
+            const double variance = na * nb / 12.0 *
+                ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+
+            if (variance <= 0.0)
+                return 1.0;
+
+            const double z =
+                std::max(0.0, std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+
+            return std::erfc(z / std::sqrt(2.0));
+        }
+    private:
+        enum ComparisonVerdict
+        {
+            NoChange,
+            Slower,
+            Faster,
+            Regression,
+            Improvement
+        };
+
+
+        struct Comparison
+        {
+            Comparison()
+                :   Matched(false),
+                    BaselineMedian(0.0),
+                    Median(0.0),
+                    Change(0.0),
+                    PValue(1.0),
+                    Verdict(NoChange)
+            {
+
+            }
+
+
+            std::string Name;
+            bool Matched;
+            double BaselineMedian;
+            double Median;
+            double Change;
+            double PValue;
+            ComparisonVerdict Verdict;
+        };
+
+
+        void WriteComparison(const Comparison& comparison)
+        {
+            if (!comparison.Matched)
+            {
+                _stream << Console::TextCyan << "[   NEW    ]"
+                        << Console::TextYellow << " " << comparison.Name
+                        << Console::TextDefault << " (not in baseline)"
+                        << std::endl;
+                return;
+            }
+
+            switch (comparison.Verdict)
+            {
+            case Regression:
+                _stream << Console::TextRed << "[REGRESSION]";
+                break;
+
+            case Improvement:
+                _stream << Console::TextGreen << "[ IMPROVED ]";
+                break;
+
+            case Slower:
+                _stream << Console::TextPurple << "[  SLOWER  ]";
+                break;
+
+            case Faster:
+                _stream << Console::TextPurple << "[  FASTER  ]";
+                break;
+
+            default:
+                _stream << Console::TextBlue << "[   SAME   ]";
+                break;
+            }
+
+            _stream << Console::TextYellow << " " << comparison.Name
+                    << Console::TextDefault << " ("
+                    << std::setprecision(3)
+                    << comparison.BaselineMedian / 1000.0 << " us -> "
+                    << comparison.Median / 1000.0 << " us per iteration, "
+                    << (comparison.Verdict == Regression ?
+                        Console::TextRed :
+                        (comparison.Verdict == Improvement ?
+                         Console::TextGreen :
+                         Console::TextDefault))
+                    << (comparison.Change > 0.0 ? "+" : "")
+                    << std::setprecision(2) << comparison.Change * 100.0
+                    << " %" << Console::TextDefault << ", "
+                    << std::setprecision(1)
+                    << (1.0 - comparison.PValue) * 100.0
+                    << " % confidence)" << std::endl;
+        }
+
+
+        static double Median(std::vector<double> values)
+        {
+            std::sort(values.begin(), values.end());
+
+            const std::size_t half = values.size() / 2;
+
+            if ((values.size() % 2) == 0)
+                return (values[half - 1] + values[half]) / 2.0;
+
+            return values[half];
+        }
+
+
+        std::ostream& _stream;
+        double _threshold;
+        double _significance;
+        std::string _path;
+        std::map<std::string, std::vector<double> > _baseline;
+        std::vector<Comparison> _comparisons;
+        std::size_t _regressionCount;
+    };
+}
+#endif
@@ -8,16 +8,44 @@
 #include <random>
 #endif
 #include <string>
+#include <cstdlib>
 #include <cstring>
+#include <sstream>
+#if !defined(_WIN32)
+#include <cerrno>
+#include <cstdio>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 #include "hayai_test_factory.hpp"
+#include "hayai_default_test_factory.hpp"
 #include "hayai_test_descriptor.hpp"
 #include "hayai_test_result.hpp"
+#include "hayai_type_list.hpp"
 #include "hayai_console_outputter.hpp"
+#include "hayai_async_outputter.hpp"
+#include "hayai_execution_context.hpp"
+#include "hayai_clock_probe.hpp"
 
 
 namespace hayai
 {
+    /// Order of the runs in a paired comparison.
+    enum ComparisonOrder
+    {
+        /// Alternate which test goes first, i.e. ABBAABBA...
+        ComparisonOrderABBA,
+
+
+        /// Pick which test goes first at random for every pair.
+        ComparisonOrderRandom
+    };
+
+
     /// Benchmarking execution controller singleton.
     class Benchmarker
     {
@@ -59,6 +87,14 @@ namespace hayai
             if (isDisabled)
                 testName += 9;
 
+            // Determine if the test needs the whole machine.
+            static const char* exclusivePrefix = "EXCLUSIVE_";
+            bool isExclusive = ((::strlen(testName) >= 10) &&
+                                (!::memcmp(testName, exclusivePrefix, 10)));
+
+            if (isExclusive)
+                testName += 10;
+
             // Add the descriptor.
             TestDescriptor* descriptor = new TestDescriptor(fixtureName,
                                                             testName,
@@ -66,7 +102,8 @@ namespace hayai
                                                             iterations,
                                                             testFactory,
                                                             parameters,
-                                                            isDisabled);
+                                                            isDisabled,
+                                                            isExclusive);
 
             Instance()._tests.push_back(descriptor);
 
@@ -74,6 +111,238 @@ namespace hayai
         }
 
 
+        /// Register a paired comparison of two tests.
+
+        /// Once all tests have run, the two tests are run again in
+        /// alternating pairs of runs, one of each back to back, so that both
+        /// see the same clock speed, temperature and background load; see
+        /// @ref ComparisonResult. The number of pairs is the larger of the
+        /// tests' run counts. Tests are looked up by name when the
+        /// comparison is run, so the comparison is skipped if either test has
+        /// been filtered out or does not match the include filters; disabled
+        /// tests can be compared, so prefix the tests with DISABLED_ to run
+        /// them only as part of the comparison.
+        /// Of parametrized tests, the first instance is used.
+        ///
+        /// @param fixtureName Name of the fixture.
+        /// @param baselineName Name of the baseline test.
+        /// @param candidateName Name of the candidate test.
+        /// @returns a pointer to a @ref ComparisonDescriptor instance
+        /// representing the given comparison.
+        static ComparisonDescriptor* RegisterComparison(
+            const char* fixtureName,
+            const char* baselineName,
+            const char* candidateName
+        )
+        {
+            ComparisonDescriptor* descriptor =
+                new ComparisonDescriptor(fixtureName,
+                                         baselineName,
+                                         candidateName);
+
+            Instance()._comparisons.push_back(descriptor);
+
+            return descriptor;
+        }
+
+
+        /// Register a test at a range of sizes.
+
+        /// Registers one test per size, from low to high by multiplying by
+        /// the multiplier, with high always the last; e.g. 8, 64, 512 and
+        /// 1000 for 8 to 1000 by 8. Each test has the size as parameter
+        /// "std::size_t n". Once all tests have run, the median time per
+        /// iteration at each size is fitted to the usual complexities, see
+        /// @ref ComplexityResult.
+        ///
+        /// @tparam T Test class, constructible from the size.
+        /// @param fixtureName Name of the fixture.
+        /// @param testName Name of the test.
+        /// @param runs Number of runs for each size.
+        /// @param iterations Number of iterations per run.
+        /// @param low Smallest size, at least 1; 0 is taken as 1, as the
+        /// logarithmic complexities are not defined for it.
+        /// @param high Largest size, at least low; a smaller one is taken as
+        /// low, for a range of a single size.
+        /// @param multiplier Factor between consecutive sizes. Below 2, the
+        /// range is low and high only.
+        /// @returns a pointer to a @ref RangeDescriptor instance
+        /// representing the given range.
+        template<class T>
+        static RangeDescriptor* RegisterRange(const char* fixtureName,
+                                              const char* testName,
+                                              std::size_t runs,
+                                              std::size_t iterations,
+                                              std::size_t low,
+                                              std::size_t high,
+                                              std::size_t multiplier)
+        {
+            RangeDescriptor* range = new RangeDescriptor(fixtureName,
+                                                         testName);
+
+            low = std::max<std::size_t>(low, 1);
+            high = std::max(high, low);
+
+            for (std::size_t size = low; size < high; size *= multiplier)
+            {
+                range->Sizes.push_back(size);
+
+                if ((multiplier < 2) || (size > high / multiplier))
+                    break;
+            }
+            if ((range->Sizes.empty()) || (range->Sizes.back() != high))
+                range->Sizes.push_back(high);
+
+            for (std::size_t i = 0; i < range->Sizes.size(); ++i)
+            {
+                std::stringstream value;
+                value << range->Sizes[i];
+
+                range->Tests.push_back(RegisterTest(
+                    fixtureName,
+                    testName,
+                    runs,
+                    iterations,
+                    new TestFactoryRange<T>(range->Sizes[i]),
+                    TestParametersDescriptor(
+                        std::vector<TestParameterDescriptor>(
+                            1,
+                            TestParameterDescriptor("std::size_t n",
+                                                    value.str())
+                        )
+                    )
+                ));
+            }
+
+            Instance()._ranges.push_back(range);
+
+            return range;
+        }
+
+
+        /// Fit a user-supplied complexity to a range as well.
+
+        /// @param fixtureName Name of the fixture.
+        /// @param testName Name of the test, as registered with
+        /// @ref RegisterRange, which must have been called already.
+        /// @param complexity Complexity.
+        /// @returns a pointer to the @ref RangeDescriptor instance, or NULL
+        /// if there is no such range.
+        static RangeDescriptor* SetRangeComplexity(
+            const char* fixtureName,
+            const char* testName,
+            ComplexityFunction complexity
+        )
+        {
+            Benchmarker& instance = Instance();
+
+            for (std::size_t i = 0; i < instance._ranges.size(); ++i)
+            {
+                RangeDescriptor* range = instance._ranges[i];
+
+                if ((range->FixtureName == fixtureName) &&
+                    (range->TestName == testName))
+                {
+                    range->Complexity = complexity;
+                    return range;
+                }
+            }
+
+            return NULL;
+        }
+
+
+        /// Register a typed test.
+
+        /// Registers the test once for each type of a type list, as a test
+        /// of its own with the type's @ref TypeName as its parameter, so each
+        /// instantiation is compiled for its type rather than parameterized
+        /// at run time.
+        ///
+        /// @tparam T Test class template, instantiated with each type.
+        /// @param fixtureName Name of the fixture.
+        /// @param testName Name of the test.
+        /// @param runs Number of runs for the test.
+        /// @param iterations Number of iterations per run.
+        /// @param types Type list, see @ref Types.
+        /// @returns the number of tests registered.
+        template<template<class> class T, class Head, class... Tail>
+        static std::size_t RegisterTyped(const char* fixtureName,
+                                         const char* testName,
+                                         std::size_t runs,
+                                         std::size_t iterations,
+                                         Types<Head, Tail...> types)
+        {
+            (void)types;
+
+            RegisterTest(
+                fixtureName,
+                testName,
+                runs,
+                iterations,
+                new TestFactoryDefault<T<Head> >(),
+                TestParametersDescriptor(
+                    std::vector<TestParameterDescriptor>(
+                        1,
+                        TestParameterDescriptor("typename TypeParam",
+                                                TypeName<Head>::Get())
+                    )
+                )
+            );
+
+            return 1 + RegisterTyped<T>(fixtureName,
+                                        testName,
+                                        runs,
+                                        iterations,
+                                        Types<Tail...>());
+        }
+
+
+        /// End of the type list of a typed test.
+        template<template<class> class T>
+        static std::size_t RegisterTyped(const char* fixtureName,
+                                         const char* testName,
+                                         std::size_t runs,
+                                         std::size_t iterations,
+                                         Types<> types)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)runs;
+            (void)iterations;
+            (void)types;
+
+            return 0;
+        }
+
+
+        /// Set the order of the runs in paired comparisons.
+
+        /// @param order Comparison order. Defaults to
+        /// @ref ComparisonOrderABBA.
+        static void SetComparisonOrder(ComparisonOrder order)
+        {
+            Instance()._comparisonOrder = order;
+        }
+
+
+        /// Set the comparison context.
+
+        /// The context paired comparisons are run in when no execution
+        /// contexts have been added, e.g. one that pins the benchmarking
+        /// thread to a single CPU so both tests of a pair run on the same
+        /// core and caches. With execution contexts, comparisons are run
+        /// once in each of them instead.
+        ///
+        /// @param context Execution context, or NULL for none. The caller
+        /// must ensure that the context remains in existence for the entire
+        /// benchmark run.
+        static void SetComparisonContext(ExecutionContext* context)
+        {
+            Instance()._comparisonContext = context;
+        }
+
+
         /// Add an outputter.
 
         /// @param outputter Outputter. The caller must ensure that the
@@ -84,6 +353,95 @@ namespace hayai
         }
 
 
+        /// Add an execution context.
+
+        /// Once any context has been added every test is run once in each of
+        /// them, in the order they were added.
+        ///
+        /// @param context Execution context. The caller must ensure that the
+        /// context remains in existence for the entire benchmark run.
+        static void AddExecutionContext(ExecutionContext& context)
+        {
+            Instance()._contexts.push_back(&context);
+        }
+
+
+        /// Add an environment property.
+
+        /// Environment properties are passed on to the outputters before any
+        /// tests are run, so results can be judged in the light of e.g. the
+        /// frequency scaling governor in use.
+        ///
+        /// @param name Property name.
+        /// @param value Property value.
+        static void AddEnvironment(const std::string& name,
+                                   const std::string& value)
+        {
+            Instance()._environment.push_back(std::make_pair(name, value));
+        }
+
+
+        /// Set the clock probe.
+
+        /// When set, the probe measures the core clock during the timed part
+        /// of every run and test results report the effective frequency and
+        /// cycles per iteration.
+        ///
+        /// @param probe Clock probe, or NULL for none. The caller must ensure
+        /// that the probe remains in existence for the entire benchmark run.
+        static void SetClockProbe(ClockProbe* probe)
+        {
+            Instance()._clockProbe = probe;
+        }
+
+
+        /// Enable or disable isolated test execution.
+
+        /// When enabled, every test is run in a child process of its own so
+        /// that heap, cache and page cache state does not leak from one test
+        /// to the next, and a test that crashes is reported as failed rather
+        /// than taking down the whole run. Not available on Windows.
+        ///
+        /// @param isolate Whether to isolate tests.
+        /// @returns false if isolation is not supported on this platform.
+        static bool SetIsolation(bool isolate)
+        {
+#if defined(_WIN32)
+            if (isolate)
+                return false;
+#endif
+            Instance()._isolate = isolate;
+            return true;
+        }
+
+
+        /// Run tests concurrently in shards.
+
+        /// Each shard is a child process that runs its share of the tests,
+        /// dealt out round-robin in test order, one after another. Results
+        /// are reported once all shards are done, in the same order as for a
+        /// sequential run. Exclusive tests (registered with the EXCLUSIVE_
+        /// prefix) are run one at a time afterwards. Sharding is not used
+        /// while execution contexts are registered, and is not available on
+        /// Windows.
+        ///
+        /// @param shards One entry per shard: a context the shard enters
+        /// before running any tests, e.g. to confine it to cores of its own,
+        /// or NULL. Fewer than two shards runs tests sequentially. The caller
+        /// must ensure that the contexts remain in existence for the entire
+        /// benchmark run.
+        /// @returns false if sharding is not supported on this platform.
+        static bool SetShards(const std::vector<ExecutionContext*>& shards)
+        {
+#if defined(_WIN32)
+            if (shards.size() > 1)
+                return false;
+#endif
+            Instance()._shards = shards;
+            return true;
+        }
+
+
         /// Apply a pattern filter to the tests.
 
         /// --gtest_filter-compatible pattern:
@@ -95,6 +453,36 @@ namespace hayai
         {
             Benchmarker& instance = Instance();
 
+            // Iterate across all tests and test them against the pattern.
+            std::size_t index = 0;
+            while (index < instance._tests.size())
+            {
+                TestDescriptor* desc = instance._tests[index];
+
+                if (!PatternFilterMatches(pattern, desc->CanonicalName))
+                {
+                    instance._tests.erase(
+                        instance._tests.begin() +
+                        std::vector<TestDescriptor*>::difference_type(index)
+                    );
+                    delete desc;
+                }
+                else
+                    ++index;
+            }
+        }
+
+
+        /// Test if a pattern filter matches a test name.
+
+        /// Matches the way @ref ApplyPatternFilter does, so tools reading
+        /// results back select tests the same way --filter does.
+        ///
+        /// @param pattern Filter pattern compatible with gtest.
+        /// @param name Canonical test name, i.e. "Fixture.Test".
+        static bool PatternFilterMatches(const char* pattern,
+                                         const std::string& name)
+        {
             // Split the filter at '-' if it exists.
             const char* const dash = strchr(pattern, '-');
 
@@ -111,25 +499,35 @@ namespace hayai
                     positive = "*";
             }
 
-            // Iterate across all tests and test them against the patterns.
-            std::size_t index = 0;
-            while (index < instance._tests.size())
+            return ((FilterMatchesString(positive.c_str(), name)) &&
+                    (!FilterMatchesString(negative.c_str(), name)));
+        }
+
+
+        /// Test if a filter matches a string.
+
+        /// A filter is a ':' separated list of patterns, where '?' matches
+        /// any single character and '*' any string. Adapted from gtest. All
+        /// rights reserved by original authors.
+        static bool FilterMatchesString(const char* filter,
+                                        const std::string& str)
+        {
+            const char *patternStart = filter;
+
+            while (true)
             {
-                TestDescriptor* desc = instance._tests[index];
+                if (PatternMatchesString(patternStart, str.c_str()))
+                    return true;
 
-                if ((!FilterMatchesString(positive.c_str(),
-                                          desc->CanonicalName)) ||
-                    (FilterMatchesString(negative.c_str(),
-                                         desc->CanonicalName)))
-                {
-                    instance._tests.erase(
-                        instance._tests.begin() +
-                        std::vector<TestDescriptor*>::difference_type(index)
-                    );
-                    delete desc;
-                }
-                else
-                    ++index;
+                // Finds the next pattern in the filter.
+                patternStart = strchr(patternStart, ':');
+
+                // Returns if no more pattern can be found.
+                if (!patternStart)
+                    return false;
+
+                // Skips the pattern separater (the ':' character).
+                patternStart++;
             }
         }
 
@@ -142,11 +540,42 @@ namespace hayai
             defaultOutputters.push_back(&defaultOutputter);
 
             Benchmarker& instance = Instance();
-            std::vector<Outputter*>& outputters =
+            std::vector<Outputter*>& registered =
                 (instance._outputters.empty() ?
                  defaultOutputters :
                  instance._outputters);
 
+            // Forward the outputters to an I/O thread so their formatting
+            // and I/O doesn't happen between measurements. Not when the tests
+            // run in child processes: there are no measurements to keep it
+            // away from, and forking with the I/O thread in the middle of a
+            // write could leave the child deadlocked.
+            bool forward = true;
+#if !defined(_WIN32)
+            forward = ((!instance._isolate) &&
+                       ((instance._shards.size() <= 1) ||
+                        (!instance._contexts.empty())));
+#endif
+
+            std::vector<Outputter*> outputters;
+            std::vector<Outputter*> forwarded;
+
+            for (std::size_t outputterIndex = 0;
+                 outputterIndex < registered.size();
+                 outputterIndex++)
+            {
+                Outputter* outputter = registered[outputterIndex];
+
+                if ((forward) && (!outputter->Synchronous()))
+                    forwarded.push_back(outputter);
+                else
+                    outputters.push_back(outputter);
+            }
+
+            AsyncOutputter asyncOutputter(forwarded);
+            if (!forwarded.empty())
+                outputters.push_back(&asyncOutputter);
+
             // Get the tests for execution.
             std::vector<TestDescriptor*> tests = instance.GetTests();
 
@@ -174,35 +603,35 @@ namespace hayai
                  outputterIndex++)
                 outputters[outputterIndex]->Begin(enabledCount, disabledCount);
 
+            if (!instance._environment.empty())
+                for (std::size_t outputterIndex = 0;
+                     outputterIndex < outputters.size();
+                     outputterIndex++)
+                    outputters[outputterIndex]->Environment(
+                        instance._environment
+                    );
+
+            // Run the tests that can share the machine in shards first. Their
+            // results are reported in order below.
+            std::vector<ShardResult> shardResults;
+#if !defined(_WIN32)
+            if ((instance._shards.size() > 1) && (instance._contexts.empty()))
+                RunShards(tests, shardResults);
+#endif
+
             // Run through all the tests in ascending order.
+            std::vector<RangeSample> rangeSamples;
             std::size_t index = 0;
 
             while (index < tests.size())
             {
                 // Get the test descriptor.
-                TestDescriptor* descriptor = tests[index++];
+                const std::size_t testIndex = index++;
+                TestDescriptor* descriptor = tests[testIndex];
 
                 // Check if test matches include filters
-                if (instance._include.size() > 0)
-                {
-                    bool included = false;
-                    std::string name =
-                        descriptor->FixtureName + "." +
-                        descriptor->TestName;
-
-                    for (std::size_t i = 0; i < instance._include.size(); i++)
-                    {
-                        if (name.find(instance._include[i]) !=
-                            std::string::npos)
-                        {
-                            included = true;
-                            break;
-                        }
-                    }
-
-                    if (!included)
-                        continue;
-                }
+                if (!instance.IsIncluded(descriptor))
+                    continue;
 
                 // Check if test is not disabled.
                 if (descriptor->IsDisabled)
@@ -221,59 +650,151 @@ namespace hayai
                     continue;
                 }
 
-                // Describe the beginning of the run.
-                for (std::size_t outputterIndex = 0;
-                     outputterIndex < outputters.size();
-                     outputterIndex++)
-                    outputters[outputterIndex]->BeginTest(
-                        descriptor->FixtureName,
-                        descriptor->TestName,
-                        descriptor->Parameters,
-                        descriptor->Runs,
-                        descriptor->Iterations
-                    );
+                // Run once in each execution context, or once if there are
+                // none.
+                const std::size_t contextCount =
+                    (instance._contexts.empty() ?
+                     1 :
+                     instance._contexts.size());
 
-                // Execute each individual run.
-                std::vector<uint64_t> runTimes(descriptor->Runs);
-                uint64_t overheadCalibration =
-                    calibrationModel.GetCalibration(descriptor->Iterations);
-
-                std::size_t run = 0;
-                while (run < descriptor->Runs)
+                for (std::size_t contextIndex = 0;
+                     contextIndex < contextCount;
+                     ++contextIndex)
                 {
-                    // Construct a test instance.
-                    Test* test = descriptor->Factory->CreateTest();
+                    ExecutionContext* context =
+                        (instance._contexts.empty() ?
+                         NULL :
+                         instance._contexts[contextIndex]);
+
+                    if ((context) && (!context->Enter()))
+                        continue;
 
-                    // Run the test.
-                    uint64_t time = test->Run(descriptor->Iterations);
+                    // Describe the beginning of the run.
+                    for (std::size_t outputterIndex = 0;
+                         outputterIndex < outputters.size();
+                         outputterIndex++)
+                        outputters[outputterIndex]->BeginTest(
+                            descriptor->FixtureName,
+                            descriptor->TestName,
+                            descriptor->Parameters,
+                            descriptor->Runs,
+                            descriptor->Iterations
+                        );
 
-                    // Store the test time.
-                    runTimes[run] = (time > overheadCalibration ?
-                                     time - overheadCalibration :
-                                     0);
+                    // Execute each individual run.
+                    std::vector<RunSample> samples(descriptor->Runs);
+                    uint64_t overheadCalibration =
+                        calibrationModel.GetCalibration(descriptor->Iterations);
 
-                    // Dispose of the test instance.
-                    delete test;
+                    std::string failure;
+                    bool completed = true;
 
-                    ++run;
-                }
+                    if ((testIndex < shardResults.size()) &&
+                        (shardResults[testIndex].Ran))
+                    {
+                        samples.swap(shardResults[testIndex].Samples);
+                        completed = shardResults[testIndex].Completed;
+                        failure = shardResults[testIndex].Failure;
+                    }
+#if !defined(_WIN32)
+                    else if (instance._isolate)
+                        completed = RunTestIsolated(descriptor,
+                                                    samples,
+                                                    failure);
+#endif
+                    else
+                        RunTest(descriptor, samples);
 
-                // Calculate the test result.
-                TestResult testResult(runTimes, descriptor->Iterations);
+                    // Store the test times, and the core clock measurements
+                    // if every run has them.
+                    std::vector<uint64_t> runTimes(samples.size());
+                    std::vector<uint64_t> runCycles;
+                    std::vector<uint64_t> runActiveTimes;
 
-                // Describe the end of the run.
-                for (std::size_t outputterIndex = 0;
-                     outputterIndex < outputters.size();
-                     outputterIndex++)
-                    outputters[outputterIndex]->EndTest(
-                        descriptor->FixtureName,
-                        descriptor->TestName,
-                        descriptor->Parameters,
-                        testResult
-                    );
+                    for (std::size_t run = 0; run < samples.size(); ++run)
+                    {
+                        const uint64_t time = samples[run].Time;
+                        runTimes[run] = (time > overheadCalibration ?
+                                         time - overheadCalibration :
+                                         0);
+
+                        if (samples[run].ActiveTime)
+                        {
+                            runCycles.push_back(samples[run].Cycles);
+                            runActiveTimes.push_back(samples[run].ActiveTime);
+                        }
+                    }
+
+                    if (context)
+                        context->Leave();
+
+                    if (!completed)
+                    {
+                        for (std::size_t outputterIndex = 0;
+                             outputterIndex < outputters.size();
+                             outputterIndex++)
+                            outputters[outputterIndex]->FailTest(
+                                descriptor->FixtureName,
+                                descriptor->TestName,
+                                descriptor->Parameters,
+                                (context ?
+                                 context->Name() :
+                                 std::string()),
+                                failure
+                            );
+
+                        continue;
+                    }
+
+                    // Calculate the test result.
+                    TestResult testResult(runTimes,
+                                          descriptor->Iterations,
+                                          (context ?
+                                           context->Name() :
+                                           std::string()));
+
+                    if ((!runCycles.empty()) &&
+                        (runCycles.size() == samples.size()))
+                        testResult.SetClock(runCycles, runActiveTimes);
+
+                    AddCounters(testResult, samples);
+
+                    if (!instance._ranges.empty())
+                        rangeSamples.push_back(
+                            RangeSample(descriptor,
+                                        testResult.Context(),
+                                        testResult.IterationTimeMedian())
+                        );
 
+                    // Describe the end of the run.
+                    for (std::size_t outputterIndex = 0;
+                         outputterIndex < outputters.size();
+                         outputterIndex++)
+                        outputters[outputterIndex]->EndTest(
+                            descriptor->FixtureName,
+                            descriptor->TestName,
+                            descriptor->Parameters,
+                            testResult
+                        );
+                }
             }
 
+            // Run the paired comparisons.
+            for (std::size_t comparisonIndex = 0;
+                 comparisonIndex < instance._comparisons.size();
+                 ++comparisonIndex)
+                RunComparison(instance._comparisons[comparisonIndex],
+                              calibrationModel,
+                              outputters);
+
+            // Fit the ranges.
+            for (std::size_t rangeIndex = 0;
+                 rangeIndex < instance._ranges.size();
+                 ++rangeIndex)
+                FitRange(instance._ranges[rangeIndex],
+                         rangeSamples,
+                         outputters);
+
             // End output.
             for (std::size_t outputterIndex = 0;
                  outputterIndex < outputters.size();
@@ -353,60 +874,929 @@ namespace hayai
             }
         };
 
-        
-        /// Private constructor.
-        Benchmarker()
+
+        /// Counter reported in a single run.
+
+        /// Fixed size, like @ref RunSample, so samples can be sent from
+        /// child processes as they are.
+        struct RunCounter
         {
+            /// Name, truncated and null terminated.
+            char Name[32];
 
-        }
 
+            /// Value per iteration.
+            double Value;
 
-        /// Private destructor.
+
+            /// Type.
+            CounterType Type;
+        };
+
+
+        /// Measurements of a single run.
+        struct RunSample
+        {
+            RunSample()
+                :   Time(0),
+                    Cycles(0),
+                    ActiveTime(0),
+                    CounterCount(0)
+            {
+
+            }
+
+
+            /// Raw time of the run in nanoseconds.
+            uint64_t Time;
+
+
+            /// Core clock cycles elapsed, if measured.
+            uint64_t Cycles;
+
+
+            /// Nanoseconds the thread was running, or 0 if not measured.
+            uint64_t ActiveTime;
+
+
+            /// Counters reported by the test.
+            RunCounter Counters[Test::MaxCounters];
+
+
+            /// Number of counters reported by the test.
+            std::size_t CounterCount;
+        };
+
+
+        /// Time of a test that completed, for fitting ranges.
+        struct RangeSample
+        {
+            RangeSample(const TestDescriptor* test,
+                        const std::string& context,
+                        double time)
+                :   Test(test),
+                    Context(context),
+                    Time(time)
+            {
+
+            }
+
+
+            /// Test descriptor.
+            const TestDescriptor* Test;
+
+
+            /// Execution context name, empty if none.
+            std::string Context;
+
+
+            /// Median time per iteration in nanoseconds.
+            double Time;
+        };
+
+
+        /// Outcome of a test run in a shard.
+        struct ShardResult
+        {
+            ShardResult()
+                :   Ran(false),
+                    Completed(false)
+            {
+
+            }
+
+
+            /// Whether the test was run in a shard at all.
+            bool Ran;
+
+
+            /// Whether all runs completed.
+            bool Completed;
+
+
+            /// Measurements of each run.
+            std::vector<RunSample> Samples;
+
+
+            /// Description of what went wrong if the runs did not complete.
+            std::string Failure;
+        };
+
+        
+        /// Private constructor.
+        Benchmarker()
+            :   _clockProbe(NULL),
+                _isolate(false),
+                _comparisonOrder(ComparisonOrderABBA),
+                _comparisonContext(NULL)
+        {
+
+        }
+
+
+        /// Private destructor.
         ~Benchmarker()
         {
             // Release all test descriptors.
             std::size_t index = _tests.size();
             while (index--)
                 delete _tests[index];
+
+            index = _comparisons.size();
+            while (index--)
+                delete _comparisons[index];
+
+            index = _ranges.size();
+            while (index--)
+                delete _ranges[index];
         }
 
 
-        /// Get the tests to be executed.
-        std::vector<TestDescriptor*> GetTests() const
+        /// Execute a single run of a test.
+
+        /// @param descriptor Test descriptor.
+        /// @returns the measurements of the run.
+        static RunSample RunOnce(const TestDescriptor* descriptor)
         {
-            std::vector<TestDescriptor*> tests;
+            ClockProbe* probe = Instance()._clockProbe;
+            RunSample sample;
 
-            std::size_t index = 0;
-            while (index < _tests.size())
-                tests.push_back(_tests[index++]);
+            // Construct a test instance.
+            Test* test = descriptor->Factory->CreateTest();
 
-            return tests;
+            // Run the test, on the timeline too if one is recorded.
+            int cpu = -1;
+            const uint64_t runStart =
+                (Trace::Enabled() ? Trace::Now(cpu) : 0);
+
+            sample.Time = test->Run(descriptor->Iterations, probe);
+
+            if (runStart)
+                Trace::Span("run",
+                            descriptor->CanonicalName,
+                            runStart,
+                            Trace::Now(),
+                            cpu);
+
+            if ((probe) &&
+                (!probe->Read(sample.Cycles, sample.ActiveTime)))
+                sample.Cycles = sample.ActiveTime = 0;
+
+            // Keep the counters the test reported.
+            const Test::Counter* counters = test->Counters();
+
+            sample.CounterCount = test->CounterCount();
+            for (std::size_t i = 0; i < sample.CounterCount; ++i)
+            {
+                RunCounter& runCounter = sample.Counters[i];
+
+                strncpy(runCounter.Name,
+                        counters[i].Name,
+                        sizeof(runCounter.Name) - 1);
+                runCounter.Name[sizeof(runCounter.Name) - 1] = 0;
+                runCounter.Value = counters[i].Value;
+                runCounter.Type = counters[i].Type;
+            }
+
+            // Dispose of the test instance.
+            delete test;
+
+            return sample;
         }
 
 
-        /// Test if a filter matches a string.
+        /// Execute the runs of a test in this process.
 
-        /// Adapted from gtest. All rights reserved by original authors.
-        static bool FilterMatchesString(const char* filter,
-                                        const std::string& str)
+        /// @param descriptor Test descriptor.
+        /// @param samples Receives the measurements of each run.
+        static void RunTest(const TestDescriptor* descriptor,
+                            std::vector<RunSample>& samples)
         {
-            const char *patternStart = filter;
+            for (std::size_t run = 0; run < descriptor->Runs; ++run)
+                samples[run] = RunOnce(descriptor);
+        }
 
-            while (true)
+
+        /// Add the counters reported in the runs to a test result.
+
+        /// Counters are added in the order the runs first reported them;
+        /// runs that did not report a counter count as 0 for it.
+        ///
+        /// @param result Test result.
+        /// @param samples Measurements of each run.
+        static void AddCounters(TestResult& result,
+                                const std::vector<RunSample>& samples)
+        {
+            std::vector<const RunCounter*> counters;
+
+            for (std::size_t run = 0; run < samples.size(); ++run)
+                for (std::size_t i = 0; i < samples[run].CounterCount; ++i)
+                {
+                    const RunCounter& counter = samples[run].Counters[i];
+                    bool found = false;
+
+                    for (std::size_t c = 0; c < counters.size(); ++c)
+                        found = ((found) ||
+                                 (!strcmp(counters[c]->Name, counter.Name)));
+
+                    if (!found)
+                        counters.push_back(&counter);
+                }
+
+            for (std::size_t c = 0; c < counters.size(); ++c)
             {
-                if (PatternMatchesString(patternStart, str.c_str()))
+                std::vector<double> runValues(samples.size(), 0.0);
+
+                for (std::size_t run = 0; run < samples.size(); ++run)
+                    for (std::size_t i = 0; i < samples[run].CounterCount; ++i)
+                        if (!strcmp(samples[run].Counters[i].Name,
+                                    counters[c]->Name))
+                            runValues[run] = samples[run].Counters[i].Value;
+
+                result.AddCounter(counters[c]->Name,
+                                  counters[c]->Type,
+                                  runValues);
+            }
+        }
+
+
+        /// Find a registered test by name.
+
+        /// @returns the first test with the given name, or NULL.
+        const TestDescriptor* FindTest(const std::string& fixtureName,
+                                       const std::string& testName) const
+        {
+            for (std::size_t index = 0; index < _tests.size(); ++index)
+                if ((_tests[index]->FixtureName == fixtureName) &&
+                    (_tests[index]->TestName == testName))
+                    return _tests[index];
+
+            return NULL;
+        }
+
+
+        /// Fit a range to the complexities and report the result.
+
+        /// Fits once per execution context the range's tests completed in,
+        /// skipping contexts where fewer than two sizes completed.
+        ///
+        /// @param range Range descriptor.
+        /// @param samples Times of the tests that completed.
+        /// @param outputters Outputters to report to.
+        static void FitRange(const RangeDescriptor* range,
+                             const std::vector<RangeSample>& samples,
+                             std::vector<Outputter*>& outputters)
+        {
+            if (range->Tests.empty())
+                return;
+
+            // Contexts in the order the range's tests completed in them.
+            std::vector<std::string> contexts;
+
+            for (std::size_t i = 0; i < samples.size(); ++i)
+                if ((std::find(range->Tests.begin(),
+                               range->Tests.end(),
+                               samples[i].Test) != range->Tests.end()) &&
+                    (std::find(contexts.begin(),
+                               contexts.end(),
+                               samples[i].Context) == contexts.end()))
+                    contexts.push_back(samples[i].Context);
+
+            for (std::size_t c = 0; c < contexts.size(); ++c)
+            {
+                std::vector<double> sizes;
+                std::vector<double> times;
+
+                for (std::size_t t = 0; t < range->Tests.size(); ++t)
+                    for (std::size_t i = 0; i < samples.size(); ++i)
+                        if ((samples[i].Test == range->Tests[t]) &&
+                            (samples[i].Context == contexts[c]))
+                        {
+                            sizes.push_back(double(range->Sizes[t]));
+                            times.push_back(samples[i].Time);
+                            break;
+                        }
+
+                if (sizes.size() < 2)
+                    continue;
+
+                const ComplexityResult result(sizes,
+                                              times,
+                                              contexts[c],
+                                              range->Complexity);
+
+                for (std::size_t outputterIndex = 0;
+                     outputterIndex < outputters.size();
+                     outputterIndex++)
+                    outputters[outputterIndex]->EndComplexity(
+                        range->Tests[0]->FixtureName,
+                        range->Tests[0]->TestName,
+                        result
+                    );
+            }
+        }
+
+
+        /// Run a paired comparison and report the result.
+
+        /// Always runs in this process, regardless of isolation and shards.
+        ///
+        /// @param comparison Comparison descriptor.
+        /// @param calibrationModel Overhead calibration.
+        /// @param outputters Outputters to report to.
+        static void RunComparison(const ComparisonDescriptor* comparison,
+                                  const CalibrationModel& calibrationModel,
+                                  std::vector<Outputter*>& outputters)
+        {
+            Benchmarker& instance = Instance();
+            const TestDescriptor* baseline =
+                instance.FindTest(comparison->FixtureName,
+                                  comparison->BaselineName);
+            const TestDescriptor* candidate =
+                instance.FindTest(comparison->FixtureName,
+                                  comparison->CandidateName);
+
+            if ((!baseline) ||
+                (!candidate) ||
+                (!instance.IsIncluded(baseline)) ||
+                (!instance.IsIncluded(candidate)))
+                return;
+
+            const std::size_t pairs = std::max(baseline->Runs,
+                                               candidate->Runs);
+            const bool random =
+                (instance._comparisonOrder == ComparisonOrderRandom);
+#if __cplusplus > 201100L
+            std::random_device rd;
+            std::mt19937 g(rd());
+#endif
+
+            // Run once in each execution context, or once in the comparison
+            // context if there are none.
+            std::vector<ExecutionContext*> contexts(instance._contexts);
+            if (contexts.empty())
+                contexts.push_back(instance._comparisonContext);
+
+            for (std::size_t contextIndex = 0;
+                 contextIndex < contexts.size();
+                 ++contextIndex)
+            {
+                ExecutionContext* context = contexts[contextIndex];
+
+                if ((context) && (!context->Enter()))
+                    continue;
+
+                // Warm up, so the first pair does not pay for cold caches.
+                RunOnce(baseline);
+                RunOnce(candidate);
+
+                std::vector<double> baselineTimes(pairs);
+                std::vector<double> candidateTimes(pairs);
+
+                for (std::size_t pair = 0; pair < pairs; ++pair)
+                {
+                    bool baselineFirst = (pair % 2 == 0);
+                    if (random)
+#if __cplusplus > 201100L
+                        baselineFirst = ((g() & 1) == 0);
+#else
+                        baselineFirst = ((std::rand() & 1) == 0);
+#endif
+
+                    for (int side = 0; side < 2; ++side)
+                    {
+                        const bool runBaseline = ((side == 0) == baselineFirst);
+                        const TestDescriptor* descriptor =
+                            (runBaseline ? baseline : candidate);
+                        const uint64_t overheadCalibration =
+                            calibrationModel.GetCalibration(
+                                descriptor->Iterations
+                            );
+                        const uint64_t time = RunOnce(descriptor).Time;
+                        const double iterationTime =
+                            double(time > overheadCalibration ?
+                                   time - overheadCalibration :
+                                   0) /
+                            double(descriptor->Iterations);
+
+                        if (runBaseline)
+                            baselineTimes[pair] = iterationTime;
+                        else
+                            candidateTimes[pair] = iterationTime;
+                    }
+                }
+
+                if (context)
+                    context->Leave();
+
+                ComparisonResult result(baselineTimes,
+                                        candidateTimes,
+                                        (random ? "random" : "ABBA"),
+                                        (context ?
+                                         context->Name() :
+                                         std::string()));
+
+                for (std::size_t outputterIndex = 0;
+                     outputterIndex < outputters.size();
+                     outputterIndex++)
+                    outputters[outputterIndex]->EndComparison(
+                        comparison->FixtureName,
+                        comparison->BaselineName,
+                        comparison->CandidateName,
+                        result
+                    );
+            }
+        }
+
+
+#if !defined(_WIN32)
+        /// Execute the runs of a test in a child process.
+
+        /// The child writes the measurements of each run to a pipe as a
+        /// native endian @ref RunSample as soon as the run completes and exits
+        /// with status 0 once all runs are done. Anything else means the test
+        /// failed.
+        ///
+        /// @param descriptor Test descriptor.
+        /// @param samples Receives the measurements of each run.
+        /// @param failure Receives a description of what went wrong.
+        /// @returns true if all runs completed.
+        static bool RunTestIsolated(const TestDescriptor* descriptor,
+                                    std::vector<RunSample>& samples,
+                                    std::string& failure)
+        {
+            int fds[2];
+            if (pipe(fds))
+            {
+                failure = std::string("pipe failed: ") + strerror(errno);
+                return false;
+            }
+
+            // Anything still buffered would otherwise be written twice.
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(NULL);
+
+            const pid_t pid = fork();
+            if (pid < 0)
+            {
+                failure = std::string("fork failed: ") + strerror(errno);
+                close(fds[0]);
+                close(fds[1]);
+                return false;
+            }
+
+            if (pid == 0)
+            {
+                close(fds[0]);
+
+                for (std::size_t run = 0; run < descriptor->Runs; ++run)
+                {
+                    const RunSample sample = RunOnce(descriptor);
+
+                    if (!WriteAll(fds[1], &sample, sizeof(sample)))
+                        _exit(EXIT_FAILURE);
+                }
+
+                close(fds[1]);
+                std::cout.flush();
+                std::cerr.flush();
+                fflush(NULL);
+                _exit(EXIT_SUCCESS);
+            }
+
+            close(fds[1]);
+
+            // Read run measurements until the child closes its end.
+            std::size_t received = 0;
+            RunSample sample;
+            while ((received < descriptor->Runs) &&
+                   (ReadAll(fds[0], &sample, sizeof(sample))))
+                samples[received++] = sample;
+
+            close(fds[0]);
+
+            int status = 0;
+            while ((waitpid(pid, &status, 0) < 0) && (errno == EINTR))
+                ;
+
+            std::stringstream reason;
+            reason << DescribeExitStatus(status);
+
+            if (reason.str().empty())
+            {
+                if (received == descriptor->Runs)
                     return true;
+                reason << "exited early";
+            }
 
-                // Finds the next pattern in the filter.
-                patternStart = strchr(patternStart, ':');
+            reason << " after " << received << " of " << descriptor->Runs
+                   << (descriptor->Runs == 1 ? " run" : " runs");
+            failure = reason.str();
+            return false;
+        }
 
-                // Returns if no more pattern can be found.
-                if (!patternStart)
+
+        /// Describe how a child process ended.
+
+        /// @returns an empty string if it exited with status 0.
+        static std::string DescribeExitStatus(int status)
+        {
+            std::stringstream description;
+
+            if (WIFSIGNALED(status))
+                description << "killed by signal " << WTERMSIG(status) << " ("
+                            << strsignal(WTERMSIG(status)) << ")";
+            else if ((!WIFEXITED(status)) || (WEXITSTATUS(status)))
+                description << "exited with status " << WEXITSTATUS(status);
+
+            return description.str();
+        }
+
+
+        /// Run the tests that can share the machine in shards.
+
+        /// Every enabled, included, non-exclusive test is dealt to a shard.
+        /// Each shard is a child process that writes a record per test to a
+        /// pipe as soon as the test is done: the test index and run count as
+        /// native endian uint64_t followed by a @ref RunSample per run, or, if
+        /// the test failed, a run count of ~0 followed by the length and text
+        /// of the failure reason. The pipes are drained while the shards run and
+        /// the records decoded once all shards have exited.
+        ///
+        /// @param tests Tests to be executed.
+        /// @param results Receives the outcome of each test, by index.
+        static void RunShards(const std::vector<TestDescriptor*>& tests,
+                              std::vector<ShardResult>& results)
+        {
+            Benchmarker& instance = Instance();
+            const std::size_t shardCount = instance._shards.size();
+
+            // Deal out the tests.
+            std::vector< std::vector<std::size_t> > assigned(shardCount);
+            std::size_t dealt = 0;
+
+            for (std::size_t index = 0; index < tests.size(); ++index)
+            {
+                const TestDescriptor* descriptor = tests[index];
+                if ((!descriptor->IsDisabled) &&
+                    (!descriptor->IsExclusive) &&
+                    (instance.IsIncluded(descriptor)))
+                    assigned[dealt++ % shardCount].push_back(index);
+            }
+
+            results.resize(tests.size());
+
+            // Anything still buffered would otherwise be written again by
+            // every shard.
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(NULL);
+
+            // Start the shards.
+            std::vector<pid_t> pids(shardCount, -1);
+            std::vector<int> fds(shardCount, -1);
+            std::vector<std::string> reasons(shardCount);
+
+            for (std::size_t shard = 0; shard < shardCount; ++shard)
+            {
+                if (assigned[shard].empty())
+                    continue;
+
+                int pipeFds[2];
+                if (pipe(pipeFds))
+                {
+                    reasons[shard] = std::string("pipe failed: ") +
+                                     strerror(errno);
+                    continue;
+                }
+
+                const pid_t pid = fork();
+                if (pid < 0)
+                {
+                    reasons[shard] = std::string("fork failed: ") +
+                                     strerror(errno);
+                    close(pipeFds[0]);
+                    close(pipeFds[1]);
+                    continue;
+                }
+
+                if (pid == 0)
+                {
+                    close(pipeFds[0]);
+                    for (std::size_t other = 0; other < shard; ++other)
+                        if (fds[other] >= 0)
+                            close(fds[other]);
+
+                    RunShard(instance._shards[shard],
+                             tests,
+                             assigned[shard],
+                             pipeFds[1]);
+                }
+
+                close(pipeFds[1]);
+                pids[shard] = pid;
+                fds[shard] = pipeFds[0];
+            }
+
+            // Collect the records.
+            std::vector<std::string> records(shardCount);
+            DrainPipes(fds, records);
+
+            for (std::size_t shard = 0; shard < shardCount; ++shard)
+            {
+                if (pids[shard] > 0)
+                {
+                    int status = 0;
+                    while ((waitpid(pids[shard], &status, 0) < 0) &&
+                           (errno == EINTR))
+                        ;
+                    reasons[shard] = DescribeExitStatus(status);
+                }
+
+                // Decode the records, which arrive in the order the tests
+                // were dealt.
+                const std::string& record = records[shard];
+                std::size_t offset = 0;
+                std::size_t reported = 0;
+                uint64_t header[2];
+
+                while ((reported < assigned[shard].size()) &&
+                       (Extract(record, offset, header, sizeof(header))) &&
+                       (header[0] == assigned[shard][reported]))
+                {
+                    const TestDescriptor* descriptor = tests[header[0]];
+                    ShardResult result;
+
+                    if (header[1] == ~uint64_t(0))
+                    {
+                        uint64_t length;
+                        if (!Extract(record, offset, &length, sizeof(length)))
+                            break;
+                        result.Failure.resize(length);
+                        if ((length) &&
+                            (!Extract(record, offset, &result.Failure[0], length)))
+                            break;
+                    }
+                    else
+                    {
+                        if (header[1] != descriptor->Runs)
+                            break;
+                        result.Samples.resize(descriptor->Runs);
+                        if ((descriptor->Runs) &&
+                            (!Extract(record,
+                                      offset,
+                                      &result.Samples[0],
+                                      descriptor->Runs * sizeof(RunSample))))
+                            break;
+                        result.Completed = true;
+                    }
+
+                    result.Ran = true;
+                    results[header[0]] = result;
+                    ++reported;
+                }
+
+                // Whatever was not reported went down with the shard.
+                for (std::size_t n = reported; n < assigned[shard].size(); ++n)
+                {
+                    std::stringstream failure;
+                    if (n > reported)
+                        failure << "not run, ";
+                    failure << "shard " << shard << " "
+                            << (reasons[shard].empty() ?
+                                std::string("exited early") :
+                                reasons[shard]);
+
+                    ShardResult& result = results[assigned[shard][n]];
+                    result.Ran = true;
+                    result.Failure = failure.str();
+                }
+            }
+        }
+
+
+        /// Run a shard's tests in the shard's child process.
+
+        /// Never returns.
+        ///
+        /// @param context Shard context, or NULL.
+        /// @param tests Tests to be executed.
+        /// @param assigned Indices of the tests dealt to the shard.
+        /// @param fd Write end of the shard's pipe.
+        static void RunShard(ExecutionContext* context,
+                             const std::vector<TestDescriptor*>& tests,
+                             const std::vector<std::size_t>& assigned,
+                             int fd)
+        {
+            const bool entered = ((!context) || (context->Enter()));
+
+            for (std::size_t n = 0; n < assigned.size(); ++n)
+            {
+                const TestDescriptor* descriptor = tests[assigned[n]];
+                std::vector<RunSample> samples(descriptor->Runs);
+                std::string failure;
+                bool completed = false;
+
+                if (!entered)
+                    failure = "could not enter shard context " +
+                              context->Name();
+                else if (Instance()._isolate)
+                    completed = RunTestIsolated(descriptor, samples, failure);
+                else
+                {
+                    RunTest(descriptor, samples);
+                    completed = true;
+                }
+
+                uint64_t header[2] = {
+                    uint64_t(assigned[n]),
+                    (completed ? uint64_t(samples.size()) : ~uint64_t(0))
+                };
+                bool written = WriteAll(fd, header, sizeof(header));
+
+                if (completed)
+                    written = ((written) &&
+                               ((samples.empty()) ||
+                                (WriteAll(fd,
+                                          &samples[0],
+                                          samples.size() * sizeof(RunSample)))));
+                else
+                {
+                    const uint64_t length = failure.size();
+                    written = ((written) &&
+                               (WriteAll(fd, &length, sizeof(length))) &&
+                               (WriteAll(fd, failure.data(), failure.size())));
+                }
+
+                if (!written)
+                    _exit(EXIT_FAILURE);
+            }
+
+            close(fd);
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(NULL);
+            _exit(EXIT_SUCCESS);
+        }
+
+
+        /// Read from file descriptors until they have all been closed.
+
+        /// @param fds File descriptors, or -1 for none. Closed on return.
+        /// @param data Receives everything read from each descriptor.
+        static void DrainPipes(std::vector<int>& fds,
+                               std::vector<std::string>& data)
+        {
+            char buffer[4096];
+
+            for (;;)
+            {
+                std::vector<pollfd> polls;
+                std::vector<std::size_t> owners;
+
+                for (std::size_t n = 0; n < fds.size(); ++n)
+                {
+                    if (fds[n] < 0)
+                        continue;
+
+                    pollfd entry;
+                    entry.fd = fds[n];
+                    entry.events = POLLIN;
+                    entry.revents = 0;
+                    polls.push_back(entry);
+                    owners.push_back(n);
+                }
+
+                if (polls.empty())
+                    return;
+
+                if (poll(&polls[0], nfds_t(polls.size()), -1) < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    // Give up on all of them.
+                    for (std::size_t n = 0; n < owners.size(); ++n)
+                    {
+                        close(fds[owners[n]]);
+                        fds[owners[n]] = -1;
+                    }
+                    return;
+                }
+
+                for (std::size_t n = 0; n < polls.size(); ++n)
+                {
+                    if (!polls[n].revents)
+                        continue;
+
+                    int& fd = fds[owners[n]];
+                    const ssize_t got = read(fd, buffer, sizeof(buffer));
+
+                    if (got > 0)
+                        data[owners[n]].append(buffer, std::size_t(got));
+                    else if ((got == 0) || (errno != EINTR))
+                    {
+                        close(fd);
+                        fd = -1;
+                    }
+                }
+            }
+        }
+
+
+        /// Extract bytes from a buffer.
+
+        /// @returns false if fewer than size bytes remain after offset.
+        static bool Extract(const std::string& buffer,
+                            std::size_t& offset,
+                            void* data,
+                            std::size_t size)
+        {
+            if (buffer.size() - offset < size)
+                return false;
+
+            memcpy(data, buffer.data() + offset, size);
+            offset += size;
+            return true;
+        }
+
+
+        /// Write all of a buffer to a file descriptor.
+        static bool WriteAll(int fd, const void* data, std::size_t size)
+        {
+            const char* p = static_cast<const char*>(data);
+            while (size)
+            {
+                const ssize_t written = write(fd, p, size);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
                     return false;
+                }
+                p += written;
+                size -= std::size_t(written);
+            }
+            return true;
+        }
 
-                // Skips the pattern separater (the ':' character).
-                patternStart++;
+
+        /// Read exactly size bytes from a file descriptor.
+
+        /// @returns false on end of file or error.
+        static bool ReadAll(int fd, void* data, std::size_t size)
+        {
+            char* p = static_cast<char*>(data);
+            while (size)
+            {
+                const ssize_t got = read(fd, p, size);
+                if (got < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                if (got == 0)
+                    return false;
+                p += got;
+                size -= std::size_t(got);
             }
+            return true;
+        }
+#endif
+
+
+        /// Test if a test matches the include filters.
+        bool IsIncluded(const TestDescriptor* descriptor) const
+        {
+            if (_include.empty())
+                return true;
+
+            std::string name =
+                descriptor->FixtureName + "." +
+                descriptor->TestName;
+
+            for (std::size_t i = 0; i < _include.size(); i++)
+            {
+                if (name.find(_include[i]) != std::string::npos)
+                    return true;
+            }
+
+            return false;
+        }
+
+
+        /// Get the tests to be executed.
+        std::vector<TestDescriptor*> GetTests() const
+        {
+            std::vector<TestDescriptor*> tests;
+
+            std::size_t index = 0;
+            while (index < _tests.size())
+                tests.push_back(_tests[index++]);
+
+            return tests;
         }
 
 
@@ -546,7 +1936,16 @@ namespace hayai
 
         std::vector<Outputter*> _outputters; ///< Registered outputters.
         std::vector<TestDescriptor*> _tests; ///< Registered tests.
+        std::vector<ExecutionContext*> _contexts; ///< Execution contexts.
+        ClockProbe* _clockProbe; ///< Clock probe.
+        bool _isolate; ///< Run each test in a child process.
+        std::vector<ExecutionContext*> _shards; ///< Shard contexts.
+        EnvironmentProperties _environment; ///< Environment properties.
         std::vector<std::string> _include; ///< Test filters.
+        std::vector<ComparisonDescriptor*> _comparisons; ///< Comparisons.
+        std::vector<RangeDescriptor*> _ranges; ///< Ranges.
+        ComparisonOrder _comparisonOrder; ///< Comparison run order.
+        ExecutionContext* _comparisonContext; ///< Comparison context.
     };
 }
 #endif
@@ -0,0 +1,376 @@
+#ifndef __HAYAI_BINARYOUTPUTTER
+#define __HAYAI_BINARYOUTPUTTER
+#include <cstring>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "hayai_outputter.hpp"
+
+
+/// Binary result file magic.
+#define HAYAI_BINARY_MAGIC "HAYAIBIN"
+
+
+/// Binary result format version.
+#define HAYAI_BINARY_VERSION 1
+
+
+namespace hayai
+{
+    /// Binary result record types.
+    enum BinaryRecordType
+    {
+        /// Start of the run.
+        BinaryRecordBegin = 1,
+
+
+        /// Environment properties.
+        BinaryRecordEnvironment = 2,
+
+
+        /// Completed test.
+        BinaryRecordTest = 3,
+
+
+        /// Skipped disabled test.
+        BinaryRecordDisabledTest = 4,
+
+
+        /// Failed test.
+        BinaryRecordFailedTest = 5,
+
+
+        /// Paired comparison.
+        BinaryRecordComparison = 6,
+
+
+        /// End of the run.
+        BinaryRecordEnd = 7
+    };
+
+
+    /// Binary result test record section types.
+    enum BinarySectionType
+    {
+        /// Run times in nanoseconds.
+        BinarySectionRunTimes = 1,
+
+
+        /// Core clock cycles per run.
+        BinarySectionRunCycles = 2,
+
+
+        /// Nanoseconds the benchmarking thread was running per run.
+        BinarySectionRunActiveTimes = 3,
+
+
+        /// Reserved for a histogram of iteration times.
+        BinarySectionHistogram = 4,
+
+
+        /// Named counters reported by the test.
+        BinarySectionCounters = 5
+    };
+
+
+    /// Binary outputter.
+
+    /// Outputs the result of benchmarks in a compact binary format, which is
+    /// a fraction of the size of the JSON output and needs no parsing to read
+    /// back, see @ref BinaryReader.
+    ///
+    /// A file is the 8 byte magic "HAYAIBIN" and a uint32 format version,
+    /// followed by records of a uint32 @ref BinaryRecordType, a uint32
+    /// payload size in bytes and the payload. All integers are little-endian,
+    /// doubles are IEEE 754 bit patterns stored as a uint64, strings are a
+    /// uint32 length followed by that many bytes of UTF-8, and parameters are
+    /// a uint32 count followed by declaration and value strings.
+    ///
+    /// - Begin: uint64 UNIX time, host name, uint64 enabled and disabled
+    ///   test counts.
+    /// - Environment: uint32 count, then name and value strings.
+    /// - Test: fixture, name, parameters, context, uint64 iterations per run,
+    ///   then sections up to the end of the payload, each a uint32
+    ///   @ref BinarySectionType, a uint32 size in bytes and the data. Run
+    ///   sections are arrays of uint64, one per run. The counters section is
+    ///   a uint32 count, then for each counter its name, a uint32
+    ///   @ref CounterType, a uint32 run count and the value per iteration of
+    ///   every run as doubles.
+    /// - Disabled test: fixture, name, parameters, uint64 runs and iterations
+    ///   per run.
+    /// - Failed test: fixture, name, parameters, reason, context. Records
+    ///   written before the context was added end after the reason.
+    /// - Comparison: fixture, baseline, candidate, order, context, uint32
+    ///   pair count, then the baseline and candidate time per iteration of
+    ///   every pair as doubles, in nanoseconds.
+    /// - End: uint64 executed and disabled test counts.
+    ///
+    /// Every record is written in one go and the stream flushed as soon as a
+    /// test ends, so a crash loses at most the test that was running; a file
+    /// without an End record is from a run that did not finish. Readers skip
+    /// record and section types they do not know, so new ones can be added
+    /// without bumping the version.
+    class BinaryOutputter
+        :   public Outputter
+    {
+    public:
+        /// Initialize binary outputter.
+
+        /// @param stream Output stream. Must exist for the entire duration of
+        /// the outputter's use, and should be opened in binary mode.
+        BinaryOutputter(std::ostream& stream)
+            :   _stream(stream)
+        {
+
+        }
+
+
+        virtual void Begin(const std::size_t& enabledCount,
+                           const std::size_t& disabledCount)
+        {
+            uint8_t version[4];
+            EncodeUInt32(version, HAYAI_BINARY_VERSION);
+
+            _stream.write(HAYAI_BINARY_MAGIC, 8);
+            _stream.write(reinterpret_cast<const char*>(version), 4);
+
+            _buffer.clear();
+            PutUInt64(uint64_t(time(NULL)));
+            PutString(HostName());
+            PutUInt64(enabledCount);
+            PutUInt64(disabledCount);
+            WriteRecord(BinaryRecordBegin);
+        }
+
+
+        virtual void End(const std::size_t& executedCount,
+                         const std::size_t& disabledCount)
+        {
+            _buffer.clear();
+            PutUInt64(executedCount);
+            PutUInt64(disabledCount);
+            WriteRecord(BinaryRecordEnd);
+        }
+
+
+        virtual void Environment(const EnvironmentProperties& properties)
+        {
+            _buffer.clear();
+            PutUInt32(uint32_t(properties.size()));
+            for (std::size_t i = 0; i < properties.size(); ++i)
+            {
+                PutString(properties[i].first);
+                PutString(properties[i].second);
+            }
+            WriteRecord(BinaryRecordEnvironment);
+        }
+
+
+        virtual void BeginTest(const std::string& fixtureName,
+                               const std::string& testName,
+                               const TestParametersDescriptor& parameters,
+                               const std::size_t& runsCount,
+                               const std::size_t& iterationsCount)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)runsCount;
+            (void)iterationsCount;
+        }
+
+
+        virtual void SkipDisabledTest(const std::string& fixtureName,
+                                      const std::string& testName,
+                                      const TestParametersDescriptor&
+                                          parameters,
+                                      const std::size_t& runsCount,
+                                      const std::size_t& iterationsCount)
+        {
+            _buffer.clear();
+            PutTestName(fixtureName, testName, parameters);
+            PutUInt64(runsCount);
+            PutUInt64(iterationsCount);
+            WriteRecord(BinaryRecordDisabledTest);
+        }
+
+
+        virtual void EndTest(const std::string& fixtureName,
+                             const std::string& testName,
+                             const TestParametersDescriptor& parameters,
+                             const TestResult& result)
+        {
+            _buffer.clear();
+            PutTestName(fixtureName, testName, parameters);
+            PutString(result.Context());
+            PutUInt64(result.Iterations());
+            PutSection(BinarySectionRunTimes, result.RunTimes());
+            if (result.HasClock())
+            {
+                PutSection(BinarySectionRunCycles, result.RunCycles());
+                PutSection(BinarySectionRunActiveTimes,
+                           result.RunActiveTimes());
+            }
+            if (!result.Counters().empty())
+                PutCounters(result.Counters());
+            WriteRecord(BinaryRecordTest);
+        }
+
+
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            _buffer.clear();
+            PutTestName(fixtureName, testName, parameters);
+            PutString(reason);
+            PutString(context);
+            WriteRecord(BinaryRecordFailedTest);
+        }
+
+
+        virtual void EndComparison(const std::string& fixtureName,
+                                   const std::string& baselineName,
+                                   const std::string& candidateName,
+                                   const ComparisonResult& result)
+        {
+            _buffer.clear();
+            PutString(fixtureName);
+            PutString(baselineName);
+            PutString(candidateName);
+            PutString(result.Order());
+            PutString(result.Context());
+            PutUInt32(uint32_t(result.Pairs()));
+            for (std::size_t pair = 0; pair < result.Pairs(); ++pair)
+                PutDouble(result.BaselineTimes()[pair]);
+            for (std::size_t pair = 0; pair < result.Pairs(); ++pair)
+                PutDouble(result.CandidateTimes()[pair]);
+            WriteRecord(BinaryRecordComparison);
+        }
+
+
+        /// Encode a little-endian uint32.
+        static void EncodeUInt32(uint8_t* bytes, uint32_t value)
+        {
+            for (std::size_t i = 0; i < 4; ++i)
+                bytes[i] = uint8_t(value >> (8 * i));
+        }
+
+
+        /// Encode a little-endian uint64.
+        static void EncodeUInt64(uint8_t* bytes, uint64_t value)
+        {
+            for (std::size_t i = 0; i < 8; ++i)
+                bytes[i] = uint8_t(value >> (8 * i));
+        }
+    private:
+        void PutUInt32(uint32_t value)
+        {
+            uint8_t bytes[4];
+            EncodeUInt32(bytes, value);
+            _buffer.append(reinterpret_cast<const char*>(bytes), 4);
+        }
+
+
+        void PutUInt64(uint64_t value)
+        {
+            uint8_t bytes[8];
+            EncodeUInt64(bytes, value);
+            _buffer.append(reinterpret_cast<const char*>(bytes), 8);
+        }
+
+
+        void PutDouble(double value)
+        {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            PutUInt64(bits);
+        }
+
+
+        void PutString(const std::string& str)
+        {
+            PutUInt32(uint32_t(str.size()));
+            _buffer.append(str);
+        }
+
+
+        void PutTestName(const std::string& fixtureName,
+                         const std::string& testName,
+                         const TestParametersDescriptor& parameters)
+        {
+            const std::vector<TestParameterDescriptor>& descs =
+                parameters.Parameters();
+
+            PutString(fixtureName);
+            PutString(testName);
+            PutUInt32(uint32_t(descs.size()));
+            for (std::size_t i = 0; i < descs.size(); ++i)
+            {
+                PutString(descs[i].Declaration);
+                PutString(descs[i].Value);
+            }
+        }
+
+
+        void PutSection(BinarySectionType type,
+                        const std::vector<uint64_t>& values)
+        {
+            PutUInt32(uint32_t(type));
+            PutUInt32(uint32_t(values.size() * 8));
+            for (std::size_t i = 0; i < values.size(); ++i)
+                PutUInt64(values[i]);
+        }
+
+
+        void PutCounters(const std::vector<TestCounter>& counters)
+        {
+            PutUInt32(uint32_t(BinarySectionCounters));
+
+            // Patch the size in once the section is written.
+            const std::size_t sizeOffset = _buffer.size();
+            PutUInt32(0);
+
+            PutUInt32(uint32_t(counters.size()));
+            for (std::size_t i = 0; i < counters.size(); ++i)
+            {
+                const std::vector<double>& runValues = counters[i].RunValues;
+
+                PutString(counters[i].Name);
+                PutUInt32(uint32_t(counters[i].Type));
+                PutUInt32(uint32_t(runValues.size()));
+                for (std::size_t run = 0; run < runValues.size(); ++run)
+                    PutDouble(runValues[run]);
+            }
+
+            uint8_t size[4];
+            EncodeUInt32(size, uint32_t(_buffer.size() - sizeOffset - 4));
+            _buffer.replace(sizeOffset,
+                            4,
+                            reinterpret_cast<const char*>(size),
+                            4);
+        }
+
+
+        /// Write the buffered payload as one record and flush it.
+        void WriteRecord(BinaryRecordType type)
+        {
+            uint8_t header[8];
+            EncodeUInt32(header, uint32_t(type));
+            EncodeUInt32(header + 4, uint32_t(_buffer.size()));
+
+            _stream.write(reinterpret_cast<const char*>(header), 8);
+            _stream.write(_buffer.data(), std::streamsize(_buffer.size()));
+            _stream.flush();
+        }
+
+
+        std::ostream& _stream;
+        std::string _buffer;
+    };
+}
+#endif
@@ -0,0 +1,714 @@
+#ifndef __HAYAI_BINARYREADER
+#define __HAYAI_BINARYREADER
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hayai_binary_outputter.hpp"
+
+
+namespace hayai
+{
+    /// View of an array in a binary result file.
+
+    /// Decodes the little-endian values in place, so arrays of a file mapped
+    /// into memory can be read without copying them.
+    class BinaryArray
+    {
+    public:
+        BinaryArray()
+            :   _data(NULL),
+                _count(0)
+        {
+
+        }
+
+
+        BinaryArray(const uint8_t* data, std::size_t count)
+            :   _data(data),
+                _count(count)
+        {
+
+        }
+
+
+        /// Number of values.
+        inline std::size_t Size() const
+        {
+            return _count;
+        }
+
+
+        /// Whether the array is empty.
+        inline bool Empty() const
+        {
+            return (_count == 0);
+        }
+
+
+        /// Value as a uint64.
+        inline uint64_t operator[](std::size_t index) const
+        {
+            return DecodeUInt64(_data + index * 8);
+        }
+
+
+        /// Value as a double.
+        inline double Double(std::size_t index) const
+        {
+            const uint64_t bits = (*this)[index];
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+
+        /// Copy of the values as uint64.
+        std::vector<uint64_t> ToVector() const
+        {
+            std::vector<uint64_t> values(_count);
+            for (std::size_t i = 0; i < _count; ++i)
+                values[i] = (*this)[i];
+            return values;
+        }
+
+
+        /// Copy of the values as doubles.
+        std::vector<double> ToDoubleVector() const
+        {
+            std::vector<double> values(_count);
+            for (std::size_t i = 0; i < _count; ++i)
+                values[i] = Double(i);
+            return values;
+        }
+
+
+        /// Decode a little-endian uint32.
+        static uint32_t DecodeUInt32(const uint8_t* bytes)
+        {
+            return uint32_t(bytes[0]) |
+                (uint32_t(bytes[1]) << 8) |
+                (uint32_t(bytes[2]) << 16) |
+                (uint32_t(bytes[3]) << 24);
+        }
+
+
+        /// Decode a little-endian uint64.
+        static uint64_t DecodeUInt64(const uint8_t* bytes)
+        {
+            return uint64_t(DecodeUInt32(bytes)) |
+                (uint64_t(DecodeUInt32(bytes + 4)) << 32);
+        }
+    private:
+        const uint8_t* _data;
+        std::size_t _count;
+    };
+
+
+    /// Record of a binary result file.
+    struct BinaryRecord
+    {
+        BinaryRecord()
+            :   Type(0),
+                Data(NULL),
+                Size(0)
+        {
+
+        }
+
+
+        /// Record type, see @ref BinaryRecordType.
+        uint32_t Type;
+
+
+        /// Payload.
+        const uint8_t* Data;
+
+
+        /// Payload size in bytes.
+        std::size_t Size;
+    };
+
+
+    /// Begin record of a binary result file.
+    struct BinaryBeginRecord
+    {
+        BinaryBeginRecord()
+            :   Time(0),
+                EnabledCount(0),
+                DisabledCount(0)
+        {
+
+        }
+
+
+        /// UNIX time the run started at.
+        uint64_t Time;
+
+
+        /// Name of the host the run was on.
+        std::string Host;
+
+
+        /// Number of benchmarks to be executed.
+        uint64_t EnabledCount;
+
+
+        /// Number of disabled benchmarks.
+        uint64_t DisabledCount;
+    };
+
+
+    /// Counter of a test record of a binary result file.
+    struct BinaryCounter
+    {
+        BinaryCounter()
+            :   Type(0)
+        {
+
+        }
+
+
+        /// Name.
+        std::string Name;
+
+
+        /// Counter type, see @ref CounterType.
+        uint32_t Type;
+
+
+        /// Value per iteration in each run, as doubles.
+        BinaryArray RunValues;
+    };
+
+
+    /// Test record of a binary result file.
+
+    /// Describes completed, disabled and failed tests alike; which fields
+    /// are set depends on the record type.
+    struct BinaryTestRecord
+    {
+        BinaryTestRecord()
+            :   Runs(0),
+                Iterations(0)
+        {
+
+        }
+
+
+        /// Fixture name.
+        std::string Fixture;
+
+
+        /// Test name.
+        std::string Name;
+
+
+        /// Test parameters.
+        std::vector<TestParameterDescriptor> Parameters;
+
+
+        /// Execution context name, empty if none.
+        std::string Context;
+
+
+        /// Number of runs.
+        uint64_t Runs;
+
+
+        /// Iterations per run.
+        uint64_t Iterations;
+
+
+        /// Run times in nanoseconds.
+        BinaryArray RunTimes;
+
+
+        /// Core clock cycles per run, empty if not measured.
+        BinaryArray RunCycles;
+
+
+        /// Nanoseconds the benchmarking thread was running per run, empty if
+        /// not measured.
+        BinaryArray RunActiveTimes;
+
+
+        /// Counters reported by the test, empty if none.
+        std::vector<BinaryCounter> Counters;
+
+
+        /// Reason a failed test did not complete.
+        std::string FailReason;
+    };
+
+
+    /// Comparison record of a binary result file.
+    struct BinaryComparisonRecord
+    {
+        /// Fixture name.
+        std::string Fixture;
+
+
+        /// Baseline test name.
+        std::string Baseline;
+
+
+        /// Candidate test name.
+        std::string Candidate;
+
+
+        /// Pairing order.
+        std::string Order;
+
+
+        /// Execution context name, empty if none.
+        std::string Context;
+
+
+        /// Time per iteration of the baseline in each pair, as doubles.
+        BinaryArray BaselineTimes;
+
+
+        /// Time per iteration of the candidate in each pair, as doubles.
+        BinaryArray CandidateTimes;
+    };
+
+
+    /// Binary result reader.
+
+    /// Reads the output of @ref BinaryOutputter from memory, record by
+    /// record. The memory must stay valid for as long as the reader and any
+    /// records and arrays read from it are in use.
+    ///
+    /// @code
+    /// BinaryReader reader(data, size);
+    /// BinaryRecord record;
+    /// while (reader.Next(record))
+    ///     if (record.Type == BinaryRecordTest)
+    ///     {
+    ///         BinaryTestRecord test;
+    ///         BinaryReader::Decode(record, test);
+    ///         ..
+    ///     }
+    /// @endcode
+    class BinaryReader
+    {
+    public:
+        /// Initialize binary reader.
+
+        /// @param data Contents of a binary result file.
+        /// @param size Size of the contents in bytes.
+        /// @throws std::runtime_error if the contents are not a binary
+        /// result file, or of a newer version.
+        BinaryReader(const void* data, std::size_t size)
+            :   _data(static_cast<const uint8_t*>(data)),
+                _size(size),
+                _pos(12),
+                _version(0),
+                _truncated(false),
+                _complete(false)
+        {
+            if ((size < 12) || (memcmp(data, HAYAI_BINARY_MAGIC, 8) != 0))
+                throw std::runtime_error("not a hayai binary result file");
+
+            _version = BinaryArray::DecodeUInt32(_data + 8);
+
+            if (_version > HAYAI_BINARY_VERSION)
+            {
+                std::stringstream error;
+                error << "unsupported binary result file version "
+                      << _version;
+                throw std::runtime_error(error.str());
+            }
+        }
+
+
+        /// Format version of the file.
+        uint32_t Version() const
+        {
+            return _version;
+        }
+
+
+        /// Read the next record.
+
+        /// @param record Record to read into.
+        /// @returns false once there are no more complete records.
+        bool Next(BinaryRecord& record)
+        {
+            if (_size - _pos < 8)
+            {
+                _truncated = (_pos != _size);
+                return false;
+            }
+
+            const uint32_t type = BinaryArray::DecodeUInt32(_data + _pos);
+            const uint32_t size = BinaryArray::DecodeUInt32(_data + _pos + 4);
+
+            if (_size - _pos - 8 < size)
+            {
+                _truncated = true;
+                return false;
+            }
+
+            record.Type = type;
+            record.Data = _data + _pos + 8;
+            record.Size = size;
+            _pos += 8 + std::size_t(size);
+
+            if (type == BinaryRecordEnd)
+                _complete = true;
+
+            return true;
+        }
+
+
+        /// Whether the file ends in the middle of a record.
+        bool Truncated() const
+        {
+            return _truncated;
+        }
+
+
+        /// Whether an End record has been read, i.e. the run finished.
+        bool Complete() const
+        {
+            return _complete;
+        }
+
+
+        /// Decode a Begin record.
+        static void Decode(const BinaryRecord& record,
+                           BinaryBeginRecord& begin)
+        {
+            Cursor cursor(record);
+            begin.Time = cursor.UInt64();
+            begin.Host = cursor.String();
+            begin.EnabledCount = cursor.UInt64();
+            begin.DisabledCount = cursor.UInt64();
+        }
+
+
+        /// Decode an Environment record.
+        static void Decode(const BinaryRecord& record,
+                           EnvironmentProperties& properties)
+        {
+            Cursor cursor(record);
+            const uint32_t count = cursor.UInt32();
+
+            properties.clear();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const std::string name = cursor.String();
+                properties.push_back(std::make_pair(name, cursor.String()));
+            }
+        }
+
+
+        /// Decode a Test, Disabled test or Failed test record.
+        static void Decode(const BinaryRecord& record, BinaryTestRecord& test)
+        {
+            Cursor cursor(record);
+            test = BinaryTestRecord();
+            test.Fixture = cursor.String();
+            test.Name = cursor.String();
+
+            const uint32_t parameters = cursor.UInt32();
+            for (uint32_t i = 0; i < parameters; ++i)
+            {
+                const std::string declaration = cursor.String();
+                test.Parameters.push_back(
+                    TestParameterDescriptor(declaration, cursor.String())
+                );
+            }
+
+            switch (record.Type)
+            {
+            case BinaryRecordTest:
+                test.Context = cursor.String();
+                test.Iterations = cursor.UInt64();
+
+                while (!cursor.AtEnd())
+                {
+                    const uint32_t section = cursor.UInt32();
+                    const uint32_t size = cursor.UInt32();
+                    const uint8_t* data = cursor.Bytes(size);
+
+                    if (section == BinarySectionRunTimes)
+                        test.RunTimes = BinaryArray(data, size / 8);
+                    else if (section == BinarySectionRunCycles)
+                        test.RunCycles = BinaryArray(data, size / 8);
+                    else if (section == BinarySectionRunActiveTimes)
+                        test.RunActiveTimes = BinaryArray(data, size / 8);
+                    else if (section == BinarySectionCounters)
+                        DecodeCounters(data, size, test.Counters);
+                }
+
+                test.Runs = test.RunTimes.Size();
+                break;
+
+            case BinaryRecordDisabledTest:
+                test.Runs = cursor.UInt64();
+                test.Iterations = cursor.UInt64();
+                break;
+
+            case BinaryRecordFailedTest:
+                test.FailReason = cursor.String();
+                if (!cursor.AtEnd())
+                    test.Context = cursor.String();
+                break;
+
+            default:
+                throw std::runtime_error("not a test record");
+            }
+        }
+
+
+        /// Decode a Comparison record.
+        static void Decode(const BinaryRecord& record,
+                           BinaryComparisonRecord& comparison)
+        {
+            Cursor cursor(record);
+            comparison.Fixture = cursor.String();
+            comparison.Baseline = cursor.String();
+            comparison.Candidate = cursor.String();
+            comparison.Order = cursor.String();
+            comparison.Context = cursor.String();
+
+            const uint32_t pairs = cursor.UInt32();
+            comparison.BaselineTimes =
+                BinaryArray(cursor.Bytes(std::size_t(pairs) * 8), pairs);
+            comparison.CandidateTimes =
+                BinaryArray(cursor.Bytes(std::size_t(pairs) * 8), pairs);
+        }
+
+
+        /// Replay the file to an outputter.
+
+        /// Calls the outputter as the benchmarker did when the file was
+        /// written, e.g. to convert it to JSON with a @ref JsonOutputter. A
+        /// run that did not finish is ended after the last complete test.
+        ///
+        /// @param outputter Outputter to replay to.
+        /// @returns whether the run finished.
+        bool Replay(Outputter& outputter)
+        {
+            BinaryRecord record;
+            std::size_t executedCount = 0;
+            std::size_t disabledCount = 0;
+
+            while (Next(record))
+            {
+                switch (record.Type)
+                {
+                case BinaryRecordBegin:
+                {
+                    BinaryBeginRecord begin;
+                    Decode(record, begin);
+                    outputter.Begin(std::size_t(begin.EnabledCount),
+                                    std::size_t(begin.DisabledCount));
+                    break;
+                }
+
+                case BinaryRecordEnvironment:
+                {
+                    EnvironmentProperties properties;
+                    Decode(record, properties);
+                    outputter.Environment(properties);
+                    break;
+                }
+
+                case BinaryRecordTest:
+                {
+                    BinaryTestRecord test;
+                    Decode(record, test);
+                    const TestParametersDescriptor parameters(test.Parameters);
+
+                    TestResult result(test.RunTimes.ToVector(),
+                                      std::size_t(test.Iterations),
+                                      test.Context);
+                    if (!test.RunCycles.Empty())
+                        result.SetClock(test.RunCycles.ToVector(),
+                                        test.RunActiveTimes.ToVector());
+                    for (std::size_t i = 0; i < test.Counters.size(); ++i)
+                        result.AddCounter(
+                            test.Counters[i].Name,
+                            CounterType(test.Counters[i].Type),
+                            test.Counters[i].RunValues.ToDoubleVector()
+                        );
+
+                    outputter.BeginTest(test.Fixture,
+                                        test.Name,
+                                        parameters,
+                                        std::size_t(test.Runs),
+                                        std::size_t(test.Iterations));
+                    outputter.EndTest(test.Fixture,
+                                      test.Name,
+                                      parameters,
+                                      result);
+                    ++executedCount;
+                    break;
+                }
+
+                case BinaryRecordDisabledTest:
+                {
+                    BinaryTestRecord test;
+                    Decode(record, test);
+                    outputter.SkipDisabledTest(
+                        test.Fixture,
+                        test.Name,
+                        TestParametersDescriptor(test.Parameters),
+                        std::size_t(test.Runs),
+                        std::size_t(test.Iterations)
+                    );
+                    ++disabledCount;
+                    break;
+                }
+
+                case BinaryRecordFailedTest:
+                {
+                    BinaryTestRecord test;
+                    Decode(record, test);
+                    const TestParametersDescriptor parameters(test.Parameters);
+
+                    outputter.BeginTest(test.Fixture,
+                                        test.Name,
+                                        parameters,
+                                        0,
+                                        0);
+                    outputter.FailTest(test.Fixture,
+                                       test.Name,
+                                       parameters,
+                                       test.Context,
+                                       test.FailReason);
+                    break;
+                }
+
+                case BinaryRecordComparison:
+                {
+                    BinaryComparisonRecord comparison;
+                    Decode(record, comparison);
+                    outputter.EndComparison(
+                        comparison.Fixture,
+                        comparison.Baseline,
+                        comparison.Candidate,
+                        ComparisonResult(
+                            comparison.BaselineTimes.ToDoubleVector(),
+                            comparison.CandidateTimes.ToDoubleVector(),
+                            comparison.Order,
+                            comparison.Context
+                        )
+                    );
+                    break;
+                }
+
+                case BinaryRecordEnd:
+                {
+                    Cursor cursor(record);
+                    executedCount = std::size_t(cursor.UInt64());
+                    disabledCount = std::size_t(cursor.UInt64());
+                    break;
+                }
+
+                default:
+                    break;
+                }
+            }
+
+            outputter.End(executedCount, disabledCount);
+            return _complete;
+        }
+    private:
+        /// Decode a counters section.
+        static void DecodeCounters(const uint8_t* data,
+                                   std::size_t size,
+                                   std::vector<BinaryCounter>& counters)
+        {
+            BinaryRecord section;
+            section.Data = data;
+            section.Size = size;
+
+            Cursor cursor(section);
+            const uint32_t count = cursor.UInt32();
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                BinaryCounter counter;
+                counter.Name = cursor.String();
+                counter.Type = cursor.UInt32();
+
+                const uint32_t runs = cursor.UInt32();
+                counter.RunValues =
+                    BinaryArray(cursor.Bytes(std::size_t(runs) * 8), runs);
+                counters.push_back(counter);
+            }
+        }
+
+
+        /// Sequential decoder of a record payload.
+        class Cursor
+        {
+        public:
+            Cursor(const BinaryRecord& record)
+                :   _data(record.Data),
+                    _size(record.Size),
+                    _pos(0)
+            {
+
+            }
+
+
+            bool AtEnd() const
+            {
+                return (_pos == _size);
+            }
+
+
+            const uint8_t* Bytes(std::size_t count)
+            {
+                if (_size - _pos < count)
+                    throw std::runtime_error("binary result record too short");
+
+                const uint8_t* bytes = _data + _pos;
+                _pos += count;
+                return bytes;
+            }
+
+
+            uint32_t UInt32()
+            {
+                return BinaryArray::DecodeUInt32(Bytes(4));
+            }
+
+
+            uint64_t UInt64()
+            {
+                return BinaryArray::DecodeUInt64(Bytes(8));
+            }
+
+
+            std::string String()
+            {
+                const uint32_t length = UInt32();
+                const uint8_t* bytes = Bytes(length);
+                return std::string(reinterpret_cast<const char*>(bytes),
+                                   length);
+            }
+        private:
+            const uint8_t* _data;
+            std::size_t _size;
+            std::size_t _pos;
+        };
+
+
+        const uint8_t* _data;
+        std::size_t _size;
+        std::size_t _pos;
+        uint32_t _version;
+        bool _truncated;
+        bool _complete;
+    };
+}
+#endif
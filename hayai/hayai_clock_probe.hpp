@@ -0,0 +1,45 @@
+#ifndef __HAYAI_CLOCKPROBE
+#define __HAYAI_CLOCKPROBE
+#include "hayai_clock.hpp"
+
+
+namespace hayai
+{
+    /// Clock probe.
+
+    /// Abstract base class for measuring what the core clock of the
+    /// benchmarking thread did during the timed part of a run, e.g. with
+    /// performance counters. Turbo and thermal throttling change how much
+    /// work gets done per nanosecond, so the effective frequency is reported
+    /// alongside the run times when a probe is set.
+    class ClockProbe
+    {
+    public:
+        /// Start measuring on the calling thread.
+
+        /// Called right before the timed part of a run.
+        virtual void Start() = 0;
+
+
+        /// Stop measuring.
+
+        /// Called right after the timed part of a run, on the same thread.
+        virtual void Stop() = 0;
+
+
+        /// Read the measurement of the last run.
+
+        /// @param cycles Receives the number of core clock cycles elapsed.
+        /// @param activeTime Receives the number of nanoseconds the thread
+        /// was actually running, i.e. not counting time it was descheduled.
+        /// @returns false if nothing could be measured.
+        virtual bool Read(uint64_t& cycles, uint64_t& activeTime) const = 0;
+
+
+        virtual ~ClockProbe()
+        {
+
+        }
+    };
+}
+#endif
@@ -0,0 +1,255 @@
+#ifndef __HAYAI_COMPARISONRESULT
+#define __HAYAI_COMPARISONRESULT
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+
+namespace hayai
+{
+    /// Paired comparison result descriptor.
+
+    /// The outcome of running two tests in alternating pairs of runs, see
+    /// @ref Benchmarker::RegisterComparison. Every pair is one run of the
+    /// baseline and one run of the candidate back to back, so the two see
+    /// the same clock speed, temperature and background load, and drift
+    /// cancels out of the per-pair difference and ratio.
+    ///
+    /// All durations are expressed in nanoseconds per iteration.
+    struct ComparisonResult
+    {
+    public:
+        /// Initialize comparison result descriptor.
+
+        /// @param baselineTimes Time per iteration of the baseline in each
+        /// pair.
+        /// @param candidateTimes Time per iteration of the candidate in each
+        /// pair.
+        /// @param order Description of the order runs were paired in.
+        /// @param context Name of the execution context the pairs were run
+        /// in, empty if none.
+        ComparisonResult(const std::vector<double>& baselineTimes,
+                         const std::vector<double>& candidateTimes,
+                         const std::string& order,
+                         const std::string& context = std::string())
+            :   _baselineTimes(baselineTimes),
+                _candidateTimes(candidateTimes),
+                _order(order),
+                _context(context),
+                _differenceMean(0.0),
+                _differenceStdDev(0.0),
+                _differenceMedian(0.0),
+                _differenceQuartile1(0.0),
+                _differenceQuartile3(0.0),
+                _ratio(1.0),
+                _ratioLower(1.0),
+                _ratioUpper(1.0)
+        {
+            const std::size_t pairs = Pairs();
+            std::vector<double> differences;
+            std::vector<double> logRatios;
+
+            for (std::size_t pair = 0; pair < pairs; ++pair)
+            {
+                differences.push_back(_candidateTimes[pair] -
+                                      _baselineTimes[pair]);
+
+                if ((_baselineTimes[pair] > 0.0) &&
+                    (_candidateTimes[pair] > 0.0))
+                    logRatios.push_back(std::log(_candidateTimes[pair] /
+                                                 _baselineTimes[pair]));
+            }
+
+            // Difference distribution.
+            if (!differences.empty())
+            {
+                double sum = 0.0;
+                for (std::size_t i = 0; i < differences.size(); ++i)
+                    sum += differences[i];
+                _differenceMean = sum / double(differences.size());
+
+                if (differences.size() > 1)
+                {
+                    double accu = 0.0;
+                    for (std::size_t i = 0; i < differences.size(); ++i)
+                        accu += (differences[i] - _differenceMean) *
+                            (differences[i] - _differenceMean);
+                    _differenceStdDev =
+                        std::sqrt(accu / double(differences.size() - 1));
+                }
+
+                std::sort(differences.begin(), differences.end());
+                _differenceMedian = Quantile(differences, 0.5);
+                _differenceQuartile1 = Quantile(differences, 0.25);
+                _differenceQuartile3 = Quantile(differences, 0.75);
+            }
+
+            // Ratio as the geometric mean of the per-pair ratios, with a
+            // Student t confidence interval on the mean of their logarithms.
+            if (!logRatios.empty())
+            {
+                const double n = double(logRatios.size());
+                double sum = 0.0;
+                for (std::size_t i = 0; i < logRatios.size(); ++i)
+                    sum += logRatios[i];
+                const double mean = sum / n;
+
+                _ratio = _ratioLower = _ratioUpper = std::exp(mean);
+
+                if (logRatios.size() > 1)
+                {
+                    double accu = 0.0;
+                    for (std::size_t i = 0; i < logRatios.size(); ++i)
+                        accu += (logRatios[i] - mean) * (logRatios[i] - mean);
+                    const double standardError =
+                        std::sqrt(accu / (n - 1.0)) / std::sqrt(n);
+                    const double margin =
+                        StudentT975(n - 1.0) * standardError;
+
+                    _ratioLower = std::exp(mean - margin);
+                    _ratioUpper = std::exp(mean + margin);
+                }
+            }
+        }
+
+
+        /// Number of pairs.
+        inline std::size_t Pairs() const
+        {
+            return std::min(_baselineTimes.size(), _candidateTimes.size());
+        }
+
+
+        /// Time per iteration of the baseline in each pair.
+        inline const std::vector<double>& BaselineTimes() const
+        {
+            return _baselineTimes;
+        }
+
+
+        /// Time per iteration of the candidate in each pair.
+        inline const std::vector<double>& CandidateTimes() const
+        {
+            return _candidateTimes;
+        }
+
+
+        /// Pairing order, e.g. "ABBA" or "random".
+        inline const std::string& Order() const
+        {
+            return _order;
+        }
+
+
+        /// Execution context name.
+
+        /// Empty unless the pairs were run in an @ref ExecutionContext.
+        inline const std::string& Context() const
+        {
+            return _context;
+        }
+
+
+        /// Mean of candidate minus baseline time.
+        inline double DifferenceMean() const
+        {
+            return _differenceMean;
+        }
+
+        /// Standard deviation of candidate minus baseline time.
+        inline double DifferenceStdDev() const
+        {
+            return _differenceStdDev;
+        }
+
+        /// Median of candidate minus baseline time.
+        inline double DifferenceMedian() const
+        {
+            return _differenceMedian;
+        }
+
+        /// 1st Quartile of candidate minus baseline time.
+        inline double DifferenceQuartile1() const
+        {
+            return _differenceQuartile1;
+        }
+
+        /// 3rd Quartile of candidate minus baseline time.
+        inline double DifferenceQuartile3() const
+        {
+            return _differenceQuartile3;
+        }
+
+
+        /// Candidate over baseline time.
+
+        /// The geometric mean of the per-pair ratios; below 1 means the
+        /// candidate is faster.
+        inline double Ratio() const
+        {
+            return _ratio;
+        }
+
+        /// Lower bound of the 95% confidence interval of the ratio.
+        inline double RatioLower() const
+        {
+            return _ratioLower;
+        }
+
+        /// Upper bound of the 95% confidence interval of the ratio.
+        inline double RatioUpper() const
+        {
+            return _ratioUpper;
+        }
+    private:
+        /// Linearly interpolated quantile of sorted values.
+        static double Quantile(const std::vector<double>& sorted, double p)
+        {
+            const double h = p * double(sorted.size() - 1);
+            const std::size_t below = std::size_t(h);
+            const std::size_t above = std::min(below + 1, sorted.size() - 1);
+
+            return sorted[below] +
+                (h - double(below)) * (sorted[above] - sorted[below]);
+        }
+
+
+        /// 97.5th percentile of Student's t distribution.
+
+        /// Cornish-Fisher expansion around the normal quantile; within 1%
+        /// from 3 degrees of freedom on, which is plenty for an interval.
+        static double StudentT975(double degreesOfFreedom)
+        {
+            const double z = 1.959963984540054;
+            const double z3 = z * z * z;
+            const double z5 = z3 * z * z;
+            const double z7 = z5 * z * z;
+            const double v = degreesOfFreedom;
+
+            if (v < 1.0)
+                return z;
+
+            return z +
+                (z3 + z) / (4.0 * v) +
+                (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * v * v) +
+                (3.0 * z7 + 19.0 * z5 + 17.0 * z3 - 15.0 * z) /
+                (384.0 * v * v * v);
+        }
+
+
+        std::vector<double> _baselineTimes;
+        std::vector<double> _candidateTimes;
+        std::string _order;
+        std::string _context;
+        double _differenceMean;
+        double _differenceStdDev;
+        double _differenceMedian;
+        double _differenceQuartile1;
+        double _differenceQuartile3;
+        double _ratio;
+        double _ratioLower;
+        double _ratioUpper;
+    };
+}
+#endif
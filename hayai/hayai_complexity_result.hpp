@@ -0,0 +1,204 @@
+#ifndef __HAYAI_COMPLEXITYRESULT
+#define __HAYAI_COMPLEXITYRESULT
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+
+namespace hayai
+{
+    /// User-supplied complexity.
+
+    /// Maps the size of a problem to its expected relative cost, e.g.
+    /// [](double n) { return n * std::sqrt(n); }.
+    typedef double (*ComplexityFunction)(double n);
+
+
+    /// Least squares fit of a complexity.
+    struct ComplexityFit
+    {
+        ComplexityFit(const std::string& name,
+                      double coefficient,
+                      double rms)
+            :   Name(name),
+                Coefficient(coefficient),
+                Rms(rms)
+        {
+
+        }
+
+
+        /// Name, e.g. "O(n log n)".
+        std::string Name;
+
+
+        /// Coefficient, in nanoseconds per unit of the complexity.
+        double Coefficient;
+
+
+        /// Root mean square of the residuals relative to the mean time.
+        double Rms;
+    };
+
+
+    /// Complexity result descriptor.
+
+    /// Relates the time per iteration of a test run over a range of sizes,
+    /// see @ref Benchmarker::RegisterRange, to the usual complexities. Each
+    /// complexity f is fitted as time = coefficient * f(n) by least squares
+    /// and the one with the smallest residuals is the best fit, so a change
+    /// of best fit between two versions is an algorithmic regression that
+    /// timing a single size can miss.
+    ///
+    /// Logarithms are base 2. All durations are expressed in nanoseconds per
+    /// iteration.
+    struct ComplexityResult
+    {
+    public:
+        /// Initialize complexity result descriptor.
+
+        /// @param sizes Size of the problem in each test.
+        /// @param times Median time per iteration of each test.
+        /// @param context Name of the execution context the tests were run
+        /// in, empty if none.
+        /// @param complexity User-supplied complexity to fit as well, named
+        /// "f(n)", or NULL if none.
+        ComplexityResult(const std::vector<double>& sizes,
+                         const std::vector<double>& times,
+                         const std::string& context = std::string(),
+                         ComplexityFunction complexity = NULL)
+            :   _sizes(sizes),
+                _times(times),
+                _context(context),
+                _bestFit(0)
+        {
+            Fit("O(1)", Constant);
+            Fit("O(log n)", Logarithmic);
+            Fit("O(n)", Linear);
+            Fit("O(n log n)", Linearithmic);
+            Fit("O(n^2)", Quadratic);
+            if (complexity)
+                Fit("f(n)", complexity);
+
+            for (std::size_t i = 1; i < _fits.size(); ++i)
+                if (_fits[i].Rms < _fits[_bestFit].Rms)
+                    _bestFit = i;
+        }
+
+
+        /// Problem sizes.
+        inline const std::vector<double>& Sizes() const
+        {
+            return _sizes;
+        }
+
+
+        /// Median time per iteration at each size.
+        inline const std::vector<double>& Times() const
+        {
+            return _times;
+        }
+
+
+        /// Execution context name.
+
+        /// Empty unless the tests were run in an @ref ExecutionContext.
+        inline const std::string& Context() const
+        {
+            return _context;
+        }
+
+
+        /// Fits of every complexity, in order of increasing complexity with
+        /// the user-supplied one last.
+        inline const std::vector<ComplexityFit>& Fits() const
+        {
+            return _fits;
+        }
+
+
+        /// Fit with the smallest residuals.
+        inline const ComplexityFit& BestFit() const
+        {
+            return _fits[_bestFit];
+        }
+    private:
+        static double Constant(double n)
+        {
+            (void)n;
+            return 1.0;
+        }
+
+
+        static double Logarithmic(double n)
+        {
+            return std::log(n) / std::log(2.0);
+        }
+
+
+        static double Linear(double n)
+        {
+            return n;
+        }
+
+
+        static double Linearithmic(double n)
+        {
+            return n * Logarithmic(n);
+        }
+
+
+        static double Quadratic(double n)
+        {
+            return n * n;
+        }
+
+
+        /// Fit time = coefficient * complexity(n).
+        void Fit(const char* name, ComplexityFunction complexity)
+        {
+            const std::size_t count = std::min(_sizes.size(), _times.size());
+            double timeSum = 0.0;
+            double productSum = 0.0;
+            double squareSum = 0.0;
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const double f = complexity(_sizes[i]);
+
+                timeSum += _times[i];
+                productSum += _times[i] * f;
+                squareSum += f * f;
+            }
+
+            const double coefficient =
+                (squareSum > 0.0 ? productSum / squareSum : 0.0);
+            double residualSum = 0.0;
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const double residual =
+                    _times[i] - coefficient * complexity(_sizes[i]);
+                residualSum += residual * residual;
+            }
+
+            const double mean = (count ? timeSum / double(count) : 0.0);
+            const double rms = (count ?
+                                std::sqrt(residualSum / double(count)) :
+                                0.0);
+
+            _fits.push_back(ComplexityFit(name,
+                                          coefficient,
+                                          (mean > 0.0 ? rms / mean : rms)));
+        }
+
+
+        std::vector<double> _sizes;
+        std::vector<double> _times;
+        std::string _context;
+        std::vector<ComplexityFit> _fits;
+        std::size_t _bestFit;
+    };
+}
+#endif
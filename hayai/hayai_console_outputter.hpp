@@ -1,5 +1,7 @@
 #ifndef __HAYAI_CONSOLEOUTPUTTER
 #define __HAYAI_CONSOLEOUTPUTTER
+#include <sstream>
+
 #include "hayai_outputter.hpp"
 #include "hayai_console.hpp"
 
@@ -125,6 +127,22 @@ namespace hayai
         }
 
 
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            _stream << Console::TextRed << "[  FAILED  ]"
+                    << Console::TextYellow << " ";
+            WriteTestNameToStream(_stream, fixtureName, testName, parameters);
+            if (!context.empty())
+                _stream << Console::TextCyan << " [" << context << "]";
+            _stream << Console::TextDefault << " (" << reason << ")"
+                    << std::endl;
+        }
+
+
         virtual void EndTest(const std::string& fixtureName,
                              const std::string& testName,
                              const TestParametersDescriptor& parameters,
@@ -173,6 +191,8 @@ namespace hayai
             _stream << Console::TextGreen << "[     DONE ]"
                     << Console::TextYellow << " ";
             WriteTestNameToStream(_stream, fixtureName, testName, parameters);
+            if (!result.Context().empty())
+                _stream << Console::TextCyan << " [" << result.Context() << "]";
             _stream << Console::TextDefault << " ("
                     << std::setprecision(6)
                     << (result.TimeTotal() / 1000000.0) << " ms)"
@@ -272,12 +292,201 @@ namespace hayai
                 result.IterationsPerSecondQuartile3() <<
                 Console::TextDefault << ")");
 
+            if (result.HasClock())
+            {
+                PAD("");
+                _stream << Console::TextBlue << "[  CLOCK   ] "
+                        << Console::TextDefault
+                        << std::setprecision(3)
+                        << "  Average frequency: "
+                        << result.FrequencyAverage() << " GHz ("
+                        << Console::TextCyan << "min: "
+                        << result.FrequencyMinimum() << " GHz | max: "
+                        << result.FrequencyMaximum() << " GHz"
+                        << Console::TextDefault << ")"
+                        << std::endl;
+                PAD("Cycles per iteration: " <<
+                    std::setprecision(1) <<
+                    result.IterationCyclesAverage());
+            }
+
+            const std::vector<TestCounter>& counters = result.Counters();
+
+            for (std::size_t i = 0; i < counters.size(); ++i)
+            {
+                const std::string label = counters[i].Name + ": ";
+
+                if (i)
+                    _stream << std::setw(34) << label;
+                else
+                {
+                    PAD("");
+                    _stream << Console::TextBlue << "[ COUNTERS ] "
+                            << Console::TextDefault
+                            << std::setw(21) << label;
+                }
+
+                WriteCounterValue(counters[i]);
+                _stream << std::endl;
+            }
+
 #undef PAD_DEVIATION_INVERSE
 #undef PAD_DEVIATION
 #undef PAD
         }
 
 
+        virtual void EndComparison(const std::string& fixtureName,
+                                   const std::string& baselineName,
+                                   const std::string& candidateName,
+                                   const ComparisonResult& result)
+        {
+#define PAD(x) _stream << std::setw(34) << x << std::endl;
+            _stream << Console::TextGreen << "[ COMPARE  ]"
+                    << Console::TextYellow << " "
+                    << fixtureName << "." << baselineName << " vs "
+                    << fixtureName << "." << candidateName;
+            if (!result.Context().empty())
+                _stream << Console::TextCyan << " [" << result.Context() << "]";
+            _stream << Console::TextDefault << " ("
+                    << result.Pairs()
+                    << (result.Pairs() == 1 ? " pair, " : " pairs, ")
+                    << result.Order() << ")"
+                    << std::endl;
+
+            _stream << Console::TextBlue << "[  PAIRS   ] "
+                    << Console::TextDefault
+                    << std::setprecision(3)
+                    << "    Mean difference: "
+                    << (result.DifferenceMean() > 0.0 ? "+" : "")
+                    << result.DifferenceMean() / 1000.0 << " us "
+                    << "(" << Console::TextBlue << "~"
+                    << result.DifferenceStdDev() / 1000.0 << " us"
+                    << Console::TextDefault << ") per iteration"
+                    << std::endl;
+            PAD("Median difference: " <<
+                (result.DifferenceMedian() > 0.0 ? "+" : "") <<
+                result.DifferenceMedian() / 1000.0 << " us (" <<
+                Console::TextCyan << "1st quartile: " <<
+                result.DifferenceQuartile1() / 1000.0 <<
+                " us | 3rd quartile: " <<
+                result.DifferenceQuartile3() / 1000.0 << " us" <<
+                Console::TextDefault << ")");
+
+            // The candidate is only faster or slower if the whole interval
+            // is on one side of 1.
+            const bool faster = (result.RatioUpper() < 1.0);
+            const bool slower = (result.RatioLower() > 1.0);
+
+            PAD("");
+            _stream << Console::TextBlue << "[  RATIO   ] "
+                    << Console::TextDefault
+                    << std::setprecision(4)
+                    << "              Ratio: "
+                    << result.Ratio() << " ("
+                    << Console::TextCyan << "95% confidence: "
+                    << result.RatioLower() << " - "
+                    << result.RatioUpper()
+                    << Console::TextDefault << ")"
+                    << std::endl;
+            _stream << std::setw(34) << "Verdict: " << std::setprecision(3);
+            if (faster)
+                _stream << Console::TextGreen << candidateName << " is "
+                        << 1.0 / result.Ratio() << "x faster";
+            else if (slower)
+                _stream << Console::TextRed << candidateName << " is "
+                        << result.Ratio() << "x slower";
+            else
+                _stream << "no significant difference";
+            _stream << Console::TextDefault << std::endl;
+#undef PAD
+        }
+
+
+        virtual void EndComplexity(const std::string& fixtureName,
+                                   const std::string& testName,
+                                   const ComplexityResult& result)
+        {
+#define PAD(x) _stream << std::setw(34) << x << std::endl;
+            const std::vector<double>& sizes = result.Sizes();
+            const std::vector<double>& times = result.Times();
+            const std::vector<ComplexityFit>& fits = result.Fits();
+
+            _stream << Console::TextGreen << "[COMPLEXITY]"
+                    << Console::TextYellow << " "
+                    << fixtureName << "." << testName;
+            if (!result.Context().empty())
+                _stream << Console::TextCyan << " [" << result.Context() << "]";
+            _stream << Console::TextDefault << std::setprecision(0) << " ("
+                    << sizes.size() << " sizes, n = "
+                    << sizes.front() << " to " << sizes.back() << ")"
+                    << std::endl;
+
+            for (std::size_t i = 0; i < sizes.size(); ++i)
+            {
+                std::stringstream label;
+                label << "n = " << std::fixed << std::setprecision(0)
+                      << sizes[i] << ": ";
+
+                if (i)
+                    _stream << std::setw(34) << label.str();
+                else
+                    _stream << Console::TextBlue << "[  SIZES   ] "
+                            << Console::TextDefault
+                            << std::setw(21) << label.str();
+
+                _stream << std::setprecision(3) << times[i] / 1000.0
+                        << " us per iteration" << std::endl;
+            }
+
+            PAD("");
+            for (std::size_t i = 0; i < fits.size(); ++i)
+            {
+                if (i)
+                    _stream << std::setw(34) << (fits[i].Name + ": ");
+                else
+                    _stream << Console::TextBlue << "[   FITS   ] "
+                            << Console::TextDefault
+                            << std::setw(21) << (fits[i].Name + ": ");
+
+                _stream << std::setprecision(4) << fits[i].Coefficient
+                        << " ns per unit (" << Console::TextCyan << "RMS "
+                        << std::setprecision(1) << fits[i].Rms * 100.0
+                        << " %" << Console::TextDefault << ")" << std::endl;
+            }
+
+            _stream << std::setw(34) << "Best fit: " << Console::TextGreen
+                    << result.BestFit().Name << Console::TextDefault
+                    << std::endl;
+#undef PAD
+        }
+    private:
+        /// Write a counter value, rates with an SI prefix, e.g. 12.345 GB/s.
+        void WriteCounterValue(const TestCounter& counter)
+        {
+            _stream << std::setprecision(3);
+
+            if (counter.Type != CounterRate)
+            {
+                _stream << counter.Value;
+                return;
+            }
+
+            static const char* const prefixes[] = { "", "k", "M", "G", "T" };
+            double value = counter.Value;
+            std::size_t prefix = 0;
+
+            while ((value >= 1000.0) && (prefix < 4))
+            {
+                value /= 1000.0;
+                ++prefix;
+            }
+
+            _stream << value << " " << prefixes[prefix]
+                    << (counter.Name == "bytes" ? "B" : "") << "/s";
+        }
+
+
         std::ostream& _stream;
     };
 }
@@ -23,5 +23,38 @@ namespace hayai
             return new T();
         }
     };
+
+
+    /// Range test factory implementation.
+
+    /// Constructs an instance of the test of class @ref T for a single size
+    /// of a range, see @ref Benchmarker::RegisterRange.
+    ///
+    /// @tparam T Test class, constructible from the size.
+    template<class T>
+    class TestFactoryRange
+        :   public TestFactory
+    {
+    public:
+        /// Initialize the factory.
+
+        /// @param size Size of the problem.
+        TestFactoryRange(std::size_t size)
+            :   _size(size)
+        {
+
+        }
+
+
+        /// Create a test instance for the size.
+
+        /// @returns a pointer to an initialized test.
+        virtual Test* CreateTest()
+        {
+            return new T(_size);
+        }
+    private:
+        std::size_t _size;
+    };
 }
 #endif
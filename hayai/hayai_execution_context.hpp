@@ -0,0 +1,38 @@
+#ifndef __HAYAI_EXECUTIONCONTEXT
+#define __HAYAI_EXECUTIONCONTEXT
+#include <string>
+
+
+namespace hayai
+{
+    /// Execution context.
+
+    /// Abstract base class for the conditions a test can be run under, e.g.
+    /// with the benchmarking thread pinned to a particular type of core. When
+    /// contexts are registered with the benchmarker, every test is run once
+    /// in each of them and the results are tagged with the context name.
+    class ExecutionContext
+    {
+    public:
+        /// Name used to tag results.
+        virtual std::string Name() const = 0;
+
+
+        /// Enter the context on the calling thread.
+
+        /// @returns false if the context could not be entered, in which case
+        /// the test is not run in it.
+        virtual bool Enter() = 0;
+
+
+        /// Leave the context, restoring the calling thread's prior state.
+        virtual void Leave() = 0;
+
+
+        virtual ~ExecutionContext()
+        {
+
+        }
+    };
+}
+#endif
@@ -35,17 +35,84 @@ namespace hayai
     ///         },
     ///         "iterations_per_run": 10,
     ///         "disabled": false,
+    ///         "context": "P-core",
     ///         "runs": [{
-    ///             "duration": 3801.889831
+    ///             "duration": 3801.889831,
+    ///             "cycles": 12944723
+    ///         }, ..],
+    ///         "clock": {
+    ///             "ghz": 3.404812,
+    ///             "ghz_min": 3.391011,
+    ///             "ghz_max": 3.412950,
+    ///             "cycles_per_iteration": 1294472.3
+    ///         },
+    ///         "counters": [{
+    ///             "name": "bytes",
+    ///             "type": "rate",
+    ///             "value": 1073741824.000000
     ///         }, ..]
     ///     }, {
     ///         "fixture": "DeliveryMan",
     ///         "name": "DisabledTest",
     ///         "iterations_per_run": 10,
     ///         "disabled": true
-    ///     }, ..]
+    ///     }, ..],
+    ///     "comparisons": [{
+    ///         "fixture": "Sort",
+    ///         "baseline": "StdSort",
+    ///         "candidate": "RadixSort",
+    ///         "order": "ABBA",
+    ///         "context": "P-core",
+    ///         "pairs": [{
+    ///             "baseline": 0.012201,
+    ///             "candidate": 0.009817
+    ///         }, ..],
+    ///         "difference": {
+    ///             "mean": -0.002390,
+    ///             "std_dev": 0.000412,
+    ///             "median": -0.002401,
+    ///             "quartile_1": -0.002630,
+    ///             "quartile_3": -0.002157
+    ///         },
+    ///         "ratio": 0.804511,
+    ///         "ratio_lower": 0.790217,
+    ///         "ratio_upper": 0.819064
+    ///     }, ..],
+    ///     "complexities": [{
+    ///         "fixture": "Sort",
+    ///         "name": "StdSort",
+    ///         "context": "P-core",
+    ///         "sizes": [{
+    ///             "n": 64,
+    ///             "duration": 0.000412
+    ///         }, ..],
+    ///         "fits": [{
+    ///             "complexity": "O(n log n)",
+    ///             "coefficient": 1.074912e-06,
+    ///             "rms": 0.031207
+    ///         }, ..],
+    ///         "best_fit": "O(n log n)"
+    ///     }, ..],
+    ///     "environment": {
+    ///         "scaling_governor": "performance",
+    ///         ..
+    ///     }
     /// }
     ///
+    /// "context" is only present for tests run in an execution context. Tests
+    /// that did not complete have a "failed" property with the reason instead
+    /// of "runs" and the statistics. "cycles" and "clock" are only present if
+    /// the core clock was measured with a @ref ClockProbe. "counters" is only
+    /// present if the test reported any; the "value" of a "rate" is per second
+    /// and that of an "absolute" the average over the runs. "comparisons" is
+    /// only present if any paired comparisons were run, and gives the time per
+    /// iteration of each side of every pair; "ratio" is candidate over baseline
+    /// with its 95% confidence interval. "complexities" is only present if any
+    /// ranges were fitted, and gives the median time per iteration at each size
+    /// and every fit; "coefficient" is in milliseconds per unit of the
+    /// complexity and "rms" is relative to the mean time. "environment" is only
+    /// present if any environment properties were given.
+    ///
     /// All durations are represented as milliseconds.
     class JsonOutputter
         :   public Outputter
@@ -91,11 +158,106 @@ namespace hayai
             (void)disabledCount;
 
             _stream <<
-                JSON_ARRAY_END
+                JSON_ARRAY_END;
+
+            if (!_comparisons.empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "comparisons" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                    JSON_ARRAY_BEGIN;
+
+                for (std::size_t i = 0; i < _comparisons.size(); ++i)
+                {
+                    if (i)
+                        _stream << JSON_VALUE_SEPARATOR;
+
+                    WriteComparison(_comparisons[i]);
+                }
+
+                _stream <<
+                    JSON_ARRAY_END;
+            }
+
+            if (!_complexities.empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "complexities" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                    JSON_ARRAY_BEGIN;
+
+                for (std::size_t i = 0; i < _complexities.size(); ++i)
+                {
+                    if (i)
+                        _stream << JSON_VALUE_SEPARATOR;
+
+                    WriteComplexity(_complexities[i]);
+                }
+
+                _stream <<
+                    JSON_ARRAY_END;
+            }
+
+            if (!_environment.empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "environment" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                    JSON_OBJECT_BEGIN;
+
+                for (std::size_t i = 0; i < _environment.size(); ++i)
+                {
+                    if (i)
+                        _stream << JSON_VALUE_SEPARATOR;
+
+                    WriteString(_environment[i].first);
+                    _stream << JSON_NAME_SEPARATOR;
+                    WriteString(_environment[i].second);
+                }
+
+                _stream <<
+                    JSON_OBJECT_END;
+            }
+
+            _stream <<
                 JSON_OBJECT_END;
         }
 
 
+        virtual void Environment(const EnvironmentProperties& properties)
+        {
+            _environment = properties;
+        }
+
+
+        virtual void EndComparison(const std::string& fixtureName,
+                                   const std::string& baselineName,
+                                   const std::string& candidateName,
+                                   const ComparisonResult& result)
+        {
+            _comparisons.push_back(Comparison(fixtureName,
+                                              baselineName,
+                                              candidateName,
+                                              result));
+        }
+
+
+        virtual void EndComplexity(const std::string& fixtureName,
+                                   const std::string& testName,
+                                   const ComplexityResult& result)
+        {
+            _complexities.push_back(Complexity(fixtureName,
+                                               testName,
+                                               result));
+        }
+
+
         virtual void BeginTest(const std::string& fixtureName,
                                const std::string& testName,
                                const TestParametersDescriptor& parameters,
@@ -136,6 +298,17 @@ namespace hayai
             (void)testName;
             (void)parameters;
 
+            if (!result.Context().empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "context" JSON_STRING_END
+                    JSON_NAME_SEPARATOR;
+
+                WriteString(result.Context());
+            }
+
             _stream <<
                 JSON_VALUE_SEPARATOR
 
@@ -144,12 +317,11 @@ namespace hayai
                 JSON_ARRAY_BEGIN;
 
             const std::vector<uint64_t>& runTimes = result.RunTimes();
+            const std::vector<uint64_t>& runCycles = result.RunCycles();
 
-            for (std::vector<uint64_t>::const_iterator it = runTimes.begin();
-                 it != runTimes.end();
-                 ++it)
+            for (std::size_t run = 0; run < runTimes.size(); ++run)
             {
-                if (it != runTimes.begin())
+                if (run)
                     _stream << JSON_VALUE_SEPARATOR;
 
                 _stream << JSON_OBJECT_BEGIN
@@ -157,13 +329,95 @@ namespace hayai
                            JSON_NAME_SEPARATOR
                         << std::fixed
                         << std::setprecision(6)
-                        << (double(*it) / 1000000.0)
-                        << JSON_OBJECT_END;
+                        << (double(runTimes[run]) / 1000000.0);
+
+                if (run < runCycles.size())
+                    _stream << JSON_VALUE_SEPARATOR
+                               JSON_STRING_BEGIN "cycles" JSON_STRING_END
+                               JSON_NAME_SEPARATOR
+                            << runCycles[run];
+
+                _stream << JSON_OBJECT_END;
             }
 
             _stream <<
                 JSON_ARRAY_END;
 
+            if (result.HasClock())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "clock" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                    JSON_OBJECT_BEGIN
+
+                    JSON_STRING_BEGIN "ghz" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                        << std::fixed
+                        << std::setprecision(6)
+                        << result.FrequencyAverage() <<
+
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "ghz_min" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                        << result.FrequencyMinimum() <<
+
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "ghz_max" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                        << result.FrequencyMaximum() <<
+
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "cycles_per_iteration" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                        << std::setprecision(1)
+                        << result.IterationCyclesAverage() <<
+
+                    JSON_OBJECT_END;
+            }
+
+            const std::vector<TestCounter>& counters = result.Counters();
+
+            if (!counters.empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "counters" JSON_STRING_END
+                    JSON_NAME_SEPARATOR
+                    JSON_ARRAY_BEGIN;
+
+                for (std::size_t i = 0; i < counters.size(); ++i)
+                {
+                    if (i)
+                        _stream << JSON_VALUE_SEPARATOR;
+
+                    _stream << JSON_OBJECT_BEGIN
+                               JSON_STRING_BEGIN "name" JSON_STRING_END
+                               JSON_NAME_SEPARATOR;
+                    WriteString(counters[i].Name);
+                    _stream << JSON_VALUE_SEPARATOR
+                               JSON_STRING_BEGIN "type" JSON_STRING_END
+                               JSON_NAME_SEPARATOR
+                            << (counters[i].Type == CounterRate ?
+                                JSON_STRING_BEGIN "rate" JSON_STRING_END :
+                                JSON_STRING_BEGIN "absolute" JSON_STRING_END)
+                            << JSON_VALUE_SEPARATOR
+                               JSON_STRING_BEGIN "value" JSON_STRING_END
+                               JSON_NAME_SEPARATOR
+                            << std::fixed
+                            << std::setprecision(6)
+                            << counters[i].Value
+                            << JSON_OBJECT_END;
+                }
+
+                _stream << JSON_ARRAY_END;
+            }
+
             WriteDoubleProperty("mean", result.RunTimeAverage());
             WriteDoubleProperty("std_dev", result.RunTimeStdDev());
             WriteDoubleProperty("median", result.RunTimeMedian());
@@ -172,7 +426,324 @@ namespace hayai
 
             EndTestObject();
         }
+
+
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+
+            if (!context.empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "context" JSON_STRING_END
+                    JSON_NAME_SEPARATOR;
+
+                WriteString(context);
+            }
+
+            _stream <<
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "failed" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(reason);
+
+            EndTestObject();
+        }
     private:
+        /// Comparison to be written at the end.
+        struct Comparison
+        {
+            Comparison(const std::string& fixtureName,
+                       const std::string& baselineName,
+                       const std::string& candidateName,
+                       const ComparisonResult& result)
+                :   FixtureName(fixtureName),
+                    BaselineName(baselineName),
+                    CandidateName(candidateName),
+                    Result(result)
+            {
+
+            }
+
+
+            std::string FixtureName;
+            std::string BaselineName;
+            std::string CandidateName;
+            ComparisonResult Result;
+        };
+
+
+        /// Complexity fit to be written at the end.
+        struct Complexity
+        {
+            Complexity(const std::string& fixtureName,
+                       const std::string& testName,
+                       const ComplexityResult& result)
+                :   FixtureName(fixtureName),
+                    TestName(testName),
+                    Result(result)
+            {
+
+            }
+
+
+            std::string FixtureName;
+            std::string TestName;
+            ComplexityResult Result;
+        };
+
+
+        void WriteComparison(const Comparison& comparison)
+        {
+            const ComparisonResult& result = comparison.Result;
+
+            _stream <<
+                JSON_OBJECT_BEGIN
+
+                JSON_STRING_BEGIN "fixture" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(comparison.FixtureName);
+
+            _stream <<
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "baseline" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(comparison.BaselineName);
+
+            _stream <<
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "candidate" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(comparison.CandidateName);
+
+            _stream <<
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "order" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(result.Order());
+
+            if (!result.Context().empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "context" JSON_STRING_END
+                    JSON_NAME_SEPARATOR;
+
+                WriteString(result.Context());
+            }
+
+            _stream <<
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "pairs" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                JSON_ARRAY_BEGIN;
+
+            for (std::size_t pair = 0; pair < result.Pairs(); ++pair)
+            {
+                if (pair)
+                    _stream << JSON_VALUE_SEPARATOR;
+
+                _stream << JSON_OBJECT_BEGIN
+                           JSON_STRING_BEGIN "baseline" JSON_STRING_END
+                           JSON_NAME_SEPARATOR
+                        << std::fixed
+                        << std::setprecision(6)
+                        << (result.BaselineTimes()[pair] / 1000000.0)
+                        << JSON_VALUE_SEPARATOR
+                           JSON_STRING_BEGIN "candidate" JSON_STRING_END
+                           JSON_NAME_SEPARATOR
+                        << (result.CandidateTimes()[pair] / 1000000.0)
+                        << JSON_OBJECT_END;
+            }
+
+            _stream <<
+                JSON_ARRAY_END
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "difference" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                JSON_OBJECT_BEGIN
+
+                JSON_STRING_BEGIN "mean" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << (result.DifferenceMean() / 1000000.0) <<
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "std_dev" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << (result.DifferenceStdDev() / 1000000.0) <<
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "median" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << (result.DifferenceMedian() / 1000000.0) <<
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "quartile_1" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << (result.DifferenceQuartile1() / 1000000.0) <<
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "quartile_3" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << (result.DifferenceQuartile3() / 1000000.0) <<
+
+                JSON_OBJECT_END
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "ratio" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << result.Ratio() <<
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "ratio_lower" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << result.RatioLower() <<
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "ratio_upper" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                    << result.RatioUpper() <<
+
+                JSON_OBJECT_END;
+        }
+
+
+        void WriteComplexity(const Complexity& complexity)
+        {
+            const ComplexityResult& result = complexity.Result;
+
+            _stream <<
+                JSON_OBJECT_BEGIN
+
+                JSON_STRING_BEGIN "fixture" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(complexity.FixtureName);
+
+            _stream <<
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "name" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(complexity.TestName);
+
+            if (!result.Context().empty())
+            {
+                _stream <<
+                    JSON_VALUE_SEPARATOR
+
+                    JSON_STRING_BEGIN "context" JSON_STRING_END
+                    JSON_NAME_SEPARATOR;
+
+                WriteString(result.Context());
+            }
+
+            _stream <<
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "sizes" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                JSON_ARRAY_BEGIN;
+
+            for (std::size_t i = 0; i < result.Sizes().size(); ++i)
+            {
+                if (i)
+                    _stream << JSON_VALUE_SEPARATOR;
+
+                _stream << JSON_OBJECT_BEGIN
+                           JSON_STRING_BEGIN "n" JSON_STRING_END
+                           JSON_NAME_SEPARATOR
+                        << std::fixed
+                        << std::setprecision(0)
+                        << result.Sizes()[i]
+                        << JSON_VALUE_SEPARATOR
+                           JSON_STRING_BEGIN "duration" JSON_STRING_END
+                           JSON_NAME_SEPARATOR
+                        << std::setprecision(6)
+                        << (result.Times()[i] / 1000000.0)
+                        << JSON_OBJECT_END;
+            }
+
+            _stream <<
+                JSON_ARRAY_END
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "fits" JSON_STRING_END
+                JSON_NAME_SEPARATOR
+                JSON_ARRAY_BEGIN;
+
+            for (std::size_t i = 0; i < result.Fits().size(); ++i)
+            {
+                const ComplexityFit& fit = result.Fits()[i];
+
+                if (i)
+                    _stream << JSON_VALUE_SEPARATOR;
+
+                _stream << JSON_OBJECT_BEGIN
+                           JSON_STRING_BEGIN "complexity" JSON_STRING_END
+                           JSON_NAME_SEPARATOR;
+
+                WriteString(fit.Name);
+
+                _stream << JSON_VALUE_SEPARATOR
+                           JSON_STRING_BEGIN "coefficient" JSON_STRING_END
+                           JSON_NAME_SEPARATOR
+                        << std::scientific
+                        << std::setprecision(6)
+                        << (fit.Coefficient / 1000000.0)
+                        << JSON_VALUE_SEPARATOR
+                           JSON_STRING_BEGIN "rms" JSON_STRING_END
+                           JSON_NAME_SEPARATOR
+                        << std::fixed
+                        << fit.Rms
+                        << JSON_OBJECT_END;
+            }
+
+            _stream <<
+                JSON_ARRAY_END
+
+                JSON_VALUE_SEPARATOR
+
+                JSON_STRING_BEGIN "best_fit" JSON_STRING_END
+                JSON_NAME_SEPARATOR;
+
+            WriteString(result.BestFit().Name);
+
+            _stream <<
+                JSON_OBJECT_END;
+        }
+
+
         void BeginTestObject(const std::string& fixtureName,
                              const std::string& testName,
                              const TestParametersDescriptor& parameters,
@@ -338,6 +909,9 @@ namespace hayai
 
         std::ostream& _stream;
         bool _firstTest;
+        EnvironmentProperties _environment;
+        std::vector<Comparison> _comparisons;
+        std::vector<Complexity> _complexities;
     };
 }
 
@@ -0,0 +1,481 @@
+#ifndef __HAYAI_JSONREADER
+#define __HAYAI_JSONREADER
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace hayai
+{
+    /// JSON value.
+
+    /// A parsed JSON document; enough of JSON to read back what
+    /// @ref JsonOutputter writes. Objects keep their members in document
+    /// order.
+    class JsonValue
+    {
+    public:
+        /// Value type.
+        enum Type
+        {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+
+        /// Object members.
+        typedef std::vector<std::pair<std::string, JsonValue> > MemberList;
+
+
+        JsonValue()
+            :   _type(Null),
+                _boolean(false),
+                _number(0.0)
+        {
+
+        }
+
+
+        /// Parse a JSON document.
+
+        /// @param text Document.
+        /// @returns the root value.
+        /// @throws std::runtime_error if the document is not valid JSON.
+        static JsonValue Parse(const std::string& text)
+        {
+            Parser parser(text);
+            JsonValue value;
+
+            parser.SkipWhitespace();
+            parser.ParseValue(value);
+            parser.SkipWhitespace();
+
+            if (!parser.AtEnd())
+                parser.Fail("trailing characters");
+
+            return value;
+        }
+
+
+        /// Parse a JSON document from a file.
+
+        /// @param path Path of the file.
+        /// @returns the root value.
+        /// @throws std::runtime_error if the file cannot be read or is not
+        /// valid JSON.
+        static JsonValue ParseFile(const char* path)
+        {
+            std::ifstream file(path,
+                               std::ios_base::in | std::ios_base::binary);
+            if (!file)
+            {
+                std::stringstream error;
+                error << "failed to open " << path << " for reading: "
+                      << strerror(errno);
+                throw std::runtime_error(error.str());
+            }
+
+            std::stringstream contents;
+            contents << file.rdbuf();
+
+            try
+            {
+                return Parse(contents.str());
+            }
+            catch (std::runtime_error& e)
+            {
+                throw std::runtime_error(std::string(path) + ": " + e.what());
+            }
+        }
+
+
+        /// Value type.
+        Type GetType() const
+        {
+            return _type;
+        }
+
+
+        /// Boolean value, or false if the value is not a boolean.
+        bool AsBoolean() const
+        {
+            return _boolean;
+        }
+
+
+        /// Numeric value, or 0 if the value is not a number.
+        double AsNumber() const
+        {
+            return _number;
+        }
+
+
+        /// String value, or empty if the value is not a string.
+        const std::string& AsString() const
+        {
+            return _string;
+        }
+
+
+        /// Number of array elements, or 0 if the value is not an array.
+        std::size_t Size() const
+        {
+            return _elements.size();
+        }
+
+
+        /// Array element.
+
+        /// @param index Index of the element.
+        /// @returns the element, or a null value if out of range.
+        const JsonValue& operator[](std::size_t index) const
+        {
+            if (index < _elements.size())
+                return _elements[index];
+
+            return NullValue();
+        }
+
+
+        /// Object member.
+
+        /// @param name Name of the member.
+        /// @returns the member, or a null value if there is no such member.
+        const JsonValue& operator[](const std::string& name) const
+        {
+            for (MemberList::const_iterator it = _members.begin();
+                 it != _members.end();
+                 ++it)
+                if (it->first == name)
+                    return it->second;
+
+            return NullValue();
+        }
+
+
+        /// Object members, or empty if the value is not an object.
+        const MemberList& Members() const
+        {
+            return _members;
+        }
+    private:
+        static const JsonValue& NullValue()
+        {
+            static const JsonValue null;
+            return null;
+        }
+
+
+        /// Recursive descent parser.
+        class Parser
+        {
+        public:
+            Parser(const std::string& text)
+                :   _text(text),
+                    _pos(0)
+            {
+
+            }
+
+
+            bool AtEnd() const
+            {
+                return (_pos == _text.size());
+            }
+
+
+            void Fail(const char* what) const
+            {
+                std::stringstream error;
+                error << "invalid JSON at offset " << _pos << ": " << what;
+                throw std::runtime_error(error.str());
+            }
+
+
+            void SkipWhitespace()
+            {
+                while ((!AtEnd()) &&
+                       ((_text[_pos] == ' ') ||
+                        (_text[_pos] == '\t') ||
+                        (_text[_pos] == '\n') ||
+                        (_text[_pos] == '\r')))
+                    ++_pos;
+            }
+
+
+            void ParseValue(JsonValue& value)
+            {
+                if (AtEnd())
+                    Fail("unexpected end of document");
+
+                switch (_text[_pos])
+                {
+                case '{':
+                    ParseObject(value);
+                    break;
+
+                case '[':
+                    ParseArray(value);
+                    break;
+
+                case '"':
+                    value._type = String;
+                    ParseString(value._string);
+                    break;
+
+                case 't':
+                    ExpectLiteral("true");
+                    value._type = Boolean;
+                    value._boolean = true;
+                    break;
+
+                case 'f':
+                    ExpectLiteral("false");
+                    value._type = Boolean;
+                    value._boolean = false;
+                    break;
+
+                case 'n':
+                    ExpectLiteral("null");
+                    value._type = Null;
+                    break;
+
+                default:
+                    ParseNumber(value);
+                    break;
+                }
+            }
+        private:
+            void Expect(char c)
+            {
+                if ((AtEnd()) || (_text[_pos] != c))
+                {
+                    std::string what("expected '");
+                    what += c;
+                    what += "'";
+                    Fail(what.c_str());
+                }
+
+                ++_pos;
+            }
+
+
+            void ExpectLiteral(const char* literal)
+            {
+                const std::size_t length = strlen(literal);
+
+                if (_text.compare(_pos, length, literal) != 0)
+                    Fail("invalid literal");
+
+                _pos += length;
+            }
+
+
+            void ParseObject(JsonValue& value)
+            {
+                value._type = Object;
+                Expect('{');
+                SkipWhitespace();
+
+                if ((!AtEnd()) && (_text[_pos] == '}'))
+                {
+                    ++_pos;
+                    return;
+                }
+
+                for (;;)
+                {
+                    SkipWhitespace();
+                    value._members.push_back(
+                        std::make_pair(std::string(), JsonValue())
+                    );
+                    ParseString(value._members.back().first);
+                    SkipWhitespace();
+                    Expect(':');
+                    SkipWhitespace();
+                    ParseValue(value._members.back().second);
+                    SkipWhitespace();
+
+                    if ((!AtEnd()) && (_text[_pos] == ','))
+                    {
+                        ++_pos;
+                        continue;
+                    }
+
+                    Expect('}');
+                    return;
+                }
+            }
+
+
+            void ParseArray(JsonValue& value)
+            {
+                value._type = Array;
+                Expect('[');
+                SkipWhitespace();
+
+                if ((!AtEnd()) && (_text[_pos] == ']'))
+                {
+                    ++_pos;
+                    return;
+                }
+
+                for (;;)
+                {
+                    SkipWhitespace();
+                    value._elements.push_back(JsonValue());
+                    ParseValue(value._elements.back());
+                    SkipWhitespace();
+
+                    if ((!AtEnd()) && (_text[_pos] == ','))
+                    {
+                        ++_pos;
+                        continue;
+                    }
+
+                    Expect(']');
+                    return;
+                }
+            }
+
+
+            void ParseString(std::string& str)
+            {
+                Expect('"');
+
+                for (;;)
+                {
+                    if (AtEnd())
+                        Fail("unterminated string");
+
+                    char c = _text[_pos++];
+
+                    if (c == '"')
+                        return;
+                    else if (c != '\\')
+                    {
+                        str += c;
+                        continue;
+                    }
+
+                    if (AtEnd())
+                        Fail("unterminated string");
+
+                    c = _text[_pos++];
+
+                    switch (c)
+                    {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        str += c;
+                        break;
+
+                    case 'b':
+                        str += '\b';
+                        break;
+
+                    case 'f':
+                        str += '\f';
+                        break;
+
+                    case 'n':
+                        str += '\n';
+                        break;
+
+                    case 'r':
+                        str += '\r';
+                        break;
+
+                    case 't':
+                        str += '\t';
+                        break;
+
+                    case 'u':
+                        AppendCodePoint(str, ParseHex4());
+                        break;
+
+                    default:
+                        Fail("invalid escape sequence");
+                    }
+                }
+            }
+
+
+            unsigned long ParseHex4()
+            {
+                if (_pos + 4 > _text.size())
+                    Fail("invalid unicode escape");
+
+                const std::string digits = _text.substr(_pos, 4);
+                char* end;
+                const unsigned long codePoint =
+                    strtoul(digits.c_str(), &end, 16);
+
+                if (*end)
+                    Fail("invalid unicode escape");
+
+                _pos += 4;
+                return codePoint;
+            }
+
+
+            /// Append a code point from the basic multilingual plane as UTF-8.
+            static void AppendCodePoint(std::string& str,
+                                        unsigned long codePoint)
+            {
+                if (codePoint < 0x80)
+                    str += char(codePoint);
+                else if (codePoint < 0x800)
+                {
+                    str += char(0xc0 | (codePoint >> 6));
+                    str += char(0x80 | (codePoint & 0x3f));
+                }
+                else
+                {
+                    str += char(0xe0 | (codePoint >> 12));
+                    str += char(0x80 | ((codePoint >> 6) & 0x3f));
+                    str += char(0x80 | (codePoint & 0x3f));
+                }
+            }
+
+
+            void ParseNumber(JsonValue& value)
+            {
+                const char* begin = _text.c_str() + _pos;
+                char* end;
+                const double number = strtod(begin, &end);
+
+                if (end == begin)
+                    Fail("unexpected character");
+
+                value._type = Number;
+                value._number = number;
+                _pos += std::size_t(end - begin);
+            }
+
+
+            const std::string& _text;
+            std::size_t _pos;
+        };
+
+
+        Type _type;
+        bool _boolean;
+        double _number;
+        std::string _string;
+        std::vector<JsonValue> _elements;
+        MemberList _members;
+    };
+}
+#endif
@@ -5,6 +5,7 @@
 #include <vector>
 #include <sstream>
 #include <map>
+#include <utility>
 
 #include "hayai_outputter.hpp"
 
@@ -31,6 +32,8 @@ namespace hayai
                                       fixtureName,
                                       testName,
                                       parameters);
+                if ((result) && (!result->Context().empty()))
+                    nameStream << " [" << result->Context() << "]";
                 Name = nameStream.str();
 
                 // Derive the result.
@@ -43,12 +46,33 @@ namespace hayai
                                << std::setprecision(9)
                                << (result->IterationTimeAverage() / 1e9);
                     Time = timeStream.str();
+
+                    // Counters become properties, rates named per second.
+                    const std::vector<TestCounter>& counters =
+                        result->Counters();
+
+                    for (std::size_t i = 0; i < counters.size(); ++i)
+                    {
+                        std::stringstream valueStream;
+                        valueStream << std::fixed
+                                    << std::setprecision(6)
+                                    << counters[i].Value;
+                        Properties.push_back(std::make_pair(
+                            counters[i].Name +
+                            (counters[i].Type == CounterRate ?
+                             "_per_second" :
+                             ""),
+                            valueStream.str()
+                        ));
+                    }
                 }
             }
 
 
             std::string Name;
             std::string Time;
+            std::vector<std::pair<std::string, std::string> > Properties;
+            std::string Failure;
             bool Skipped;
         };
 
@@ -105,7 +129,36 @@ namespace hayai
                     WriteEscapedString(testCaseIt->Name);
                     _stream << "\"";
 
-                    if (!testCaseIt->Skipped)
+                    if (!testCaseIt->Failure.empty())
+                    {
+                        _stream << ">" << std::endl
+                                << "            <failure message=\"";
+                        WriteEscapedString(testCaseIt->Failure);
+                        _stream << "\" />" << std::endl
+                                << "        </testcase>" << std::endl;
+                    }
+                    else if ((!testCaseIt->Skipped) &&
+                             (!testCaseIt->Properties.empty()))
+                    {
+                        _stream << " time=\"" << testCaseIt->Time << "\">"
+                                << std::endl
+                                << "            <properties>" << std::endl;
+
+                        for (std::size_t i = 0;
+                             i < testCaseIt->Properties.size();
+                             ++i)
+                        {
+                            _stream << "                <property name=\"";
+                            WriteEscapedString(testCaseIt->Properties[i].first);
+                            _stream << "\" value=\""
+                                    << testCaseIt->Properties[i].second
+                                    << "\" />" << std::endl;
+                        }
+
+                        _stream << "            </properties>" << std::endl
+                                << "        </testcase>" << std::endl;
+                    }
+                    else if (!testCaseIt->Skipped)
                         _stream << " time=\"" << testCaseIt->Time << "\" />"
                                 << std::endl;
                     else
@@ -208,6 +261,20 @@ namespace hayai
             EndTestObject();
             */
         }
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            TestCase testCase(fixtureName, testName, parameters, NULL);
+            if (!context.empty())
+                testCase.Name += " [" + context + "]";
+            testCase.Skipped = false;
+            testCase.Failure = reason;
+
+            _testSuites[fixtureName].push_back(testCase);
+        }
     private:
         /// Write an escaped string.
 
@@ -135,6 +135,9 @@ namespace hayai
     FILE_OUTPUTTER_IMPLEMENTATION(Json);
     FILE_OUTPUTTER_IMPLEMENTATION(Console);
     FILE_OUTPUTTER_IMPLEMENTATION(JUnitXml);
+    FILE_OUTPUTTER_IMPLEMENTATION(Binary);
+    FILE_OUTPUTTER_IMPLEMENTATION(Trace);
+    FILE_OUTPUTTER_IMPLEMENTATION(OpenMetrics);
 
 #undef FILE_OUTPUTTER_IMPLEMENTATION
 
@@ -146,7 +149,12 @@ namespace hayai
         MainRunner()
             :   ExecutionMode(MainRunBenchmarks),
                 ShuffleBenchmarks(false),
-                StdoutOutputter(NULL)
+                IsolateBenchmarks(false),
+                Jobs(1),
+                BaselinePath(NULL),
+                RegressionThreshold(0.05),
+                StdoutOutputter(NULL),
+                _baselineOutputter(NULL)
         {
 
         }
@@ -163,6 +171,9 @@ namespace hayai
 
             if (StdoutOutputter)
                 delete StdoutOutputter;
+
+            if (_baselineOutputter)
+                delete _baselineOutputter;
         }
 
 
@@ -174,6 +185,37 @@ namespace hayai
         bool ShuffleBenchmarks;
 
 
+        /// Run each benchmark in a child process of its own.
+        bool IsolateBenchmarks;
+
+
+        /// Number of shards to run benchmarks in concurrently.
+        std::size_t Jobs;
+
+
+        /// Shard contexts.
+        ///
+        /// If set, one context per shard to confine it to resources of its
+        /// own, and takes precedence over @ref Jobs. Expected to be available
+        /// during the life time of the runner.
+        std::vector<ExecutionContext*> ShardContexts;
+
+
+        /// Baseline path.
+        ///
+        /// If set, the path of an earlier JSON result to compare the results
+        /// against. Expected to be available during the life time of the
+        /// runner.
+        const char* BaselinePath;
+
+
+        /// Regression threshold.
+        ///
+        /// Relative slowdown compared to the baseline beyond which a
+        /// significant change fails the run, e.g. 0.05 for 5%.
+        double RegressionThreshold;
+
+
         /// File outputters.
         ///
         /// Outputter will be freed by the class on destruction.
@@ -218,6 +260,83 @@ namespace hayai
                 // Shuffle flag.
                 else if ((!strcmp(arg, "-s")) || (!strcmp(arg, "--shuffle")))
                     ShuffleBenchmarks = true;
+                // Isolate flag.
+                else if ((!strcmp(arg, "-i")) || (!strcmp(arg, "--isolate")))
+                    IsolateBenchmarks = true;
+                // Jobs flag.
+                else if ((!strcmp(arg, "-j")) || (!strcmp(arg, "--jobs")))
+                {
+                    if (argLast)
+                        HAYAI_MAIN_USAGE_ERROR(HAYAI_MAIN_FORMAT_FLAG(arg) <<
+                                    " requires a count to be specified");
+                    char* count = argv[argI++];
+                    char* end;
+                    const unsigned long jobs = strtoul(count, &end, 10);
+
+                    if ((*end) || (end == count) || (jobs == 0))
+                        HAYAI_MAIN_USAGE_ERROR(
+                            "invalid argument to " <<
+                            HAYAI_MAIN_FORMAT_FLAG(arg) <<
+                            ": " << count
+                        );
+
+                    Jobs = std::size_t(jobs);
+                }
+                // Comparison order flag.
+                else if (!strcmp(arg, "--pair-order"))
+                {
+                    if (argLast)
+                        HAYAI_MAIN_USAGE_ERROR(
+                            HAYAI_MAIN_FORMAT_FLAG(arg) <<
+                            " requires an argument " <<
+                            "of either " << HAYAI_MAIN_FORMAT_FLAG("abba") <<
+                            " or " << HAYAI_MAIN_FORMAT_FLAG("random")
+                        );
+
+                    char* choice = argv[argI++];
+
+                    if (!strcmp(choice, "abba"))
+                        ::hayai::Benchmarker::SetComparisonOrder(
+                            ::hayai::ComparisonOrderABBA
+                        );
+                    else if (!strcmp(choice, "random"))
+                        ::hayai::Benchmarker::SetComparisonOrder(
+                            ::hayai::ComparisonOrderRandom
+                        );
+                    else
+                        HAYAI_MAIN_USAGE_ERROR(
+                            "invalid argument to " <<
+                            HAYAI_MAIN_FORMAT_FLAG(arg) <<
+                            ": " << choice
+                        );
+                }
+                // Baseline flag.
+                else if (!strcmp(arg, "--baseline"))
+                {
+                    if ((argLast) || (*argv[argI] == 0))
+                        HAYAI_MAIN_USAGE_ERROR(HAYAI_MAIN_FORMAT_FLAG(arg) <<
+                                    " requires a path to be specified");
+                    BaselinePath = argv[argI++];
+                }
+                // Regression threshold flag.
+                else if (!strcmp(arg, "--regression-threshold"))
+                {
+                    if (argLast)
+                        HAYAI_MAIN_USAGE_ERROR(HAYAI_MAIN_FORMAT_FLAG(arg) <<
+                                    " requires a percentage to be specified");
+                    char* percentage = argv[argI++];
+                    char* end;
+                    const double threshold = strtod(percentage, &end);
+
+                    if ((*end) || (end == percentage) || (threshold < 0.0))
+                        HAYAI_MAIN_USAGE_ERROR(
+                            "invalid argument to " <<
+                            HAYAI_MAIN_FORMAT_FLAG(arg) <<
+                            ": " << percentage
+                        );
+
+                    RegressionThreshold = threshold / 100.0;
+                }
                 // Filter flag.
                 else if ((!strcmp(arg, "-f")) || (!strcmp(arg, "--filter")))
                 {
@@ -266,6 +385,12 @@ namespace hayai
                         ADD_OUTPUTTER(Json)
                     else if (!strcmp(format, "junit"))
                         ADD_OUTPUTTER(JUnitXml)
+                    else if (!strcmp(format, "binary"))
+                        ADD_OUTPUTTER(Binary)
+                    else if (!strcmp(format, "trace"))
+                        ADD_OUTPUTTER(Trace)
+                    else if (!strcmp(format, "openmetrics"))
+                        ADD_OUTPUTTER(OpenMetrics)
                     else
                         HAYAI_MAIN_USAGE_ERROR("invalid format: " << format);
 
@@ -353,6 +478,14 @@ namespace hayai
         /// @returns the exit status code to be returned from the executable.
         int RunBenchmarks()
         {
+            // The benchmarker only falls back to console output when there
+            // are no outputters at all, which the baseline outputter would
+            // prevent.
+            if ((BaselinePath) &&
+                (!StdoutOutputter) &&
+                (FileOutputters.empty()))
+                StdoutOutputter = new ::hayai::ConsoleOutputter();
+
             // Hook up the outputs.
             if (StdoutOutputter)
                 ::hayai::Benchmarker::AddOutputter(*StdoutOutputter);
@@ -377,6 +510,55 @@ namespace hayai
                 ::hayai::Benchmarker::AddOutputter(fileOutputter.Outputter());
             }
 
+            // The comparison goes with the console output, or to stderr so as
+            // not to end up in the middle of another format on stdout.
+            if (BaselinePath)
+            {
+                const bool console = ((!StdoutOutputter) ||
+                    (dynamic_cast< ::hayai::ConsoleOutputter*>(
+                        StdoutOutputter
+                    )));
+
+                if (_baselineOutputter)
+                    delete _baselineOutputter;
+                _baselineOutputter = new ::hayai::BaselineOutputter(
+                    console ? std::cout : std::cerr,
+                    RegressionThreshold
+                );
+
+                try
+                {
+                    _baselineOutputter->Load(BaselinePath);
+                }
+                catch (std::exception& e)
+                {
+                    std::cerr << HAYAI_MAIN_FORMAT_ERROR(e.what()) << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                ::hayai::Benchmarker::AddOutputter(*_baselineOutputter);
+            }
+
+            if (!::hayai::Benchmarker::SetIsolation(IsolateBenchmarks))
+            {
+                std::cerr << HAYAI_MAIN_FORMAT_ERROR(
+                    "isolated execution is not supported on this platform"
+                ) << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            std::vector< ::hayai::ExecutionContext*> shards(ShardContexts);
+            if (shards.empty())
+                shards.resize(Jobs, NULL);
+
+            if (!::hayai::Benchmarker::SetShards(shards))
+            {
+                std::cerr << HAYAI_MAIN_FORMAT_ERROR(
+                    "parallel execution is not supported on this platform"
+                ) << std::endl;
+                return EXIT_FAILURE;
+            }
+
             // Run the benchmarks.
             if (ShuffleBenchmarks)
             {
@@ -386,6 +568,10 @@ namespace hayai
 
             ::hayai::Benchmarker::RunAllTests();
 
+            if ((_baselineOutputter) &&
+                (_baselineOutputter->RegressionCount()))
+                return EXIT_FAILURE;
+
             return EXIT_SUCCESS;
         }
 
@@ -465,6 +651,35 @@ namespace hayai
                       << std::endl
                       << "    Randomize benchmark execution order."
                       << std::endl
+                      << "  " << HAYAI_MAIN_FORMAT_FLAG("-i") << ", "
+                      << HAYAI_MAIN_FORMAT_FLAG("--isolate")
+                      << std::endl
+                      << "    Run each benchmark in a child process of its "
+                      << "own. A benchmark that crashes" << std::endl
+                      << "    is reported as failed and the rest still run."
+                      << std::endl
+                      << "  " << HAYAI_MAIN_FORMAT_FLAG("-j") << ", "
+                      << HAYAI_MAIN_FORMAT_FLAG("--jobs")
+                      << " <" << HAYAI_MAIN_FORMAT_ARGUMENT("count") << ">"
+                      << std::endl
+                      << "    Run benchmarks concurrently in "
+                      << HAYAI_MAIN_FORMAT_ARGUMENT("count")
+                      << " child processes. Results are" << std::endl
+                      << "    reported in the usual order. Benchmarks named "
+                      << "EXCLUSIVE_* need the whole" << std::endl
+                      << "    machine and are run one at a time afterwards."
+                      << std::endl
+                      << "  " << HAYAI_MAIN_FORMAT_FLAG("--pair-order") << " ("
+                      << ::hayai::Console::TextGreen << "abba"
+                      << ::hayai::Console::TextDefault << "|"
+                      << ::hayai::Console::TextGreen << "random"
+                      << ::hayai::Console::TextDefault << ")" << std::endl
+                      << "    Order of the runs in paired comparisons "
+                      << "(BENCHMARK_COMPARE): alternate" << std::endl
+                      << "    which benchmark goes first, or pick at random. "
+                      << "Default "
+                      << ::hayai::Console::TextGreen << "abba"
+                      << ::hayai::Console::TextDefault << "." << std::endl
                       << std::endl
 
                       << "Benchmark output options:" << std::endl
@@ -490,11 +705,38 @@ namespace hayai
                       << std::endl
                       << "      JUnit-compatible XML (very restrictive.)"
                       << std::endl
+                      << "    " << HAYAI_MAIN_FORMAT_ARGUMENT("binary")
+                      << std::endl
+                      << "      Compact binary, written as tests complete."
+                      << std::endl
+                      << "    " << HAYAI_MAIN_FORMAT_ARGUMENT("trace")
+                      << std::endl
+                      << "      Chrome trace event timeline, for Perfetto."
+                      << std::endl
+                      << "    " << HAYAI_MAIN_FORMAT_ARGUMENT("openmetrics")
+                      << std::endl
+                      << "      OpenMetrics text, for a Prometheus scraper."
+                      << std::endl
                       << std::endl
                       << "    If multiple output formats are provided without "
                       << "a path, only the last" << std::endl
                       << "    provided format will be output to stdout."
                       << std::endl
+                      << "  " << HAYAI_MAIN_FORMAT_FLAG("--baseline")
+                      << " <" << HAYAI_MAIN_FORMAT_ARGUMENT("path") << ">"
+                      << std::endl
+                      << "    Compare the results against an earlier "
+                      << HAYAI_MAIN_FORMAT_ARGUMENT("json")
+                      << " output and fail if any benchmark" << std::endl
+                      << "    got significantly slower (Mann-Whitney U, "
+                      << "p < 0.05)." << std::endl
+                      << "  "
+                      << HAYAI_MAIN_FORMAT_FLAG("--regression-threshold")
+                      << " <" << HAYAI_MAIN_FORMAT_ARGUMENT("percent") << ">"
+                      << std::endl
+                      << "    How much slower than the baseline a benchmark "
+                      << "may get before it counts as" << std::endl
+                      << "    a regression. Default 5." << std::endl
                       << "  " << HAYAI_MAIN_FORMAT_FLAG("--c") << ", "
                       << HAYAI_MAIN_FORMAT_FLAG("--color") << " ("
                       << ::hayai::Console::TextGreen << "yes"
@@ -518,6 +760,9 @@ namespace hayai
                       << ::hayai::Clock::Description()
                       << std::endl;
         }
+
+
+        ::hayai::BaselineOutputter* _baselineOutputter;
     };
 }
 
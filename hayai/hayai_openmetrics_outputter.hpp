@@ -0,0 +1,546 @@
+#ifndef __HAYAI_OPENMETRICSOUTPUTTER
+#define __HAYAI_OPENMETRICSOUTPUTTER
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hayai_outputter.hpp"
+
+
+namespace hayai
+{
+    /// OpenMetrics outputter.
+
+    /// Outputs the result of benchmarks as OpenMetrics text exposition, for a
+    /// Prometheus scraper or a node exporter textfile collector to pick up
+    /// from continuously run benchmarks:
+    ///
+    /// # TYPE hyperbench_iteration_time_seconds summary
+    /// # UNIT hyperbench_iteration_time_seconds seconds
+    /// # HELP hyperbench_iteration_time_seconds Time per iteration.
+    /// hyperbench_iteration_time_seconds{fixture="DeliveryMan",
+    ///     test="DeliverPackage",parameters="std::size_t distance = 1",
+    ///     host="canary-3",quantile="0.5"} 0.000380188983
+    /// ..
+    /// # EOF
+    ///
+    /// Every test is labeled with its fixture, test name, parameters (if
+    /// any), execution context (if any) and the host. The families are:
+    ///
+    /// - hyperbench_iteration_time_seconds, a summary of the time per
+    ///   iteration of the runs: quantile 0 and 1 are the fastest and slowest
+    ///   run and 0.5 is the median. The count is the number of runs.
+    /// - hyperbench_iteration_time_histogram_seconds, the same runs in
+    ///   1-2-5 buckets from 1 ns to 10 s, so they can be aggregated across
+    ///   hosts.
+    /// - hyperbench_iterations_per_second, the median throughput.
+    /// - hyperbench_core_clock_hertz and hyperbench_iteration_cycles, the
+    ///   average effective core clock and core clock cycles per iteration,
+    ///   if the core clock was measured with a @ref ClockProbe.
+    /// - hyperbench_counter_per_second and hyperbench_counter, the rate and
+    ///   absolute counters the tests reported, labeled with the counter name.
+    /// - hyperbench_test_failed, 1 for tests that did not complete.
+    /// - hyperbench_environment_info, the environment properties.
+    /// - hyperbench_run_timestamp_seconds, when the benchmarks finished, to
+    ///   tell a stale file from a fresh one.
+    ///
+    /// OpenMetrics requires the samples of a family to be together, so the
+    /// output is written once all benchmarks have run.
+    class OpenMetricsOutputter
+        :   public Outputter
+    {
+    public:
+        /// Initialize OpenMetrics outputter.
+
+        /// @param stream Output stream. Must exist for the entire duration of
+        /// the outputter's use.
+        OpenMetricsOutputter(std::ostream& stream)
+            :   _stream(stream),
+                _host(HostName())
+        {
+
+        }
+
+
+        virtual void Begin(const std::size_t& enabledCount,
+                           const std::size_t& disabledCount)
+        {
+            (void)enabledCount;
+            (void)disabledCount;
+        }
+
+
+        virtual void End(const std::size_t& executedCount,
+                         const std::size_t& disabledCount)
+        {
+            (void)executedCount;
+            (void)disabledCount;
+
+            const std::vector<double> bounds = BucketBounds();
+            std::vector<Sample>::const_iterator it;
+
+            // Summary.
+            WriteFamily("hyperbench_iteration_time_seconds",
+                        "summary",
+                        "seconds",
+                        "Time per iteration.");
+
+            for (it = _samples.begin(); it != _samples.end(); ++it)
+            {
+                if (it->Failed)
+                    continue;
+
+                static const char* const quantiles[5] =
+                    { "0", "0.25", "0.5", "0.75", "1" };
+
+                for (std::size_t q = 0; q < 5; ++q)
+                {
+                    std::string labels = it->Labels + ",quantile=\"";
+                    labels += quantiles[q];
+                    labels += "\"";
+
+                    WriteSample("hyperbench_iteration_time_seconds",
+                                "",
+                                labels,
+                                it->Quantiles[q]);
+                }
+
+                WriteSample("hyperbench_iteration_time_seconds",
+                            "_sum",
+                            it->Labels,
+                            it->Sum);
+                WriteSample("hyperbench_iteration_time_seconds",
+                            "_count",
+                            it->Labels,
+                            double(it->Buckets.back()));
+            }
+
+            // Histogram.
+            WriteFamily("hyperbench_iteration_time_histogram_seconds",
+                        "histogram",
+                        "seconds",
+                        "Time per iteration of the runs.");
+
+            for (it = _samples.begin(); it != _samples.end(); ++it)
+            {
+                if (it->Failed)
+                    continue;
+
+                for (std::size_t b = 0; b < it->Buckets.size(); ++b)
+                {
+                    std::string labels = it->Labels + ",le=\"";
+                    labels += (b < bounds.size() ?
+                               FormatValue(bounds[b]) :
+                               std::string("+Inf"));
+                    labels += "\"";
+
+                    WriteSample("hyperbench_iteration_time_histogram_seconds",
+                                "_bucket",
+                                labels,
+                                double(it->Buckets[b]));
+                }
+
+                WriteSample("hyperbench_iteration_time_histogram_seconds",
+                            "_count",
+                            it->Labels,
+                            double(it->Buckets.back()));
+                WriteSample("hyperbench_iteration_time_histogram_seconds",
+                            "_sum",
+                            it->Labels,
+                            it->Sum);
+            }
+
+            // Throughput.
+            WriteFamily("hyperbench_iterations_per_second",
+                        "gauge",
+                        NULL,
+                        "Median iterations per second.");
+
+            for (it = _samples.begin(); it != _samples.end(); ++it)
+                if (!it->Failed)
+                    WriteSample("hyperbench_iterations_per_second",
+                                "",
+                                it->Labels,
+                                it->IterationsPerSecond);
+
+            // Core clock.
+            bool clock = false;
+            for (it = _samples.begin(); it != _samples.end(); ++it)
+                clock = (clock) || (it->HasClock);
+
+            if (clock)
+            {
+                WriteFamily("hyperbench_core_clock_hertz",
+                            "gauge",
+                            "hertz",
+                            "Average effective core clock frequency.");
+
+                for (it = _samples.begin(); it != _samples.end(); ++it)
+                    if (it->HasClock)
+                        WriteSample("hyperbench_core_clock_hertz",
+                                    "",
+                                    it->Labels,
+                                    it->Hertz);
+
+                WriteFamily("hyperbench_iteration_cycles",
+                            "gauge",
+                            NULL,
+                            "Average core clock cycles per iteration.");
+
+                for (it = _samples.begin(); it != _samples.end(); ++it)
+                    if (it->HasClock)
+                        WriteSample("hyperbench_iteration_cycles",
+                                    "",
+                                    it->Labels,
+                                    it->Cycles);
+            }
+
+            // Counters.
+            WriteCounters(CounterRate,
+                          "hyperbench_counter_per_second",
+                          "Counter rate per second.");
+            WriteCounters(CounterAbsolute,
+                          "hyperbench_counter",
+                          "Counter value averaged over the runs.");
+
+            // Failures.
+            WriteFamily("hyperbench_test_failed",
+                        "gauge",
+                        NULL,
+                        "Whether the test did not complete.");
+
+            for (it = _samples.begin(); it != _samples.end(); ++it)
+                WriteSample("hyperbench_test_failed",
+                            "",
+                            it->Labels,
+                            it->Failed ? 1.0 : 0.0);
+
+            // Environment.
+            std::string labels = "host=" + LabelValue(_host);
+            for (std::size_t i = 0; i < _environment.size(); ++i)
+                labels += "," + LabelName(_environment[i].first) + "=" +
+                          LabelValue(_environment[i].second);
+
+            WriteFamily("hyperbench_environment",
+                        "info",
+                        NULL,
+                        "Machine the benchmarks were run on.");
+            WriteSample("hyperbench_environment", "_info", labels, 1.0);
+
+            // Timestamp.
+            WriteFamily("hyperbench_run_timestamp_seconds",
+                        "gauge",
+                        "seconds",
+                        "Unix time the benchmarks finished.");
+            WriteSample("hyperbench_run_timestamp_seconds",
+                        "",
+                        "host=" + LabelValue(_host),
+                        double(time(NULL)));
+
+            _stream << "# EOF" << std::endl;
+        }
+
+
+        virtual void Environment(const EnvironmentProperties& properties)
+        {
+            _environment = properties;
+        }
+
+
+        virtual void BeginTest(const std::string& fixtureName,
+                               const std::string& testName,
+                               const TestParametersDescriptor& parameters,
+                               const std::size_t& runsCount,
+                               const std::size_t& iterationsCount)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)runsCount;
+            (void)iterationsCount;
+        }
+
+
+        virtual void SkipDisabledTest(const std::string& fixtureName,
+                                      const std::string& testName,
+                                      const TestParametersDescriptor&
+                                          parameters,
+                                      const std::size_t& runsCount,
+                                      const std::size_t& iterationsCount)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)runsCount;
+            (void)iterationsCount;
+        }
+
+
+        virtual void EndTest(const std::string& fixtureName,
+                             const std::string& testName,
+                             const TestParametersDescriptor& parameters,
+                             const TestResult& result)
+        {
+            const std::vector<double> bounds = BucketBounds();
+            const std::vector<uint64_t>& runTimes = result.RunTimes();
+            const double iterations = double(result.Iterations());
+            Sample sample;
+
+            sample.Labels = Labels(fixtureName,
+                                   testName,
+                                   parameters,
+                                   result.Context());
+            sample.Quantiles[0] = result.IterationTimeMinimum() / 1e9;
+            sample.Quantiles[1] = result.IterationTimeQuartile1() / 1e9;
+            sample.Quantiles[2] = result.IterationTimeMedian() / 1e9;
+            sample.Quantiles[3] = result.IterationTimeQuartile3() / 1e9;
+            sample.Quantiles[4] = result.IterationTimeMaximum() / 1e9;
+            sample.Sum = 0.0;
+            sample.Buckets.assign(bounds.size() + 1, 0);
+
+            for (std::size_t run = 0; run < runTimes.size(); ++run)
+            {
+                const double time = double(runTimes[run]) / iterations / 1e9;
+                sample.Sum += time;
+
+                for (std::size_t b = 0; b < sample.Buckets.size(); ++b)
+                    if ((b == bounds.size()) || (time <= bounds[b]))
+                        ++sample.Buckets[b];
+            }
+
+            sample.IterationsPerSecond = result.IterationsPerSecondMedian();
+            sample.HasClock = result.HasClock();
+            if (sample.HasClock)
+            {
+                sample.Hertz = result.FrequencyAverage() * 1e9;
+                sample.Cycles = result.IterationCyclesAverage();
+            }
+            sample.Counters = result.Counters();
+
+            _samples.push_back(sample);
+        }
+
+
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            (void)reason;
+
+            Sample sample;
+            sample.Labels = Labels(fixtureName,
+                                   testName,
+                                   parameters,
+                                   context);
+            sample.Failed = true;
+
+            // A label set can only have one sample in a family.
+            for (std::size_t i = 0; i < _samples.size(); ++i)
+                if (_samples[i].Labels == sample.Labels)
+                    return;
+
+            _samples.push_back(sample);
+        }
+    private:
+        /// Summarized test, with its labels rendered.
+        struct Sample
+        {
+            Sample()
+                :   Sum(0.0),
+                    IterationsPerSecond(0.0),
+                    HasClock(false),
+                    Hertz(0.0),
+                    Cycles(0.0),
+                    Failed(false)
+            {
+                for (std::size_t q = 0; q < 5; ++q)
+                    Quantiles[q] = 0.0;
+            }
+
+
+            std::string Labels;
+            double Quantiles[5];
+            double Sum;
+            std::vector<uint64_t> Buckets;
+            double IterationsPerSecond;
+            bool HasClock;
+            double Hertz;
+            double Cycles;
+            std::vector<TestCounter> Counters;
+            bool Failed;
+        };
+
+
+        /// Upper bounds of the histogram buckets, 1-2-5 from 1 ns to 10 s.
+        static std::vector<double> BucketBounds()
+        {
+            std::vector<double> bounds;
+            double decade = 1e-9;
+
+            for (int i = 0; i < 10; ++i)
+            {
+                bounds.push_back(decade);
+                bounds.push_back(decade * 2.0);
+                bounds.push_back(decade * 5.0);
+                decade *= 10.0;
+            }
+            bounds.push_back(10.0);
+
+            return bounds;
+        }
+
+
+        std::string Labels(const std::string& fixtureName,
+                           const std::string& testName,
+                           const TestParametersDescriptor& parameters,
+                           const std::string& context) const
+        {
+            std::string labels = "fixture=" + LabelValue(fixtureName) +
+                                 ",test=" + LabelValue(testName);
+
+            const std::vector<TestParameterDescriptor>& descs =
+                parameters.Parameters();
+
+            if (!descs.empty())
+            {
+                std::string value;
+                for (std::size_t i = 0; i < descs.size(); ++i)
+                {
+                    if (i)
+                        value += ", ";
+                    value += descs[i].Declaration + " = " + descs[i].Value;
+                }
+                labels += ",parameters=" + LabelValue(value);
+            }
+
+            if (!context.empty())
+                labels += ",context=" + LabelValue(context);
+
+            return labels + ",host=" + LabelValue(_host);
+        }
+
+
+        /// Quoted and escaped label value.
+        static std::string LabelValue(const std::string& value)
+        {
+            std::string quoted = "\"";
+
+            for (std::size_t i = 0; i < value.size(); ++i)
+            {
+                const char c = value[i];
+
+                if (c == '\n')
+                    quoted += "\\n";
+                else if ((c == '\\') || (c == '"'))
+                {
+                    quoted += '\\';
+                    quoted += c;
+                }
+                else
+                    quoted += c;
+            }
+
+            return quoted + "\"";
+        }
+
+
+        /// Label name, with anything a label name cannot contain replaced.
+        static std::string LabelName(const std::string& name)
+        {
+            std::string label = name;
+
+            for (std::size_t i = 0; i < label.size(); ++i)
+            {
+                const char c = label[i];
+
+                if (!(((c >= 'a') && (c <= 'z')) ||
+                      ((c >= 'A') && (c <= 'Z')) ||
+                      ((c >= '0') && (c <= '9') && (i > 0)) ||
+                      (c == '_')))
+                    label[i] = '_';
+            }
+
+            return (label.empty() ? std::string("_") : label);
+        }
+
+
+        static std::string FormatValue(double value)
+        {
+            if (value != value)
+                return "NaN";
+            if (std::fabs(value) > 1.7976931348623157e308)
+                return (value > 0 ? "+Inf" : "-Inf");
+
+            std::stringstream stream;
+            stream << std::setprecision(12) << value;
+            return stream.str();
+        }
+
+
+        void WriteFamily(const char* name,
+                         const char* type,
+                         const char* unit,
+                         const char* help)
+        {
+            _stream << "# TYPE " << name << " " << type << "\n";
+            if (unit)
+                _stream << "# UNIT " << name << " " << unit << "\n";
+            _stream << "# HELP " << name << " " << help << "\n";
+        }
+
+
+        void WriteSample(const char* name,
+                         const char* suffix,
+                         const std::string& labels,
+                         double value)
+        {
+            _stream << name << suffix << "{" << labels << "} "
+                    << FormatValue(value) << "\n";
+        }
+
+
+        /// Write the family of counters of a type, if any were reported.
+        void WriteCounters(CounterType type,
+                           const char* name,
+                           const char* help)
+        {
+            bool family = false;
+
+            for (std::vector<Sample>::const_iterator it = _samples.begin();
+                 it != _samples.end();
+                 ++it)
+                for (std::size_t i = 0; i < it->Counters.size(); ++i)
+                {
+                    const TestCounter& counter = it->Counters[i];
+
+                    if (counter.Type != type)
+                        continue;
+
+                    if (!family)
+                    {
+                        WriteFamily(name, "gauge", NULL, help);
+                        family = true;
+                    }
+
+                    WriteSample(name,
+                                "",
+                                it->Labels + ",counter=" +
+                                    LabelValue(counter.Name),
+                                counter.Value);
+                }
+        }
+
+
+        std::ostream& _stream;
+        std::string _host;
+        EnvironmentProperties _environment;
+        std::vector<Sample> _samples;
+    };
+}
+#endif
@@ -2,12 +2,30 @@
 #define __HAYAI_OUTPUTTER
 #include <iostream>
 #include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
 
 #include "hayai_test_result.hpp"
+#include "hayai_comparison_result.hpp"
+#include "hayai_complexity_result.hpp"
 
 
 namespace hayai
 {
+    /// Environment properties.
+
+    /// Name/value pairs describing the machine the benchmarks are run on,
+    /// e.g. ("scaling_governor", "performance"), in the order they were added.
+    typedef std::vector<std::pair<std::string, std::string> >
+        EnvironmentProperties;
+
+
     /// Outputter.
 
     /// Abstract base class for outputters.
@@ -34,6 +52,18 @@ namespace hayai
                          const std::size_t& disabledCount) = 0;
 
 
+        /// Describe the environment.
+
+        /// Called after @ref Begin, before any tests, if any environment
+        /// properties have been added to the benchmarker.
+        ///
+        /// @param properties Environment properties.
+        virtual void Environment(const EnvironmentProperties& properties)
+        {
+            (void)properties;
+        }
+
+
         /// Begin benchmark test run.
 
         /// @param fixtureName Fixture name.
@@ -75,6 +105,82 @@ namespace hayai
                                       const std::size_t& iterationsCount) = 0;
 
 
+        /// Benchmark test run failed.
+
+        /// Called instead of @ref EndTest when a test did not complete, e.g.
+        /// because it crashed while running in a child process.
+        ///
+        /// @param fixtureName Fixture name.
+        /// @param testName Test name.
+        /// @param parameters Test parameter description.
+        /// @param context Execution context name, empty if none.
+        /// @param reason Description of the failure.
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)context;
+            (void)reason;
+        }
+
+
+        /// Paired comparison finished.
+
+        /// Called once all tests have run, for every comparison registered
+        /// with @ref Benchmarker::RegisterComparison.
+        ///
+        /// @param fixtureName Fixture name.
+        /// @param baselineName Baseline test name.
+        /// @param candidateName Candidate test name.
+        /// @param result Comparison result.
+        virtual void EndComparison(const std::string& fixtureName,
+                                   const std::string& baselineName,
+                                   const std::string& candidateName,
+                                   const ComparisonResult& result)
+        {
+            (void)fixtureName;
+            (void)baselineName;
+            (void)candidateName;
+            (void)result;
+        }
+
+
+        /// Complexity fit finished.
+
+        /// Called once all tests have run, for every range registered with
+        /// @ref Benchmarker::RegisterRange of which at least two sizes
+        /// completed, once per execution context.
+        ///
+        /// @param fixtureName Fixture name.
+        /// @param testName Test name.
+        /// @param result Complexity result.
+        virtual void EndComplexity(const std::string& fixtureName,
+                                   const std::string& testName,
+                                   const ComplexityResult& result)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)result;
+        }
+
+
+        /// Whether the outputter must be called on the benchmarking thread.
+
+        /// Outputters are otherwise called from a separate I/O thread, in
+        /// order but some time after the fact, while the next tests run.
+        /// Outputters that time or trace the benchmarking thread itself
+        /// cannot be.
+        virtual bool Synchronous() const
+        {
+            return false;
+        }
+
+
         virtual ~Outputter()
         {
 
@@ -108,6 +214,24 @@ namespace hayai
 
             stream << ")";
         }
+
+
+        /// Name of the machine the benchmarks are run on.
+
+        /// @returns the host name, or an empty string if it is not known.
+        static std::string HostName()
+        {
+#if defined(_WIN32)
+            const char* name = getenv("COMPUTERNAME");
+            return std::string(name ? name : "");
+#else
+            char name[256];
+            if (gethostname(name, sizeof(name)) != 0)
+                return std::string();
+            name[sizeof(name) - 1] = 0;
+            return std::string(name);
+#endif
+        }
     };
 }
 #endif
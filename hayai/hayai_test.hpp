@@ -1,9 +1,12 @@
 #ifndef __HAYAI_TEST
 #define __HAYAI_TEST
 #include <cstddef>
+#include <cstring>
 
 #include "hayai_clock.hpp"
+#include "hayai_clock_probe.hpp"
 #include "hayai_test_result.hpp"
+#include "hayai_trace.hpp"
 
 
 namespace hayai
@@ -38,17 +41,33 @@ namespace hayai
         /// Run the test.
 
         /// @param iterations Number of iterations to gather data for.
+        /// @param probe Clock probe to measure the timed part of the run
+        /// with, or NULL.
         /// @returns the number of nanoseconds the run took.
-        uint64_t Run(std::size_t iterations)
+        uint64_t Run(std::size_t iterations, ClockProbe* probe = NULL)
         {
             std::size_t iteration = iterations;
+
+            // Time the phases on the fast clock if a timeline is recorded.
+            const bool traced = Trace::Enabled();
+            uint64_t setUpStart = 0, timedStart = 0, timedEnd = 0;
+            int cpu = -1;
+
+            if (traced)
+                setUpStart = Trace::Now(cpu);
             
             // Set up the testing fixture.
             SetUp();
 
+            if (traced)
+                timedStart = Trace::Now();
+
             // Get the starting time.
             Clock::TimePoint startTime, endTime;
 
+            if (probe)
+                probe->Start();
+
             startTime = Clock::Now();
 
             // Run the test body for each iteration.
@@ -58,14 +77,73 @@ namespace hayai
             // Get the ending time.
             endTime = Clock::Now();
 
+            if (probe)
+                probe->Stop();
+
+            if (traced)
+                timedEnd = Trace::Now();
+
             // Tear down the testing fixture.
             TearDown();
 
+            if (traced)
+            {
+                const uint64_t tearDownEnd = Trace::Now();
+                Trace::Span("phase", "SetUp", setUpStart, timedStart, cpu);
+                Trace::Span("phase", "Timed", timedStart, timedEnd, cpu);
+                Trace::Span("phase", "TearDown", timedEnd, tearDownEnd, cpu);
+            }
+
             // Return the duration in nanoseconds.
             return Clock::Duration(startTime, endTime);
         }
 
 
+        enum
+        {
+            /// Maximum number of counters a test can report.
+            MaxCounters = 8
+        };
+
+
+        /// Counter as set by a test.
+        struct Counter
+        {
+            /// Name, as passed to @ref SetCounter.
+            const char* Name;
+
+
+            /// Value per iteration.
+            double Value;
+
+
+            /// Type.
+            CounterType Type;
+        };
+
+
+        Test()
+            :   _counterCount(0),
+                _lastCounter(0)
+        {
+
+        }
+
+
+        /// Counters reported by the test in the last run.
+        inline const Counter* Counters() const
+        {
+            return _counters;
+        }
+
+
+        /// Number of counters reported by the test in the last run.
+        inline std::size_t CounterCount() const
+        {
+            return _counterCount;
+        }
+
+
         virtual ~Test()
         {
 
@@ -78,6 +156,80 @@ namespace hayai
         {
 
         }
+
+
+        /// Report the bytes processed by an iteration.
+
+        /// Reported as bytes per second; see @ref SetCounter.
+        ///
+        /// @param bytes Bytes processed by an iteration.
+        void SetBytesProcessed(uint64_t bytes)
+        {
+            SetCounter("bytes", double(bytes), CounterRate);
+        }
+
+
+        /// Report the items processed by an iteration.
+
+        /// Reported as items per second; see @ref SetCounter.
+        ///
+        /// @param items Items processed by an iteration.
+        void SetItemsProcessed(uint64_t items)
+        {
+            SetCounter("items", double(items), CounterRate);
+        }
+
+
+        /// Report a named counter.
+
+        /// Best called from @ref SetUp, outside the timed iterations; the
+        /// value set last in a run counts. Setting a counter neither
+        /// allocates nor copies the name, and setting the one set last again
+        /// is a pointer comparison and a store, so calling it from
+        /// @ref TestBody does not noticeably inflate the run time.
+        ///
+        /// Rates are per iteration and reported per second of the overhead
+        /// corrected run time, absolute values are averaged over the runs. A
+        /// test can report up to @ref MaxCounters counters, further ones are
+        /// ignored, and names are truncated to 31 characters in the results.
+        ///
+        /// @param name Name. Must remain valid for the rest of the run, e.g.
+        /// a string literal.
+        /// @param value Value.
+        /// @param type Type.
+        void SetCounter(const char* name,
+                        double value,
+                        CounterType type)
+        {
+            if ((_lastCounter >= _counterCount) ||
+                (_counters[_lastCounter].Name != name))
+            {
+                std::size_t i = 0;
+
+                while ((i < _counterCount) &&
+                       (_counters[i].Name != name) &&
+                       (strcmp(_counters[i].Name, name)))
+                    ++i;
+
+                if (i == _counterCount)
+                {
+                    if (_counterCount == MaxCounters)
+                        return;
+
+                    _counters[i].Name = name;
+                    ++_counterCount;
+                }
+
+                _lastCounter = i;
+            }
+
+            _counters[_lastCounter].Value = value;
+            _counters[_lastCounter].Type = type;
+        }
+    private:
+        Counter _counters[MaxCounters];
+        std::size_t _counterCount;
+        std::size_t _lastCounter;
     };
 }
 #endif
@@ -7,6 +7,7 @@
 
 #include "hayai_test.hpp"
 #include "hayai_test_factory.hpp"
+#include "hayai_complexity_result.hpp"
 
 
 namespace hayai
@@ -232,6 +233,15 @@ namespace hayai
         }
 
 
+        TestParametersDescriptor(
+            const std::vector<TestParameterDescriptor>& parameters
+        )
+            :   _parameters(parameters)
+        {
+
+        }
+
+
         TestParametersDescriptor(const char* rawDeclarations,
                                  const char* rawValues)
         {
@@ -301,13 +311,16 @@ namespace hayai
         /// @param iterations Number of iterations per run.
         /// @param testFactory Test factory implementation for the test.
         /// @param parameters Parametrized test parameters.
+        /// @param isDisabled Whether the test is disabled.
+        /// @param isExclusive Whether the test needs the whole machine.
         TestDescriptor(const char* fixtureName,
                        const char* testName,
                        std::size_t runs,
                        std::size_t iterations,
                        TestFactory* testFactory,
                        TestParametersDescriptor parameters,
-                       bool isDisabled = false)
+                       bool isDisabled = false,
+                       bool isExclusive = false)
             :   FixtureName(fixtureName),
                 TestName(testName),
                 CanonicalName(std::string(fixtureName) + "." + testName),
@@ -315,7 +328,8 @@ namespace hayai
                 Iterations(iterations),
                 Factory(testFactory),
                 Parameters(parameters),
-                IsDisabled(isDisabled)
+                IsDisabled(isDisabled),
+                IsExclusive(isExclusive)
         {
 
         }
@@ -360,6 +374,91 @@ namespace hayai
 
         /// Disabled.
         bool IsDisabled;
+
+
+        /// Exclusive.
+
+        /// Exclusive tests, e.g. multi-threaded or memory bandwidth tests,
+        /// need the whole machine to themselves and are never run alongside
+        /// other tests.
+        bool IsExclusive;
+    };
+
+
+    /// Paired comparison descriptor.
+
+    /// Two tests of the same fixture to be run in alternating pairs of runs.
+    class ComparisonDescriptor
+    {
+    public:
+        /// Initialize a new comparison descriptor.
+
+        /// @param fixtureName Name of the fixture.
+        /// @param baselineName Name of the baseline test.
+        /// @param candidateName Name of the candidate test.
+        ComparisonDescriptor(const char* fixtureName,
+                             const char* baselineName,
+                             const char* candidateName)
+            :   FixtureName(fixtureName),
+                BaselineName(baselineName),
+                CandidateName(candidateName)
+        {
+
+        }
+
+
+        /// Fixture name.
+        std::string FixtureName;
+
+
+        /// Baseline test name.
+        std::string BaselineName;
+
+
+        /// Candidate test name.
+        std::string CandidateName;
+    };
+
+
+    /// Range descriptor.
+
+    /// A test registered at a range of sizes, one test descriptor per size,
+    /// whose results are fitted to complexities.
+    class RangeDescriptor
+    {
+    public:
+        /// Initialize a new range descriptor.
+
+        /// @param fixtureName Name of the fixture.
+        /// @param testName Name of the test, as registered.
+        RangeDescriptor(const char* fixtureName,
+                        const char* testName)
+            :   FixtureName(fixtureName),
+                TestName(testName),
+                Complexity(NULL)
+        {
+
+        }
+
+
+        /// Fixture name.
+        std::string FixtureName;
+
+
+        /// Test name, as registered.
+        std::string TestName;
+
+
+        /// Size of the problem in each test.
+        std::vector<std::size_t> Sizes;
+
+
+        /// Test descriptor for each size.
+        std::vector<TestDescriptor*> Tests;
+
+
+        /// User-supplied complexity to fit, or NULL if none.
+        ComplexityFunction Complexity;
     };
 }
 #endif
@@ -1,15 +1,60 @@
 #ifndef __HAYAI_TESTRESULT
 #define __HAYAI_TESTRESULT
+#include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <limits>
 #include <cmath>
+#include <string>
 
 #include "hayai_clock.hpp"
 
 
 namespace hayai
 {
+    /// Counter types.
+    enum CounterType
+    {
+        /// Amount processed per iteration, e.g. bytes, reported per second.
+        CounterRate = 0,
+
+
+        /// Value reported as is, e.g. a hit ratio, averaged over the runs.
+        CounterAbsolute = 1
+    };
+
+
+    /// Named counter reported by a test.
+    struct TestCounter
+    {
+        TestCounter(const std::string& name, CounterType type, double value)
+            :   Name(name),
+                Type(type),
+                Value(value)
+        {
+
+        }
+
+
+        /// Name, e.g. "bytes".
+        std::string Name;
+
+
+        /// Type.
+        CounterType Type;
+
+
+        /// Value per iteration as set by the test. In a @ref TestResult, the
+        /// rate per second or the average over the runs.
+        double Value;
+
+
+        /// Value per iteration as set in each run. Only set in a
+        /// @ref TestResult.
+        std::vector<double> RunValues;
+    };
+
+
     /// Test result descriptor.
 
     /// All durations are expressed in nanoseconds.
@@ -20,17 +65,25 @@ namespace hayai
 
         /// @param runTimes Timing for the individual runs.
         /// @param iterations Number of iterations per run.
+        /// @param context Name of the execution context the test was run in,
+        /// empty if none.
         TestResult(const std::vector<uint64_t>& runTimes,
-                   std::size_t iterations)
+                   std::size_t iterations,
+                   const std::string& context = std::string())
             :   _runTimes(runTimes),
                 _iterations(iterations),
+                _context(context),
                 _timeTotal(0),
                 _timeRunMin(std::numeric_limits<uint64_t>::max()),
                 _timeRunMax(std::numeric_limits<uint64_t>::min()),
                 _timeStdDev(0.0),
                 _timeMedian(0.0),
                 _timeQuartile1(0.0),
-                _timeQuartile3(0.0)
+                _timeQuartile3(0.0),
+                _cyclesTotal(0),
+                _activeTimeTotal(0),
+                _frequencyMin(0.0),
+                _frequencyMax(0.0)
         {
             // Summarize under the assumption of values being accessed more
             // than once.
@@ -113,6 +166,145 @@ namespace hayai
         }
 
 
+        /// Set the core clock measurements.
+
+        /// @param runCycles Core clock cycles elapsed during each run.
+        /// @param runActiveTimes Nanoseconds the benchmarking thread was
+        /// actually running during each run.
+        void SetClock(const std::vector<uint64_t>& runCycles,
+                      const std::vector<uint64_t>& runActiveTimes)
+        {
+            _runCycles = runCycles;
+            _runActiveTimes = runActiveTimes;
+            _cyclesTotal = 0;
+            _activeTimeTotal = 0;
+
+            for (std::size_t run = 0; run < runCycles.size(); ++run)
+            {
+                const double frequency =
+                    double(runCycles[run]) / double(runActiveTimes[run]);
+
+                if ((run == 0) || (frequency < _frequencyMin))
+                    _frequencyMin = frequency;
+                if ((run == 0) || (frequency > _frequencyMax))
+                    _frequencyMax = frequency;
+
+                _cyclesTotal += runCycles[run];
+                _activeTimeTotal += runActiveTimes[run];
+            }
+        }
+
+
+        /// Add a counter reported by the test.
+
+        /// Rates are the total amount processed over the total run time, so
+        /// they are normalized by the same overhead corrected times as the
+        /// rest of the result.
+        ///
+        /// @param name Name.
+        /// @param type Type.
+        /// @param runValues Value per iteration as set in each run.
+        void AddCounter(const std::string& name,
+                        CounterType type,
+                        const std::vector<double>& runValues)
+        {
+            TestCounter counter(name, type, 0.0);
+            counter.RunValues = runValues;
+
+            const std::size_t runs = std::min(runValues.size(),
+                                              _runTimes.size());
+            double total = 0.0;
+            double time = 0.0;
+
+            for (std::size_t run = 0; run < runs; ++run)
+            {
+                if (type == CounterRate)
+                {
+                    total += runValues[run] * double(_iterations);
+                    time += double(_runTimes[run]);
+                }
+                else
+                    total += runValues[run];
+            }
+
+            if (type == CounterRate)
+                counter.Value = (time > 0.0 ? total * 1e9 / time : 0.0);
+            else
+                counter.Value = (runs ? total / double(runs) : 0.0);
+
+            _counters.push_back(counter);
+        }
+
+
+        /// Counters reported by the test, in the order they were first set.
+        inline const std::vector<TestCounter>& Counters() const
+        {
+            return _counters;
+        }
+
+
+        /// Whether core clock measurements are available.
+        inline bool HasClock() const
+        {
+            return !_runCycles.empty();
+        }
+
+
+        /// Core clock cycles per run.
+
+        /// Unlike the run times, these are not corrected for the overhead of
+        /// the benchmarking loop.
+        inline const std::vector<uint64_t>& RunCycles() const
+        {
+            return _runCycles;
+        }
+
+
+        /// Nanoseconds the benchmarking thread was running during each run.
+
+        /// Empty unless core clock measurements are available.
+        inline const std::vector<uint64_t>& RunActiveTimes() const
+        {
+            return _runActiveTimes;
+        }
+
+
+        /// Average effective core clock frequency in GHz.
+        inline double FrequencyAverage() const
+        {
+            return double(_cyclesTotal) / double(_activeTimeTotal);
+        }
+
+        /// Minimum effective core clock frequency of a run in GHz.
+        inline double FrequencyMinimum() const
+        {
+            return _frequencyMin;
+        }
+
+        /// Maximum effective core clock frequency of a run in GHz.
+        inline double FrequencyMaximum() const
+        {
+            return _frequencyMax;
+        }
+
+
+        /// Average core clock cycles per iteration.
+        inline double IterationCyclesAverage() const
+        {
+            return double(_cyclesTotal) /
+                   (double(_runCycles.size()) * double(_iterations));
+        }
+
+
+        /// Execution context name.
+
+        /// Empty unless the test was run in an @ref ExecutionContext.
+        inline const std::string& Context() const
+        {
+            return _context;
+        }
+
+
         /// Total time.
         inline double TimeTotal() const
         {
@@ -127,6 +319,13 @@ namespace hayai
         }
 
 
+        /// Iterations per run.
+        inline std::size_t Iterations() const
+        {
+            return _iterations;
+        }
+
+
         /// Average time per run.
         inline double RunTimeAverage() const
         {
@@ -292,6 +491,7 @@ namespace hayai
     private:
         std::vector<uint64_t> _runTimes;
         std::size_t _iterations;
+        std::string _context;
         uint64_t _timeTotal;
         uint64_t _timeRunMin;
         uint64_t _timeRunMax;
@@ -299,6 +499,13 @@ namespace hayai
         double _timeMedian;
         double _timeQuartile1;
         double _timeQuartile3;
+        std::vector<uint64_t> _runCycles;
+        std::vector<uint64_t> _runActiveTimes;
+        uint64_t _cyclesTotal;
+        uint64_t _activeTimeTotal;
+        double _frequencyMin;
+        double _frequencyMax;
+        std::vector<TestCounter> _counters;
     };
 }
 #endif
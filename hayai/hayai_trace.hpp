@@ -0,0 +1,387 @@
+#ifndef __HAYAI_TRACE
+#define __HAYAI_TRACE
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "hayai_clock.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+
+namespace hayai
+{
+    /// Timeline event.
+    struct TraceEvent
+    {
+        TraceEvent()
+            :   Phase('X'),
+                Category(""),
+                Start(0),
+                Duration(0),
+                Cpu(-1)
+        {
+
+        }
+
+
+        /// Chrome trace event phase, 'X' for a span and 'i' for an instant.
+        char Phase;
+
+
+        /// Category, e.g. "run" or "phase".
+        const char* Category;
+
+
+        /// Name.
+        std::string Name;
+
+
+        /// Start in @ref Trace::Now ticks.
+        uint64_t Start;
+
+
+        /// Duration in @ref Trace::Now ticks, 0 for instants.
+        uint64_t Duration;
+
+
+        /// CPU the event started on, or -1 if unknown.
+        int Cpu;
+    };
+
+
+    /// Timeline of a single thread.
+    struct TraceThread
+    {
+        TraceThread()
+            :   Id(0)
+        {
+
+        }
+
+
+        /// Sequence number of the thread, in the order threads first traced.
+        unsigned Id;
+
+
+        /// Name, empty if the thread was not named.
+        std::string Name;
+
+
+        /// Events in the order they were recorded.
+        std::vector<TraceEvent> Events;
+    };
+
+
+    /// Timeline recorder.
+
+    /// Records what every thread does over time while enabled, for
+    /// @ref TraceOutputter to lay out as one track per thread and one per
+    /// CPU. The benchmarker records a span for every run and @ref Test for
+    /// its set up, timed and tear down phases; multi-threaded benchmarks can
+    /// name their threads and add spans and instants of their own:
+    ///
+    /// @code
+    /// hayai::Trace::NameThread("worker 3");
+    /// hayai::Trace::Instant("sync", "barrier release");
+    /// {
+    ///     hayai::TraceSpan span("work", "drain queue");
+    ///     ..
+    /// }
+    /// @endcode
+    ///
+    /// Timestamps are taken with rdtscp on x86, which also gives the CPU for
+    /// free, so recording costs a few dozen cycles and every thread appends
+    /// to its own buffer without locking. Recording is a single flag check
+    /// while disabled. Runs in isolated or sharded child processes are not
+    /// recorded.
+    class Trace
+    {
+    public:
+        /// Start recording, discarding anything recorded before.
+        static void Enable()
+        {
+            Trace& instance = Instance();
+            Clear();
+            instance._startTicks = Now();
+            instance._startTime = Clock::Now();
+            instance._enabled.store(true, std::memory_order_release);
+        }
+
+
+        /// Stop recording.
+        static void Disable()
+        {
+            Instance()._enabled.store(false, std::memory_order_release);
+        }
+
+
+        /// Whether recording is enabled.
+        static bool Enabled()
+        {
+            return Instance()._enabled.load(std::memory_order_relaxed);
+        }
+
+
+        /// Current time in ticks of the fast clock.
+        static uint64_t Now()
+        {
+            int cpu;
+            return Now(cpu);
+        }
+
+
+        /// Current time in ticks of the fast clock, and the current CPU.
+
+        /// @param cpu Receives the OS index of the CPU, or -1 if unknown.
+        static uint64_t Now(int& cpu)
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            unsigned int aux;
+            const uint64_t ticks = __rdtscp(&aux);
+            cpu = int(GetCurrentProcessorNumber());
+            return ticks;
+#elif defined(__x86_64__) || defined(__i386__)
+            unsigned int aux;
+            const uint64_t ticks = __rdtscp(&aux);
+#if defined(__linux__)
+            // Linux keeps the CPU number in the low 12 bits of TSC_AUX.
+            cpu = int(aux & 0xfff);
+#else
+            cpu = -1;
+#endif
+            return ticks;
+#else
+            static const Clock::TimePoint origin = Clock::Now();
+#if defined(__linux__)
+            cpu = sched_getcpu();
+#else
+            cpu = -1;
+#endif
+            return Clock::Duration(origin, Clock::Now());
+#endif
+        }
+
+
+        /// Fast clock ticks per nanosecond.
+
+        /// Measured against @ref Clock over the time since @ref Enable.
+        static double TicksPerNanosecond()
+        {
+            const Trace& instance = Instance();
+            const uint64_t ticks = Now() - instance._startTicks;
+            const uint64_t ns = Clock::Duration(instance._startTime,
+                                                Clock::Now());
+
+            return (ns ? double(ticks) / double(ns) : 1.0);
+        }
+
+
+        /// Fast clock ticks when recording was enabled.
+        static uint64_t StartTicks()
+        {
+            return Instance()._startTicks;
+        }
+
+
+        /// Name the calling thread's track.
+
+        /// Only remembers the name until the thread records its first event,
+        /// so naming threads costs nothing while recording is disabled and
+        /// threads that never record do not get a track.
+        static void NameThread(const std::string& name)
+        {
+            ThreadName() = name;
+            if (CurrentThread())
+                CurrentThread()->Name = name;
+        }
+
+
+        /// Record a span.
+
+        /// @param category Category, must outlive the recorder.
+        /// @param name Name.
+        /// @param start Start in @ref Now ticks.
+        /// @param end End in @ref Now ticks.
+        /// @param cpu CPU the span started on, or -1 if unknown.
+        static void Span(const char* category,
+                         const std::string& name,
+                         uint64_t start,
+                         uint64_t end,
+                         int cpu)
+        {
+            if (!Enabled())
+                return;
+
+            TraceEvent event;
+            event.Category = category;
+            event.Name = name;
+            event.Start = start;
+            event.Duration = (end > start ? end - start : 0);
+            event.Cpu = cpu;
+            ThreadBuffer().Events.push_back(event);
+        }
+
+
+        /// Record an instant, e.g. a barrier release.
+
+        /// @param category Category, must outlive the recorder.
+        /// @param name Name.
+        static void Instant(const char* category, const std::string& name)
+        {
+            if (!Enabled())
+                return;
+
+            TraceEvent event;
+            event.Phase = 'i';
+            event.Category = category;
+            event.Name = name;
+            event.Start = Now(event.Cpu);
+            ThreadBuffer().Events.push_back(event);
+        }
+
+
+        /// Copy of the timeline of every thread that recorded anything.
+
+        /// Must not be called while threads are still recording.
+        static std::vector<TraceThread> Threads()
+        {
+            Trace& instance = Instance();
+            std::lock_guard<std::mutex> lock(instance._mutex);
+            std::vector<TraceThread> threads;
+
+            for (std::size_t i = 0; i < instance._threads.size(); ++i)
+                if (!instance._threads[i]->Events.empty())
+                    threads.push_back(*instance._threads[i]);
+
+            return threads;
+        }
+
+
+        /// Discard everything recorded.
+
+        /// Thread names are kept. Must not be called while threads are still
+        /// recording.
+        static void Clear()
+        {
+            Trace& instance = Instance();
+            std::lock_guard<std::mutex> lock(instance._mutex);
+
+            for (std::size_t i = 0; i < instance._threads.size(); ++i)
+                instance._threads[i]->Events.clear();
+        }
+    private:
+        Trace()
+            :   _enabled(false),
+                _startTicks(0),
+                _startTime(Clock::Now())
+        {
+
+        }
+
+
+        ~Trace()
+        {
+            for (std::size_t i = 0; i < _threads.size(); ++i)
+                delete _threads[i];
+        }
+
+
+        static Trace& Instance()
+        {
+            static Trace singleton;
+            return singleton;
+        }
+
+
+        /// The calling thread's timeline, created on first use.
+
+        /// Timelines outlive their threads, so workers that have exited by
+        /// the time the trace is written still show up.
+        static TraceThread& ThreadBuffer()
+        {
+            TraceThread*& buffer = CurrentThread();
+
+            if (!buffer)
+            {
+                Trace& instance = Instance();
+                std::lock_guard<std::mutex> lock(instance._mutex);
+
+                buffer = new TraceThread();
+                buffer->Id = unsigned(instance._threads.size());
+                buffer->Name = ThreadName();
+                instance._threads.push_back(buffer);
+            }
+
+            return *buffer;
+        }
+
+
+        /// The calling thread's timeline, or NULL if it has not recorded.
+        static TraceThread*& CurrentThread()
+        {
+            static thread_local TraceThread* buffer = NULL;
+            return buffer;
+        }
+
+
+        /// Name given to the calling thread.
+        static std::string& ThreadName()
+        {
+            static thread_local std::string name;
+            return name;
+        }
+
+
+        std::atomic<bool> _enabled;
+        uint64_t _startTicks;
+        Clock::TimePoint _startTime;
+        std::mutex _mutex;
+        std::vector<TraceThread*> _threads;
+    };
+
+
+    /// Span covering the lifetime of the object.
+    class TraceSpan
+    {
+    public:
+        /// Start a span.
+
+        /// @param category Category, must outlive the recorder.
+        /// @param name Name.
+        TraceSpan(const char* category, const std::string& name)
+            :   _category(category),
+                _name(name),
+                _cpu(-1),
+                _start(Trace::Enabled() ? Trace::Now(_cpu) : 0)
+        {
+
+        }
+
+
+        ~TraceSpan()
+        {
+            if (_start)
+                Trace::Span(_category, _name, _start, Trace::Now(), _cpu);
+        }
+    private:
+        TraceSpan(const TraceSpan&);
+        TraceSpan& operator=(const TraceSpan&);
+
+
+        const char* _category;
+        std::string _name;
+        int _cpu;
+        uint64_t _start;
+    };
+}
+#endif
@@ -0,0 +1,337 @@
+#ifndef __HAYAI_TRACEOUTPUTTER
+#define __HAYAI_TRACEOUTPUTTER
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "hayai_outputter.hpp"
+#include "hayai_trace.hpp"
+
+
+namespace hayai
+{
+    /// Timeline outputter.
+
+    /// Records a timeline of the benchmarks with @ref Trace and writes it
+    /// once they have all run, as Chrome trace event JSON that can be opened
+    /// in Perfetto (ui.perfetto.dev) or chrome://tracing.
+    ///
+    /// The timeline has two groups of tracks: "Threads", with one track per
+    /// thread that recorded anything, and "CPUs", with the same events laid
+    /// out by the CPU they started on, so migrations, idle CPUs and threads
+    /// sharing a CPU stand out. Every test is a span, with a span for each
+    /// of its runs and, within those, for the set up, timed and tear down
+    /// phases. Multi-threaded benchmarks add their own spans and instants,
+    /// e.g. barrier releases, through @ref Trace.
+    ///
+    /// All timestamps are in microseconds since the first test began.
+    class TraceOutputter
+        :   public Outputter
+    {
+    public:
+        /// Initialize timeline outputter.
+
+        /// @param stream Output stream. Must exist for the entire duration of
+        /// the outputter's use.
+        TraceOutputter(std::ostream& stream)
+            :   _stream(stream),
+                _testStart(0),
+                _testCpu(-1)
+        {
+
+        }
+
+
+        virtual void Begin(const std::size_t& enabledCount,
+                           const std::size_t& disabledCount)
+        {
+            (void)enabledCount;
+            (void)disabledCount;
+
+            Trace::NameThread("benchmarker");
+            Trace::Enable();
+        }
+
+
+        virtual void End(const std::size_t& executedCount,
+                         const std::size_t& disabledCount)
+        {
+            (void)executedCount;
+            (void)disabledCount;
+
+            Trace::Disable();
+            Write();
+        }
+
+
+        virtual void BeginTest(const std::string& fixtureName,
+                               const std::string& testName,
+                               const TestParametersDescriptor& parameters,
+                               const std::size_t& runsCount,
+                               const std::size_t& iterationsCount)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)runsCount;
+            (void)iterationsCount;
+
+            _testStart = Trace::Now(_testCpu);
+        }
+
+
+        virtual void SkipDisabledTest(const std::string& fixtureName,
+                                      const std::string& testName,
+                                      const TestParametersDescriptor&
+                                          parameters,
+                                      const std::size_t& runsCount,
+                                      const std::size_t& iterationsCount)
+        {
+            (void)fixtureName;
+            (void)testName;
+            (void)parameters;
+            (void)runsCount;
+            (void)iterationsCount;
+        }
+
+
+        virtual void EndTest(const std::string& fixtureName,
+                             const std::string& testName,
+                             const TestParametersDescriptor& parameters,
+                             const TestResult& result)
+        {
+            std::stringstream name;
+            WriteTestNameToStream(name, fixtureName, testName, parameters);
+            if (!result.Context().empty())
+                name << " [" << result.Context() << "]";
+
+            Trace::Span("test",
+                        name.str(),
+                        _testStart,
+                        Trace::Now(),
+                        _testCpu);
+        }
+
+
+        virtual void FailTest(const std::string& fixtureName,
+                              const std::string& testName,
+                              const TestParametersDescriptor& parameters,
+                              const std::string& context,
+                              const std::string& reason)
+        {
+            std::stringstream name;
+            WriteTestNameToStream(name, fixtureName, testName, parameters);
+            if (!context.empty())
+                name << " [" << context << "]";
+            name << " (failed: " << reason << ")";
+
+            Trace::Span("test",
+                        name.str(),
+                        _testStart,
+                        Trace::Now(),
+                        _testCpu);
+        }
+
+
+        virtual bool Synchronous() const
+        {
+            return true;
+        }
+    private:
+        enum
+        {
+            /// Process id of the per-thread tracks.
+            ThreadsProcess = 1,
+
+
+            /// Process id of the per-CPU tracks.
+            CpusProcess = 2
+        };
+
+
+        /// Write the recorded timeline.
+        void Write()
+        {
+            const std::vector<TraceThread> threads = Trace::Threads();
+            const double ticksPerMicrosecond =
+                Trace::TicksPerNanosecond() * 1000.0;
+            const uint64_t startTicks = Trace::StartTicks();
+            std::set<int> cpus;
+            bool first = true;
+
+            _stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+            WriteProcessName(ThreadsProcess, "Threads", first);
+            WriteProcessName(CpusProcess, "CPUs", first);
+
+            for (std::size_t t = 0; t < threads.size(); ++t)
+            {
+                const TraceThread& thread = threads[t];
+                std::stringstream threadName;
+                if (thread.Name.empty())
+                    threadName << "thread " << thread.Id;
+                else
+                    threadName << thread.Name;
+
+                WriteThreadName(ThreadsProcess,
+                                int(thread.Id),
+                                threadName.str(),
+                                first);
+
+                for (std::size_t e = 0; e < thread.Events.size(); ++e)
+                {
+                    const TraceEvent& event = thread.Events[e];
+                    const double ts = (event.Start > startTicks ?
+                                       double(event.Start - startTicks) :
+                                       0.0) / ticksPerMicrosecond;
+                    const double dur =
+                        double(event.Duration) / ticksPerMicrosecond;
+
+                    WriteEvent(event,
+                               ThreadsProcess,
+                               int(thread.Id),
+                               ts,
+                               dur,
+                               threadName.str(),
+                               first);
+
+                    if (event.Cpu >= 0)
+                    {
+                        cpus.insert(event.Cpu);
+                        WriteEvent(event,
+                                   CpusProcess,
+                                   event.Cpu,
+                                   ts,
+                                   dur,
+                                   threadName.str(),
+                                   first);
+                    }
+                }
+            }
+
+            for (std::set<int>::const_iterator it = cpus.begin();
+                 it != cpus.end();
+                 ++it)
+            {
+                std::stringstream cpuName;
+                cpuName << "cpu " << *it;
+                WriteThreadName(CpusProcess, *it, cpuName.str(), first);
+            }
+
+            _stream << "]}" << std::endl;
+        }
+
+
+        void WriteProcessName(int pid, const char* name, bool& first)
+        {
+            _stream << (first ? "" : ",")
+                    << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"
+                    << pid << ",\"args\":{\"name\":\"" << name << "\"}},"
+                    << "{\"name\":\"process_sort_index\",\"ph\":\"M\","
+                    << "\"pid\":" << pid << ",\"args\":{\"sort_index\":"
+                    << pid << "}}";
+            first = false;
+        }
+
+
+        void WriteThreadName(int pid,
+                             int tid,
+                             const std::string& name,
+                             bool& first)
+        {
+            _stream << (first ? "" : ",")
+                    << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"
+                    << pid << ",\"tid\":" << tid << ",\"args\":{\"name\":";
+            WriteString(name);
+            _stream << "}},"
+                    << "{\"name\":\"thread_sort_index\",\"ph\":\"M\","
+                    << "\"pid\":" << pid << ",\"tid\":" << tid
+                    << ",\"args\":{\"sort_index\":" << tid << "}}";
+            first = false;
+        }
+
+
+        void WriteEvent(const TraceEvent& event,
+                        int pid,
+                        int tid,
+                        double ts,
+                        double dur,
+                        const std::string& threadName,
+                        bool& first)
+        {
+            _stream << (first ? "" : ",") << "{\"name\":";
+            WriteString(event.Name);
+            _stream << ",\"cat\":\"" << event.Category << "\",\"ph\":\""
+                    << event.Phase << "\",\"pid\":" << pid << ",\"tid\":"
+                    << tid << std::fixed << std::setprecision(3)
+                    << ",\"ts\":" << ts;
+
+            if (event.Phase == 'X')
+                _stream << ",\"dur\":" << dur;
+            else
+                _stream << ",\"s\":\"t\"";
+
+            // Tell where the event came from on the other kind of track.
+            if (pid == CpusProcess)
+            {
+                _stream << ",\"args\":{\"thread\":";
+                WriteString(threadName);
+                _stream << "}";
+            }
+            else if (event.Cpu >= 0)
+                _stream << ",\"args\":{\"cpu\":" << event.Cpu << "}";
+
+            _stream << "}";
+            first = false;
+        }
+
+
+        void WriteString(const std::string& str)
+        {
+            _stream << "\"";
+
+            for (std::size_t i = 0; i < str.size(); ++i)
+            {
+                const char c = str[i];
+
+                switch (c)
+                {
+                case '\\':
+                case '"':
+                    _stream << "\\" << c;
+                    break;
+
+                case '\n':
+                    _stream << "\\n";
+                    break;
+
+                case '\r':
+                    _stream << "\\r";
+                    break;
+
+                case '\t':
+                    _stream << "\\t";
+                    break;
+
+                default:
+                    if ((unsigned char)(c) < 0x20)
+                        _stream << " ";
+                    else
+                        _stream << c;
+                    break;
+                }
+            }
+
+            _stream << "\"";
+        }
+
+
+        std::ostream& _stream;
+        uint64_t _testStart;
+        int _testCpu;
+    };
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef __HAYAI_TYPELIST
+#define __HAYAI_TYPELIST
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <typeinfo>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+
+namespace hayai
+{
+    /// Type list.
+
+    /// Lists the types a typed test is instantiated for, see
+    /// @ref Benchmarker::RegisterTyped, e.g. Types<float, double, int32_t>.
+    template<class... T>
+    struct Types
+    {
+
+    };
+
+
+    /// Readable type name.
+
+    /// Names the type a typed test was instantiated for in its parameters.
+    /// The default is the demangled name of the type, which for typedefs is
+    /// that of the type they stand for, e.g. "int" for int32_t, and for
+    /// templates includes every default argument. Specialize to name a type
+    /// differently:
+    ///
+    /// @code
+    /// template<>
+    /// struct TypeName<std::vector<int> >
+    /// {
+    ///     static std::string Get()
+    ///     {
+    ///         return "std::vector<int>";
+    ///     }
+    /// };
+    /// @endcode
+    ///
+    /// @tparam T Type.
+    template<class T>
+    struct TypeName
+    {
+        static std::string Get()
+        {
+            const char* mangled = typeid(T).name();
+#if defined(__GNUG__)
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(mangled, NULL, NULL, &status);
+
+            if ((status == 0) && (demangled))
+            {
+                const std::string name(demangled);
+                free(demangled);
+                return name;
+            }
+
+            return std::string(mangled);
+#else
+            // Drop the elaborated type specifiers MSVC names classes with.
+            std::string name(mangled);
+            const char* const keywords[] = { "class ", "struct ", "enum " };
+
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                std::string::size_type pos;
+
+                while ((pos = name.find(keywords[k])) != std::string::npos)
+                    name.erase(pos, strlen(keywords[k]));
+            }
+
+            return name;
+#endif
+        }
+    };
+}
+#endif
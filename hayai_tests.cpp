@@ -1,6 +1,13 @@
 #include "hayai/hayai.hpp"
+#include "worker_pool.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <string>
 #include <thread>
+#include <vector>
 
 using hi_res_clock = std::chrono::high_resolution_clock;
 using milliseconds = std::chrono::milliseconds;
@@ -60,3 +67,84 @@ BENCHMARK(SpinWait, SpinYield, 5, 1000)
 		std::this_thread::yield();
     }
 }
+
+// the same 2ms wait, with and without giving up the core in between; run in alternating pairs
+BENCHMARK_COMPARE(SpinWait, SpinHot, SpinYield);
+
+// sorting a shuffled array at sizes from 64 to 16K; the fits should come out O(n log n), and a custom n^1.5 fit shows how
+// to check against a complexity of your own
+BENCHMARK_RANGE(Sort, StdSort, 5, 20, 64, 16384, 4)
+{
+    std::vector<uint32_t> values(n);
+    for (size_t i = 0; i < n; ++i)
+        values[i] = uint32_t((i * 2654435761u) ^ (i >> 3));
+    std::sort(values.begin(), values.end());
+}
+BENCHMARK_RANGE_COMPLEXITY(Sort, StdSort, [](double n) { return n * std::sqrt(n); });
+
+// the same reduction compiled for each element type; integer sums vectorize freely, floating point ones only as far as
+// the compiler may reorder them
+BENCHMARK_T(Accumulate, Sum, 5, 200, hayai::Types<float, double, int32_t>)
+{
+    std::vector<TypeParam> values(4096, TypeParam(1));
+    volatile TypeParam sum = std::accumulate(values.begin(), values.end(), TypeParam(0));
+    (void)sum;
+}
+
+// a pool of workers wakes up, meets at the start barrier and does a little work each; run with -o trace:<path> to see
+// how far apart the workers wake up and get through the barrier, and where the OS put them; reports the wake-ups per
+// second alongside the time, set once per run in SetUp rather than in the timed iterations
+namespace
+{
+    void trace_worker_pool(perf::threads::pool_event event, size_t worker)
+    {
+        using perf::threads::pool_event;
+        static thread_local uint64_t task_start = 0;
+        static thread_local int task_cpu = -1;
+        switch (event)
+        {
+        case pool_event::kWorkerStart:
+            hayai::Trace::NameThread("worker " + std::to_string(worker));
+            break;
+        case pool_event::kWake:
+            hayai::Trace::Instant("sync", "wake workers");
+            break;
+        case pool_event::kBarrierRelease:
+            hayai::Trace::Instant("sync", "barrier release");
+            break;
+        case pool_event::kTaskBegin:
+            if (hayai::Trace::Enabled())
+                task_start = hayai::Trace::Now(task_cpu);
+            break;
+        case pool_event::kTaskEnd:
+            hayai::Trace::Span("work", "task", task_start, hayai::Trace::Now(), task_cpu);
+            break;
+        }
+    }
+}
+
+struct worker_pool_fixture : hayai::Fixture
+{
+    void SetUp() override
+    {
+        perf::threads::set_trace_hook(&trace_worker_pool);
+        const auto workers = std::min<size_t>(4, system_info::topology().size());
+        _pool = std::make_unique<perf::threads::worker_pool>(workers, perf::threads::placement::kScatter);
+        SetItemsProcessed(workers);
+    }
+
+    void TearDown() override
+    {
+        _pool.reset();
+    }
+
+    std::unique_ptr<perf::threads::worker_pool> _pool;
+};
+BENCHMARK_F(worker_pool_fixture, WakeAll, 5, 20)
+{
+    _pool->run([](size_t) {
+        volatile unsigned sum = 0;
+        for (unsigned n = 0; n < 10000; ++n)
+            sum = sum + n;
+    });
+}
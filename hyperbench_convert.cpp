@@ -0,0 +1,109 @@
+#include "hayai/hayai.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// converts a result file written with -o binary:<path> to JSON, CSV or the console format, on stdout
+// usage:
+//  hyperbench-convert <path> [json|csv|console]
+// the CSV has one row per run: fixture, name, parameters, context, run, iterations, duration (ns), cycles, active (ns)
+// and leaves out everything that isn't a completed test
+namespace
+{
+    std::string csv_field(const std::string& value)
+    {
+        if (value.find_first_of(",\"\n") == std::string::npos)
+            return value;
+        std::string quoted{ "\"" };
+        for (auto c : value)
+            quoted += (c == '"') ? std::string{ "\"\"" } : std::string(1, c);
+        return quoted + "\"";
+    }
+
+    bool write_csv(hayai::BinaryReader& reader, std::ostream& out)
+    {
+        out << "fixture,name,parameters,context,run,iterations,duration_ns,cycles,active_ns\n";
+        hayai::BinaryRecord record;
+        while (reader.Next(record))
+        {
+            if (record.Type != hayai::BinaryRecordTest)
+                continue;
+            hayai::BinaryTestRecord test;
+            hayai::BinaryReader::Decode(record, test);
+
+            std::string parameters;
+            for (const auto& parameter : test.Parameters)
+                parameters += (parameters.empty() ? "" : ", ") + parameter.Declaration + " = " + parameter.Value;
+            const auto prefix = csv_field(test.Fixture) + "," + csv_field(test.Name) + "," + csv_field(parameters) + "," + csv_field(test.Context) + ",";
+
+            for (size_t run = 0; run < test.RunTimes.Size(); ++run)
+            {
+                out << prefix << run << "," << test.Iterations << "," << test.RunTimes[run] << ",";
+                if (run < test.RunCycles.Size())
+                    out << test.RunCycles[run];
+                out << ",";
+                if (run < test.RunActiveTimes.Size())
+                    out << test.RunActiveTimes[run];
+                out << "\n";
+            }
+        }
+        return reader.Complete();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <path> [json|csv|console]\n";
+        return EXIT_FAILURE;
+    }
+    const std::string format = argc == 3 ? argv[2] : "json";
+
+    std::ifstream file{ argv[1], std::ios_base::in | std::ios_base::binary };
+    if (!file)
+    {
+        std::cerr << "failed to open " << argv[1] << " for reading: " << strerror(errno) << "\n";
+        return EXIT_FAILURE;
+    }
+    const std::vector<char> contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    try
+    {
+        hayai::BinaryReader reader{ contents.data(), contents.size() };
+        bool complete = false;
+        if (format == "json")
+        {
+            hayai::JsonOutputter outputter{ std::cout };
+            complete = reader.Replay(outputter);
+        }
+        else if (format == "console")
+        {
+            hayai::ConsoleOutputter outputter{ std::cout };
+            complete = reader.Replay(outputter);
+        }
+        else if (format == "csv")
+        {
+            complete = write_csv(reader, std::cout);
+        }
+        else
+        {
+            std::cerr << "unknown format: " << format << "\n";
+            return EXIT_FAILURE;
+        }
+        if (!complete)
+            std::cerr << argv[1] << ": the run didn't finish; converted the tests that completed\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
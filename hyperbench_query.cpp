@@ -0,0 +1,468 @@
+#include "hayai/hayai.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// queries an archive of result files written with -o binary:<path>; every file is mapped into memory and its run
+// arrays are read in place
+// usage:
+//  hyperbench-query [options] <file or directory>...
+//  --filter <pattern>  the tests to include, the same as hyperbench --filter, e.g. "Queue.*-*Slow*"
+//  --host <pattern>    the hosts to include, ':' separated globs, e.g. "ci-*:bench?"
+//  --since <date>      only runs from this day on, YYYY-MM-DD (UTC)
+//  --until <date>      only runs up to and including this day
+//  --csv               print the series as CSV instead of analysing them
+// for every test (and parameter set and context) that matches, prints the median and p99 time per iteration of every
+// run oldest first, the trend over time and the points where the level changed. Directories are searched recursively
+// and files in them that aren't result files are skipped.
+namespace
+{
+    // the smallest number of runs on either side of a changepoint
+    constexpr size_t kMinSegment = 4;
+    // how unlikely a split has to be by chance, and how big the step, to count as a changepoint
+    constexpr double kChangeSignificance = 0.001;
+    constexpr double kMinChange = 0.02;
+    constexpr double kSecondsPerDay = 86400.0;
+    // runs closer together than this are trended per run, not extrapolated to a month
+    constexpr double kMinTrendSpan = kSecondsPerDay;
+
+    // a read only view of a whole file
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        ~mapped_file()
+        {
+            close();
+        }
+
+        bool open(const std::string& path)
+        {
+            close();
+#ifdef _WIN32
+            _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            LARGE_INTEGER size;
+            if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &size))
+                return close(), false;
+            _size = size_t(size.QuadPart);
+            if (!_size)
+                return true;
+            _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            _data = _mapping ? MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+            _fd = ::open(path.c_str(), O_RDONLY);
+            struct stat st;
+            if (_fd < 0 || fstat(_fd, &st) != 0)
+                return close(), false;
+            _size = size_t(st.st_size);
+            if (!_size)
+                return true;
+            _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+            if (_data == MAP_FAILED)
+                _data = nullptr;
+            else
+                // we read every file once, front to back
+                madvise(_data, _size, MADV_SEQUENTIAL);
+#endif
+            if (!_data)
+                return close(), false;
+            return true;
+        }
+
+        void close()
+        {
+#ifdef _WIN32
+            if (_data)
+                UnmapViewOfFile(_data);
+            if (_mapping)
+                CloseHandle(_mapping);
+            if (_file != INVALID_HANDLE_VALUE)
+                CloseHandle(_file);
+            _mapping = nullptr;
+            _file = INVALID_HANDLE_VALUE;
+#else
+            if (_data)
+                munmap(_data, _size);
+            if (_fd >= 0)
+                ::close(_fd);
+            _fd = -1;
+#endif
+            _data = nullptr;
+            _size = 0;
+        }
+
+        const void* data() const
+        {
+            return _data;
+        }
+
+        size_t size() const
+        {
+            return _size;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE _file = INVALID_HANDLE_VALUE;
+        HANDLE _mapping = nullptr;
+#else
+        int _fd = -1;
+#endif
+        void* _data = nullptr;
+        size_t _size = 0;
+    };
+
+    struct query
+    {
+        std::string _filter = "*";
+        std::string _host = "*";
+        uint64_t _since = 0;
+        uint64_t _until = UINT64_MAX;
+        bool _csv = false;
+    };
+
+    // one run of a test, i.e. one result file
+    struct point
+    {
+        uint64_t _time = 0;
+        std::string _host;
+        std::string _file;
+        double _median = 0.0;
+        double _p99 = 0.0;
+    };
+
+    struct changepoint
+    {
+        size_t _index = 0;
+        double _before = 0.0;
+        double _after = 0.0;
+        double _p_value = 1.0;
+    };
+
+    // linearly interpolated quantile of sorted values
+    double quantile(const std::vector<double>& sorted, double p)
+    {
+        const auto h = p * double(sorted.size() - 1);
+        const auto below = size_t(h);
+        const auto above = std::min(below + 1, sorted.size() - 1);
+        return sorted[below] + (h - double(below)) * (sorted[above] - sorted[below]);
+    }
+
+    double median_of(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        return quantile(values, 0.5);
+    }
+
+    // YYYY-MM-DD as seconds since the epoch, UTC; false if it isn't a date
+    bool parse_date(const char* text, uint64_t& seconds)
+    {
+        int y = 0, m = 0, d = 0;
+        if (std::sscanf(text, "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31)
+            return false;
+        // days from civil (Howard Hinnant), since timegm isn't portable
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const int yoe = y - era * 400;
+        const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        const long long days = era * 146097LL + doe - 719468;
+        if (days < 0)
+            return false;
+        seconds = uint64_t(days) * 86400u;
+        return true;
+    }
+
+    std::string format_time(uint64_t seconds)
+    {
+        const auto t = time_t(seconds);
+        char text[32] = {};
+        struct tm utc;
+#ifdef _WIN32
+        gmtime_s(&utc, &t);
+#else
+        gmtime_r(&t, &utc);
+#endif
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &utc);
+        return text;
+    }
+
+    std::string series_name(const hayai::BinaryTestRecord& test)
+    {
+        std::string name = test.Fixture + "." + test.Name;
+        for (size_t p = 0; p < test.Parameters.size(); ++p)
+            name += std::string(p ? ", " : "(") + test.Parameters[p].Declaration + " = " + test.Parameters[p].Value;
+        if (!test.Parameters.empty())
+            name += ")";
+        if (!test.Context.empty())
+            name += " [" + test.Context + "]";
+        return name;
+    }
+
+    // adds the matching tests of one file to the series; returns false if it isn't a result file
+    bool scan_file(const std::string& path, const query& q, std::map<std::string, std::vector<point>>& series, std::string& error)
+    {
+        mapped_file file;
+        if (!file.open(path))
+        {
+            error = std::string{ "failed to open for reading: " } + strerror(errno);
+            return false;
+        }
+
+        try
+        {
+            hayai::BinaryReader reader{ file.data(), file.size() };
+            hayai::BinaryRecord record;
+            hayai::BinaryBeginRecord begin;
+            hayai::BinaryTestRecord test;
+            std::vector<double> times;
+
+            while (reader.Next(record))
+            {
+                if (record.Type == hayai::BinaryRecordBegin)
+                {
+                    hayai::BinaryReader::Decode(record, begin);
+                    if (begin.Time < q._since || begin.Time >= q._until || !hayai::Benchmarker::FilterMatchesString(q._host.c_str(), begin.Host))
+                        return true;
+                    continue;
+                }
+                if (record.Type != hayai::BinaryRecordTest)
+                    continue;
+
+                hayai::BinaryReader::Decode(record, test);
+                if (test.RunTimes.Empty() || !test.Iterations || !hayai::Benchmarker::PatternFilterMatches(q._filter.c_str(), test.Fixture + "." + test.Name))
+                    continue;
+
+                times.resize(test.RunTimes.Size());
+                for (size_t run = 0; run < times.size(); ++run)
+                    times[run] = double(test.RunTimes[run]) / double(test.Iterations);
+                std::sort(times.begin(), times.end());
+
+                point p;
+                p._time = begin.Time;
+                p._host = begin.Host;
+                p._file = path;
+                p._median = quantile(times, 0.5);
+                p._p99 = quantile(times, 0.99);
+                series[series_name(test)].push_back(std::move(p));
+            }
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+            return false;
+        }
+        return true;
+    }
+
+    // Mann-Kendall test for a monotonic trend; the two-sided p-value of the values having none
+    double mann_kendall(const std::vector<double>& values)
+    {
+        const auto n = double(values.size());
+        if (values.size() < 3)
+            return 1.0;
+        double s = 0.0;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            for (size_t j = i + 1; j < values.size(); ++j)
+                s += (values[j] > values[i]) - (values[j] < values[i]);
+        }
+        const auto variance = n * (n - 1.0) * (2.0 * n + 5.0) / 18.0;
+        const auto z = (std::fabs(s) - 1.0) / std::sqrt(variance);
+        return z > 0.0 ? std::erfc(z / std::sqrt(2.0)) : 1.0;
+    }
+
+    // Theil-Sen slope of the medians over time in ns per day, or over the runs in ns per run; robust to the odd outlier run
+    double theil_sen_slope(const std::vector<point>& points, bool per_run)
+    {
+        std::vector<double> slopes;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            for (size_t j = i + 1; j < points.size(); ++j)
+            {
+                const auto step = per_run ? double(j - i) : (double(points[j]._time) - double(points[i]._time)) / kSecondsPerDay;
+                if (step != 0.0)
+                    slopes.push_back((points[j]._median - points[i]._median) / step);
+            }
+        }
+        return slopes.empty() ? 0.0 : median_of(std::move(slopes));
+    }
+
+    // binary segmentation; split [first, last) where the two sides differ most significantly (Mann-Whitney U) and
+    // carry on with both halves, as long as the split is significant and the step big enough to matter
+    void find_changepoints(const std::vector<double>& values, size_t first, size_t last, std::vector<changepoint>& found)
+    {
+        if (last - first < 2 * kMinSegment)
+            return;
+
+        changepoint best;
+        for (auto split = first + kMinSegment; split + kMinSegment <= last; ++split)
+        {
+            const std::vector<double> before(values.begin() + std::ptrdiff_t(first), values.begin() + std::ptrdiff_t(split));
+            const std::vector<double> after(values.begin() + std::ptrdiff_t(split), values.begin() + std::ptrdiff_t(last));
+            const auto p_value = hayai::BaselineOutputter::MannWhitneyU(before, after);
+            if (p_value < best._p_value)
+            {
+                best._index = split;
+                best._p_value = p_value;
+                best._before = median_of(before);
+                best._after = median_of(after);
+            }
+        }
+
+        if (best._p_value >= kChangeSignificance || best._before <= 0.0 || std::fabs(best._after / best._before - 1.0) < kMinChange)
+            return;
+
+        find_changepoints(values, first, best._index, found);
+        found.push_back(best);
+        find_changepoints(values, best._index, last, found);
+    }
+
+    void print_series(const std::string& name, const std::vector<point>& points)
+    {
+        std::cout << name << " (" << points.size() << (points.size() == 1 ? " run)\n" : " runs)\n");
+        std::cout << "  " << std::left << std::setw(18) << "time (UTC)" << std::setw(20) << "host" << std::right << std::setw(14) << "median (ns)" << std::setw(14) << "p99 (ns)" << "\n";
+        for (const auto& p : points)
+            std::cout << "  " << std::left << std::setw(18) << format_time(p._time) << std::setw(20) << p._host << std::right << std::fixed << std::setprecision(1) << std::setw(14) << p._median << std::setw(14) << p._p99 << "\n";
+
+        std::vector<double> medians;
+        for (const auto& p : points)
+            medians.push_back(p._median);
+        const auto level = median_of(medians);
+
+        if (points.size() >= 3 && level > 0.0)
+        {
+            const auto per_run = double(points.back()._time) - double(points.front()._time) < kMinTrendSpan;
+            const auto slope = theil_sen_slope(points, per_run);
+            const auto p_value = mann_kendall(medians);
+            std::cout << "  trend: " << std::showpos << std::setprecision(2) << slope * (per_run ? 1.0 : 30.0) / level * 100.0 << std::noshowpos << (per_run ? " % per run" : " % per 30 days") << " (Mann-Kendall p = " << std::setprecision(4) << p_value << (p_value < 0.05 ? ")\n" : ", not significant)\n");
+        }
+
+        std::vector<changepoint> changes;
+        find_changepoints(medians, 0, medians.size(), changes);
+        for (const auto& change : changes)
+        {
+            std::cout << "  changepoint: " << format_time(points[change._index]._time) << " on " << points[change._index]._host << ", " << std::setprecision(1) << change._before << " ns -> " << change._after << " ns (" << std::showpos << std::setprecision(2) << (change._after / change._before - 1.0) * 100.0 << std::noshowpos << " %, p = " << std::setprecision(6) << change._p_value << ")\n";
+        }
+        std::cout << "\n";
+    }
+
+    void print_csv(const std::map<std::string, std::vector<point>>& series)
+    {
+        const auto field = [](const std::string& value) {
+            if (value.find_first_of(",\"\n") == std::string::npos)
+                return value;
+            std::string quoted{ "\"" };
+            for (auto c : value)
+                quoted += (c == '"') ? std::string{ "\"\"" } : std::string(1, c);
+            return quoted + "\"";
+        };
+        std::cout << "test,time,host,file,median_ns,p99_ns\n" << std::fixed << std::setprecision(1);
+        for (const auto& s : series)
+        {
+            for (const auto& p : s.second)
+                std::cout << field(s.first) << "," << format_time(p._time) << "," << field(p._host) << "," << field(p._file) << "," << p._median << "," << p._p99 << "\n";
+        }
+    }
+
+    int usage(const char* program)
+    {
+        std::cerr << "usage: " << program << " [--filter <pattern>] [--host <pattern>] [--since <YYYY-MM-DD>] [--until <YYYY-MM-DD>] [--csv] <file or directory>...\n";
+        return EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    query q;
+    std::vector<std::string> paths;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        const bool has_value = arg + 1 < argc;
+        if (!strcmp(argv[arg], "--filter") && has_value)
+            q._filter = argv[++arg];
+        else if (!strcmp(argv[arg], "--host") && has_value)
+            q._host = argv[++arg];
+        else if ((!strcmp(argv[arg], "--since") || !strcmp(argv[arg], "--until")) && has_value)
+        {
+            uint64_t seconds = 0;
+            if (!parse_date(argv[arg + 1], seconds))
+            {
+                std::cerr << argv[arg] << ": not a date: " << argv[arg + 1] << "\n";
+                return EXIT_FAILURE;
+            }
+            if (!strcmp(argv[arg], "--since"))
+                q._since = seconds;
+            else
+                q._until = seconds + 86400u;
+            ++arg;
+        }
+        else if (!strcmp(argv[arg], "--csv"))
+            q._csv = true;
+        else if (argv[arg][0] == '-')
+            return usage(argv[0]);
+        else
+            paths.push_back(argv[arg]);
+    }
+    if (paths.empty())
+        return usage(argv[0]);
+
+    std::map<std::string, std::vector<point>> series;
+    size_t files = 0;
+    std::string error;
+    for (const auto& path : paths)
+    {
+        std::error_code ec;
+        if (std::filesystem::is_directory(path, ec))
+        {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec))
+            {
+                if (entry.is_regular_file(ec))
+                    files += scan_file(entry.path().string(), q, series, error);
+            }
+        }
+        else if (scan_file(path, q, series, error))
+            ++files;
+        else
+            std::cerr << path << ": " << error << "\n";
+    }
+
+    // oldest first; stable so runs from the same second keep the order they were given in
+    for (auto& s : series)
+        std::stable_sort(s.second.begin(), s.second.end(), [](const point& a, const point& b) { return a._time < b._time; });
+
+    if (q._csv)
+    {
+        print_csv(series);
+        return EXIT_SUCCESS;
+    }
+
+    std::cout << "Read " << files << (files == 1 ? " result file, " : " result files, ") << series.size() << (series.size() == 1 ? " matching benchmark\n\n" : " matching benchmarks\n\n");
+    for (const auto& s : series)
+        print_series(s.first, s.second);
+    return EXIT_SUCCESS;
+}
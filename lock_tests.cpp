@@ -0,0 +1,131 @@
+#include "thread_tests.h"
+#include "perfutils.h"
+#include "worker_pool.h"
+#include "locks.h"
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+
+namespace perf::threads
+{
+	namespace
+	{
+		// how long each configuration runs for; fixed time rather than fixed op count so that unfair locks show up as skewed per-thread counts
+		constexpr auto kRunTime = std::chrono::milliseconds(200);
+		constexpr size_t kMaxLatencySamplesPerThread = 1u << 16;
+		// units of work done while holding the lock, each is a read-modify-write of the protected cache lines
+		constexpr size_t kCriticalSectionLengths[] = { 0, 64, 512 };
+
+		struct alignas(64) protected_data
+		{
+			uint64_t _count = 0;
+			uint64_t _work[15] = { 0 };
+		};
+
+		struct per_thread
+		{
+			uint64_t _acquisitions = 0;
+			std::vector<uint64_t> _acquire_ticks;
+		};
+
+		template<typename Lock>
+		void run_lock(const char* name, worker_pool& pool, size_t cs_length)
+		{
+			Lock lock;
+			protected_data data;
+			std::vector<per_thread> threads(pool.size());
+			for (auto& t : threads)
+				t._acquire_ticks.resize(kMaxLatencySamplesPerThread);
+
+			const auto run_ticks = uint64_t(double(std::chrono::duration_cast<std::chrono::nanoseconds>(kRunTime).count()) * tsc_ticks_per_ns());
+			const auto deadline = rdtsc() + run_ticks;
+
+			pool.run([&](size_t thread) {
+				auto& mine = threads[thread];
+				uint64_t acquisitions = 0;
+				for (;;)
+				{
+					const auto t0 = rdtsc();
+					if (t0 >= deadline)
+						break;
+					lock.lock();
+					const auto t1 = rdtsc();
+					++data._count;
+					for (size_t n = 0; n < cs_length; ++n)
+						data._work[n % 15] += n;
+					lock.unlock();
+					if (acquisitions < kMaxLatencySamplesPerThread)
+						mine._acquire_ticks[acquisitions] = t1 - t0;
+					++acquisitions;
+				}
+				mine._acquisitions = acquisitions;
+			});
+
+			RunningStat fairness;
+			Stats latency;
+			uint64_t total = 0;
+			uint64_t min_acq = std::numeric_limits<uint64_t>::max();
+			uint64_t max_acq = 0;
+			const auto ticks_per_ns = tsc_ticks_per_ns();
+			for (const auto& t : threads)
+			{
+				total += t._acquisitions;
+				min_acq = std::min(min_acq, t._acquisitions);
+				max_acq = std::max(max_acq, t._acquisitions);
+				fairness.push(double(t._acquisitions));
+				const auto samples = std::min<uint64_t>(t._acquisitions, kMaxLatencySamplesPerThread);
+				for (size_t n = 0; n < samples; ++n)
+					latency.push(double(t._acquire_ticks[n]) / ticks_per_ns);
+			}
+
+			const auto seconds = std::chrono::duration<double>(kRunTime).count();
+			std::cout << "\t" << std::setw(10) << name
+				<< std::setw(5) << cs_length
+				<< std::setw(9) << pool.size()
+				<< std::setw(12) << std::setprecision(3) << double(total) / seconds / 1e6
+				// coefficient of variation of per-thread acquisitions and the spread between the luckiest and unluckiest thread
+				<< std::setw(9) << (fairness.mean() > 0 ? fairness.stdev() / fairness.mean() : 0.0)
+				<< std::setw(10) << std::setprecision(1) << (min_acq ? double(max_acq) / double(min_acq) : std::numeric_limits<double>::infinity())
+				<< std::setw(10) << latency.percentile(0.5)
+				<< std::setw(10) << latency.percentile(0.99)
+				<< std::setw(11) << latency.percentile(0.999)
+				<< std::setw(12) << latency.percentile(1.0);
+			// sanity check; every acquisition bumps the protected counter exactly once
+			if (data._count != total)
+				std::cout << "  MUTUAL EXCLUSION BROKEN (" << data._count << " != " << total << ")";
+			std::cout << "\n";
+		}
+
+		void print_header()
+		{
+			std::cout << "\t" << std::setw(10) << "lock" << std::setw(5) << "cs" << std::setw(9) << "threads"
+				<< std::setw(12) << "Macq/s" << std::setw(9) << "cv" << std::setw(10) << "max/min"
+				<< std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(11) << "p99.9 ns" << std::setw(12) << "max ns"
+				<< "\n" << std::fixed;
+		}
+	}
+
+	void test_locks()
+	{
+		std::cout << "lock shoot-out, " << std::chrono::duration_cast<std::chrono::milliseconds>(kRunTime).count()
+			<< "ms per configuration, threads placed one per physical core first (scatter)\n";
+		std::cout << "\tcv is the coefficient of variation of per-thread acquisitions, max/min the spread between threads;\n"
+			"\tlatency is measured from starting to acquire to holding the lock\n";
+
+		for (auto cs_length : kCriticalSectionLengths)
+		{
+			std::cout << "\ncritical section of " << cs_length << " units\n";
+			print_header();
+			for (auto threads : thread_count_sweep())
+			{
+				worker_pool pool{ threads, placement::kScatter };
+				run_lock<std::mutex>("std::mutex", pool, cs_length);
+				run_lock<locks::tas_spinlock>("TAS", pool, cs_length);
+				run_lock<locks::ttas_spinlock>("TTAS", pool, cs_length);
+				run_lock<locks::ticket_lock>("ticket", pool, cs_length);
+				run_lock<locks::mcs_lock>("MCS", pool, cs_length);
+				run_lock<locks::futex_mutex>("futex", pool, cs_length);
+			}
+		}
+	}
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#pragma comment(lib, "Synchronization.lib")
+#else
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Lock implementations for the lock benchmarks, written to be dropped into production code as-is.
+// All of them are BasicLockable, i.e. they work with std::lock_guard and std::unique_lock.
+namespace perf::locks
+{
+    constexpr size_t kCacheLineSize = 64;
+
+    // test-and-set; every waiter hammers the line with RMWs
+    class alignas(kCacheLineSize) tas_spinlock
+    {
+    public:
+        void lock()
+        {
+            while (_locked.exchange(true, std::memory_order_acquire))
+                ;
+        }
+
+        bool try_lock()
+        {
+            return !_locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            _locked.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<bool> _locked{ false };
+    };
+
+    // test-and-test-and-set; waiters spin on a shared (read only) copy of the line
+    // and back off exponentially with pause after losing a race
+    class alignas(kCacheLineSize) ttas_spinlock
+    {
+    public:
+        void lock()
+        {
+            unsigned backoff = 1;
+            for (;;)
+            {
+                if (!_locked.exchange(true, std::memory_order_acquire))
+                    return;
+                while (_locked.load(std::memory_order_relaxed))
+                {
+                    for (auto n = 0u; n < backoff; ++n)
+                        _mm_pause();
+                    if (backoff < kMaxBackoff)
+                        backoff <<= 1;
+                }
+            }
+        }
+
+        bool try_lock()
+        {
+            return !_locked.load(std::memory_order_relaxed) && !_locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            _locked.store(false, std::memory_order_release);
+        }
+
+    private:
+        static constexpr unsigned kMaxBackoff = 1024;
+        std::atomic<bool> _locked{ false };
+    };
+
+    // FIFO; one RMW to take a ticket, then spin reading the "now serving" counter
+    class alignas(kCacheLineSize) ticket_lock
+    {
+    public:
+        void lock()
+        {
+            const auto ticket = _next.fetch_add(1, std::memory_order_relaxed);
+            for (;;)
+            {
+                const auto serving = _serving.load(std::memory_order_acquire);
+                if (serving == ticket)
+                    return;
+                // proportional backoff; the further back in the queue the longer we wait before looking again
+                for (auto n = 0u; n < (ticket - serving); ++n)
+                    _mm_pause();
+            }
+        }
+
+        bool try_lock()
+        {
+            auto serving = _serving.load(std::memory_order_relaxed);
+            return _next.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            _serving.store(_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<uint32_t> _next{ 0 };
+        std::atomic<uint32_t> _serving{ 0 };
+    };
+
+    // Mellor-Crummey & Scott queue lock; FIFO, and each waiter spins on its own node so a handover touches
+    // exactly one remote cache line.
+    // The explicit node API is the primary one, lock()/unlock() use a small per-thread stack of nodes
+    // which supports nested (LIFO) acquisition of up to kMaxNesting MCS locks per thread.
+    class alignas(kCacheLineSize) mcs_lock
+    {
+    public:
+        struct alignas(kCacheLineSize) node
+        {
+            std::atomic<node*> _next{ nullptr };
+            std::atomic<bool> _locked{ false };
+        };
+
+        void lock(node& n)
+        {
+            n._next.store(nullptr, std::memory_order_relaxed);
+            n._locked.store(true, std::memory_order_relaxed);
+            const auto prev = _tail.exchange(&n, std::memory_order_acq_rel);
+            if (prev)
+            {
+                prev->_next.store(&n, std::memory_order_release);
+                while (n._locked.load(std::memory_order_acquire))
+                    _mm_pause();
+            }
+        }
+
+        void unlock(node& n)
+        {
+            auto next = n._next.load(std::memory_order_acquire);
+            if (!next)
+            {
+                auto expected = &n;
+                if (_tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed))
+                    return;
+                // someone is in the middle of enqueuing behind us
+                while (!(next = n._next.load(std::memory_order_acquire)))
+                    _mm_pause();
+            }
+            next->_locked.store(false, std::memory_order_release);
+        }
+
+        void lock()
+        {
+            auto& nodes = this_thread_nodes();
+            auto& n = nodes._nodes[nodes._depth++];
+            lock(n);
+            _holder = &n;
+        }
+
+        void unlock()
+        {
+            auto& n = *_holder;
+            unlock(n);
+            --this_thread_nodes()._depth;
+        }
+
+    private:
+        static constexpr size_t kMaxNesting = 8;
+        struct thread_nodes
+        {
+            node _nodes[kMaxNesting];
+            size_t _depth = 0;
+        };
+        static thread_nodes& this_thread_nodes()
+        {
+            thread_local thread_nodes _nodes;
+            return _nodes;
+        }
+
+        std::atomic<node*> _tail{ nullptr };
+        // only ever touched by the current holder
+        node* _holder = nullptr;
+    };
+
+    // Drepper's "Futexes are tricky" mutex 3; 0: unlocked, 1: locked, 2: locked with (possible) waiters.
+    // Uncontended lock/unlock is a single RMW each and never enters the kernel.
+    class alignas(kCacheLineSize) futex_mutex
+    {
+    public:
+        void lock()
+        {
+            uint32_t c = 0;
+            if (_state.compare_exchange_strong(c, 1, std::memory_order_acquire))
+                return;
+            if (c != 2)
+                c = _state.exchange(2, std::memory_order_acquire);
+            while (c != 0)
+            {
+                wait(2);
+                c = _state.exchange(2, std::memory_order_acquire);
+            }
+        }
+
+        bool try_lock()
+        {
+            uint32_t c = 0;
+            return _state.compare_exchange_strong(c, 1, std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            if (_state.fetch_sub(1, std::memory_order_release) != 1)
+            {
+                _state.store(0, std::memory_order_release);
+                wake_one();
+            }
+        }
+
+    private:
+        void wait(uint32_t expected)
+        {
+#if defined(__linux__)
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+            WaitOnAddress(&_state, &expected, sizeof(expected), INFINITE);
+#else
+            while (_state.load(std::memory_order_relaxed) == expected)
+                std::this_thread::yield();
+#endif
+        }
+
+        void wake_one()
+        {
+#if defined(__linux__)
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+            WakeByAddressSingle(&_state);
+#endif
+        }
+
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32 bit integer");
+        std::atomic<uint32_t> _state{ 0 };
+    };
+}
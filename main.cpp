@@ -1,15 +1,24 @@
 
 #include "hayai/hayai.hpp"
+#include "hayai/hayai_main.hpp"
 #include "thread_tests.h"
 
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <vector>
+#include <set>
 #include <ctime>
 #include <iostream>
 
 #include "cpuid.h"
+#include "cpu_features.h"
+#include "topology.h"
+#include "core_type_context.h"
+#include "cpu_set_context.h"
+#include "preflight.h"
+#include "core_clock.h"
+#include "clock_probe.h"
 
 namespace perf
 {
@@ -79,8 +88,17 @@ namespace perf
     	_vendor_string[12] = 0;
 		std::cout << "cpuid vendor \"" << _vendor_string << "\"\n";		
 
+		const auto& features = cpu_features();
+		std::cout << "features:";
+		for(auto f = 0u; f < unsigned(feature::kCount); ++f)
+		{
+			if(features.has(feature(f)))
+				std::cout << " " << feature_name(feature(f));
+		}
+		std::cout << "\n";
+
 		cpu_id = 1;
-		_proc_info._cpuid_caps._ht = cpu_id.bits_set(cpuid::regs::edx, 1<<28);
+		_proc_info._cpuid_caps._ht = features.has(feature::kHTT);
 		
 		//NOTE: for the time being following https://software.intel.com/sites/default/files/managed/ba/f1/intel-64-architecture-processor-topology-enumeration.pdf
 		//		which strangely does *not* cover leaf 0x1f
@@ -172,6 +190,17 @@ namespace perf
 		}
 		
 		std::cout << "phys cores (processors) " << _proc_info._phys_cores << ", logical cores " << _proc_info._num_cores << "\n";
+
+		if(features.has(feature::kHybrid))
+		{
+			size_t p_cores = 0, e_cores = 0;
+			for(const auto& lp : topology())
+			{
+				p_cores += lp._core_type == core_type::kPerformance;
+				e_cores += lp._core_type == core_type::kEfficient;
+			}
+			std::cout << "hybrid part; " << std::dec << p_cores << " logical P-cores, " << e_cores << " logical E-cores\n";
+		}
 	}
 
 	void set_thread_affinity(std::thread& t, size_t phys_core)
@@ -202,24 +231,130 @@ namespace perf
 		clock_getres(CLOCK_MONOTONIC, &res);
 		std::cout << "\tCLOCK_MONOTONIC: " << res.tv_sec << "s:" << res.tv_nsec << "ns\n";
 #endif
+
+		// what the core is actually running at right now, with a single thread busy
+		std::cout << "Core clock:\n";
+		system_info::core_clock clock;
+		system_info::clock_reading start, end;
+		uint64_t cycles = 0, active_ns = 0;
+		const auto source = clock.open();
+		if (source != system_info::clock_source::kNone && clock.read(start))
+		{
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+			while (std::chrono::steady_clock::now() < deadline)
+				;
+			if (clock.read(end) && system_info::clock_elapsed(start, end, cycles, active_ns))
+				std::cout << "\teffective frequency " << double(cycles) / double(active_ns) << "GHz (" << system_info::clock_source_name(source) << ")\n";
+		}
+		if (!active_ns)
+			std::cout << "\tnot available; needs perf_event access to the cycle counter or read access to /dev/cpu/*/msr\n";
 	}
 }
 
-void bench_hayai()
+// the usual hayai options, plus
+//	--core-types	run every benchmark once pinned to a P-core and once pinned to an E-core (hybrid parts only)
+//	--no-preflight	don't check the machine for sources of noise before running (see preflight.h)
+//	--no-clock		don't measure the effective core clock frequency of every run (see core_clock.h)
+// and --jobs gives every shard a disjoint set of whole physical cores, and paired comparisons run pinned to one CPU
+int bench_hayai(int argc, char** argv)
 {
-    hayai::ConsoleOutputter consoleOutputter;
-    hayai::Benchmarker::AddOutputter(consoleOutputter);
+    hayai::MainRunner runner;
+    std::vector<char*> residual;
+    auto result = runner.ParseArgs(argc, argv, &residual);
+    if (result)
+        return result;
+
+    bool preflight = true;
+    bool clock = true;
+    for (auto arg : residual)
+    {
+        if (!strcmp(arg, "--core-types"))
+        {
+            if (!perf::add_core_type_contexts())
+                std::cerr << "--core-types: this isn't a hybrid part, or we're not allowed to run on both core types; running unpinned\n";
+        }
+        else if (!strcmp(arg, "--no-preflight"))
+        {
+            preflight = false;
+        }
+        else if (!strcmp(arg, "--no-clock"))
+        {
+            clock = false;
+        }
+        else
+        {
+            std::cerr << "unknown option: " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // both sides of a BENCHMARK_COMPARE pair on the same core, unless --core-types already pins everything
+    hayai::Benchmarker::SetComparisonContext(perf::single_cpu_context());
+
+    if (runner.Jobs > 1)
+    {
+        runner.ShardContexts = perf::core_shard_contexts(runner.Jobs);
+        if (runner.ShardContexts.size() < runner.Jobs)
+            std::cerr << "--jobs: only " << runner.ShardContexts.size() << " physical cores available, running that many shards\n";
+    }
+
+    // what the results were measured on, so result files can be told apart and filtered later
+    {
+        std::set<std::pair<unsigned, unsigned>> cores;
+        std::set<unsigned> packages;
+        for (const auto& lp : system_info::topology())
+        {
+            cores.emplace(lp._package_id, lp._core_id);
+            packages.insert(lp._package_id);
+        }
+        hayai::Benchmarker::AddEnvironment("cpu", system_info::cpu_brand());
+        hayai::Benchmarker::AddEnvironment("packages", std::to_string(packages.size()));
+        hayai::Benchmarker::AddEnvironment("cores", std::to_string(cores.size()));
+        hayai::Benchmarker::AddEnvironment("logical_processors", std::to_string(system_info::topology().size()));
+        hayai::Benchmarker::AddEnvironment("tsc_ghz", std::to_string(perf::tsc_ticks_per_ns()));
+    }
+
+    // warnings go to stderr so they don't end up in the middle of json on stdout; the data goes in with the results
+    if (preflight)
+    {
+        const auto report = system_info::preflight();
+        for (const auto& warning : report._warnings)
+            std::cerr << "preflight: " << warning << "\n";
+        for (const auto& property : report._properties)
+            hayai::Benchmarker::AddEnvironment(property.first, property.second);
+    }
+
+    static perf::core_clock_probe clock_probe;
+    if (clock)
+    {
+        const auto source = clock_probe.open();
+        if (source != system_info::clock_source::kNone)
+            hayai::Benchmarker::SetClockProbe(&clock_probe);
+        else
+            std::cerr << "no access to the core clock counters; results won't include the effective frequency\n";
+        hayai::Benchmarker::AddEnvironment("clock_source", system_info::clock_source_name(source));
+    }
+
+    if (!runner.StdoutOutputter)
+        runner.StdoutOutputter = new hayai::ConsoleOutputter();
     std::cout << "Running benchmarks...please wait while Hayai starts...\n";
-    hayai::Benchmarker::RunAllTests();
+    return runner.Run();
 }
 
-int main()
+int main(int argc, char** argv)
 {    
+	(void)argc;
+	(void)argv;
 	perf::init_processor_info();
 	perf::print_info();
 	//perf::threads::test_ht_workers();
-    //bench_hayai();
+    //return bench_hayai(argc, argv);
     //perf::threads::test_wait_loops();
+	//perf::threads::test_atomic_contention();
+	//perf::threads::test_locks();
+	//perf::threads::test_queues();
+	//perf::threads::test_scheduler();
+	//perf::threads::test_simd_kernels();
 
 	return 0;
 }
@@ -3,6 +3,16 @@
 #include <limits>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
 
 namespace perf
 {
@@ -18,6 +28,103 @@ namespace perf
             || std::abs(x - y) < (std::numeric_limits<T>::min)();
     }
 
+    inline uint64_t rdtsc()
+    {
+        return __rdtsc();
+    }
+
+    // TSC ticks per nanosecond, calibrated once against the steady clock
+    //NOTE: only meaningful on hardware with an invariant TSC, which is anything we care about
+    inline double tsc_ticks_per_ns()
+    {
+        static const double _ticks_per_ns = []() {
+            using clock = std::chrono::steady_clock;
+            const auto t0 = clock::now();
+            const auto c0 = rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const auto t1 = clock::now();
+            const auto c1 = rdtsc();
+            return double(c1 - c0) / double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        }();
+        return _ticks_per_ns;
+    }
+
+    // Kahan compensated sums of (x - shift) and (x - shift)^2 over xs[0..n), four lanes at a time in two SSE2
+    // registers (which every x64 CPU has, so there's nothing to dispatch on). shifting by a value close to the mean,
+    // e.g. the first sample, keeps the sum of squares from cancelling catastrophically when the spread is small
+    // compared to the values themselves, as it is for run times.
+    inline void shifted_sums(const double* xs, size_t n, double shift, double& sum, double& sum_sq)
+    {
+        const __m128d k = _mm_set1_pd(shift);
+        __m128d s[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+        __m128d c[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+        __m128d s2[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+        __m128d c2[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            for (int h = 0; h < 2; ++h)
+            {
+                const __m128d d = _mm_sub_pd(_mm_loadu_pd(xs + i + 2 * h), k);
+                const __m128d y = _mm_sub_pd(d, c[h]);
+                const __m128d t = _mm_add_pd(s[h], y);
+                c[h] = _mm_sub_pd(_mm_sub_pd(t, s[h]), y);
+                s[h] = t;
+                const __m128d y2 = _mm_sub_pd(_mm_mul_pd(d, d), c2[h]);
+                const __m128d t2 = _mm_add_pd(s2[h], y2);
+                c2[h] = _mm_sub_pd(_mm_sub_pd(t2, s2[h]), y2);
+                s2[h] = t2;
+            }
+        }
+
+        // fold the lanes and the tail into one compensated sum each
+        double lanes[4], lane_cs[4], lanes2[4], lane_cs2[4];
+        for (int h = 0; h < 2; ++h)
+        {
+            _mm_storeu_pd(lanes + 2 * h, s[h]);
+            _mm_storeu_pd(lane_cs + 2 * h, c[h]);
+            _mm_storeu_pd(lanes2 + 2 * h, s2[h]);
+            _mm_storeu_pd(lane_cs2 + 2 * h, c2[h]);
+        }
+        double total = 0.0, total_c = 0.0, total2 = 0.0, total_c2 = 0.0;
+        const auto add = [](double& acc, double& comp, double x) {
+            const double y = x - comp;
+            const double t = acc + y;
+            comp = (t - acc) - y;
+            acc = t;
+        };
+        for (int l = 0; l < 4; ++l)
+        {
+            add(total, total_c, lanes[l]);
+            add(total, total_c, -lane_cs[l]);
+            add(total2, total_c2, lanes2[l]);
+            add(total2, total_c2, -lane_cs2[l]);
+        }
+        for (; i < n; ++i)
+        {
+            const double d = xs[i] - shift;
+            add(total, total_c, d);
+            add(total2, total_c2, d * d);
+        }
+        sum = total;
+        sum_sq = total2;
+    }
+
+    // nth_element for several ranks at once; ranks must be sorted. each selection partitions the range, so the
+    // ranks on either side only need to look at their own part of it and the whole lot costs about as much as a
+    // single nth_element over the full range
+    template<typename Iter>
+    void select_ranks(Iter first, Iter last, const size_t* ranks_first, const size_t* ranks_last, size_t offset = 0)
+    {
+        if (ranks_first == ranks_last || first == last)
+            return;
+        const size_t* pivot = ranks_first + (ranks_last - ranks_first) / 2;
+        const auto nth = first + (*pivot - offset);
+        std::nth_element(first, nth, last);
+        select_ranks(first, nth, ranks_first, pivot, offset);
+        select_ranks(nth + 1, last, pivot + 1, ranks_last, *pivot + 1);
+    }
+
     struct Stats
     {
         virtual void push(double x)
@@ -26,6 +133,12 @@ namespace perf
             _dirty = true;
         }
 
+        virtual void push_many(const double* xs, size_t n)
+        {
+            _samples.insert(_samples.end(), xs, xs + n);
+            _dirty = true;
+        }
+
         void reset()
         {
             _samples.clear();
@@ -50,6 +163,35 @@ namespace perf
             return _3rdquart;
         }
 
+        // p in [0,1], nearest rank
+        double percentile(double p)
+        {
+            if (_samples.empty())
+                return 0.0;
+            const auto rank = size_t(p * double(_samples.size() - 1) + 0.5);
+            std::nth_element(_samples.begin(), _samples.begin() + rank, _samples.end());
+            return _samples[rank];
+        }
+
+        // several nearest rank percentiles in one selection pass; ps in [0,1], any order
+        void percentiles(const double* ps, double* values, size_t count)
+        {
+            if (_samples.empty())
+            {
+                std::fill(values, values + count, 0.0);
+                return;
+            }
+            std::vector<size_t> ranks(count);
+            for (size_t n = 0; n < count; ++n)
+                ranks[n] = size_t(ps[n] * double(_samples.size() - 1) + 0.5);
+            std::vector<size_t> sorted{ ranks };
+            std::sort(sorted.begin(), sorted.end());
+            sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+            select_ranks(_samples.begin(), _samples.end(), sorted.data(), sorted.data() + sorted.size());
+            for (size_t n = 0; n < count; ++n)
+                values[n] = _samples[ranks[n]];
+        }
+
         enum class Shape
         {
             kLeft,
@@ -59,8 +201,15 @@ namespace perf
 
         Shape shape()
         {
-            const double d1 = abs(median() - first_quartile());
-	        const double d3 = abs(median() - third_quartile());
+            return shape_of(*this);
+        }
+
+        // the shape from the quartiles of anything with the Stats interface
+        template<typename T>
+        static Shape shape_of(T& stats)
+        {
+            const double d1 = std::abs(stats.median() - stats.first_quartile());
+	        const double d3 = std::abs(stats.median() - stats.third_quartile());
 	        if(AlmostEqual(d1,d3))
                 return Shape::kSymmetric;
             return (d1 < d3) ? Shape::kLeft : Shape::kRight;
@@ -75,52 +224,417 @@ namespace perf
         double _3rdquart = 0.0;
         bool _dirty = true;
 
+        // the quartiles and median interpolate linearly between the two samples either side of p * (n - 1), like
+        // R's default and numpy's; so the median of an even number of samples is the mean of the middle two
         void recalc()
         {
             if (_dirty)
             {
-                const auto mid_iter = _samples.begin() + _samples.size() / 2;
-                //NOTE: we're not doing this "properly" for odd sizes but that's not a big deal for our use
-                std::nth_element(_samples.begin(), mid_iter, _samples.end());
-                _median = _samples[_samples.size()/2];
-                
-                std::nth_element(_samples.begin(), _samples.begin() + _samples.size() / 4, mid_iter);
-                _1stquart = _samples[_samples.size()/4];
+                _dirty = false;
+                if (_samples.empty())
+                {
+                    _median = _1stquart = _3rdquart = 0.0;
+                    return;
+                }
 
-                std::nth_element(mid_iter, mid_iter+_samples.size()/4,_samples.end());
-                _3rdquart = _samples[_samples.size()/2 + _samples.size()/4];
+                const double ps[3] = { 0.25, 0.5, 0.75 };
+                size_t ranks[6];
+                size_t count = 0;
+                for (auto p : ps)
+                {
+                    const auto below = size_t(p * double(_samples.size() - 1));
+                    ranks[count++] = below;
+                    ranks[count++] = std::min(below + 1, _samples.size() - 1);
+                }
+                std::sort(ranks, ranks + count);
+                count = size_t(std::unique(ranks, ranks + count) - ranks);
+                select_ranks(_samples.begin(), _samples.end(), ranks, ranks + count);
 
-                _dirty = false;
+                double* values[3] = { &_1stquart, &_median, &_3rdquart };
+                for (int q = 0; q < 3; ++q)
+                {
+                    const double h = ps[q] * double(_samples.size() - 1);
+                    const auto below = size_t(h);
+                    const auto above = std::min(below + 1, _samples.size() - 1);
+                    *values[q] = _samples[below] + (h - double(below)) * (_samples[above] - _samples[below]);
+                }
             }
         }
     };
 
-    // Incremental statistics class
-    // See https://www.johndcook.com/blog/standard_deviation/
-    struct RunningStat : Stats
+    // Streaming estimate of a single quantile in constant memory, using the P-square algorithm;
+    // See Jain & Chlamtac, "The P2 algorithm for dynamic calculation of quantiles and histograms without storing
+    // observations", CACM 28(10), 1985
+    // five markers track the minimum, p/2, p, (1+p)/2 and the maximum; their heights are nudged towards where they
+    // should be with a piecewise parabolic fit every time a sample comes in
+    struct P2Quantile
     {
-        void push(double x) override
+        explicit P2Quantile(double p = 0.5)
+            : _p(p)
         {
-            // See Knuth TAOCP vol 2, 3rd edition, page 232
-            if(size() > 1)
+            reset();
+        }
+
+        void push(double x)
+        {
+            if (_count < 5)
             {
-                const auto previousMean{ _mean };
-                _mean = _mean + (x - _mean) / size();
-                _S = _S + (x - previousMean) * (x - _mean);
+                _heights[_count++] = x;
+                if (_count == 5)
+                    std::sort(_heights, _heights + 5);
+                return;
+            }
+            ++_count;
+
+            // find the cell x falls into, stretching the extremes if need be
+            int k;
+            if (x < _heights[0])
+            {
+                _heights[0] = x;
+                k = 0;
+            }
+            else if (x >= _heights[4])
+            {
+                _heights[4] = x;
+                k = 3;
             }
             else
             {
-                _mean = x;
+                k = 0;
+                while (x >= _heights[k + 1])
+                    ++k;
+            }
+
+            for (int i = k + 1; i < 5; ++i)
+                ++_positions[i];
+            for (int i = 0; i < 5; ++i)
+                _desired[i] += _increments[i];
+
+            // move the middle markers one position at a time if they've drifted
+            for (int i = 1; i < 4; ++i)
+            {
+                const double d = _desired[i] - double(_positions[i]);
+                if ((d >= 1.0 && _positions[i + 1] - _positions[i] > 1) || (d <= -1.0 && _positions[i - 1] - _positions[i] < -1))
+                {
+                    const int step = d > 0.0 ? 1 : -1;
+                    const double h = parabolic(i, step);
+                    _heights[i] = (_heights[i - 1] < h && h < _heights[i + 1]) ? h : linear(i, step);
+                    _positions[i] += step;
+                }
             }
-            
-            Stats::push(x);
         }
 
+        void reset()
+        {
+            _count = 0;
+            for (int i = 0; i < 5; ++i)
+            {
+                _heights[i] = 0.0;
+                _positions[i] = i + 1;
+            }
+            _desired[0] = 1.0;
+            _desired[1] = 1.0 + 2.0 * _p;
+            _desired[2] = 1.0 + 4.0 * _p;
+            _desired[3] = 3.0 + 2.0 * _p;
+            _desired[4] = 5.0;
+            _increments[0] = 0.0;
+            _increments[1] = _p / 2.0;
+            _increments[2] = _p;
+            _increments[3] = (1.0 + _p) / 2.0;
+            _increments[4] = 1.0;
+        }
+
+        // the estimate; exact (nearest rank) until there are five samples
+        double value() const
+        {
+            if (_count >= 5)
+                return _heights[2];
+            if (!_count)
+                return 0.0;
+            double sorted[5];
+            std::copy(_heights, _heights + _count, sorted);
+            std::sort(sorted, sorted + _count);
+            return sorted[size_t(_p * double(_count - 1) + 0.5)];
+        }
+
+        size_t size() const { return _count; }
+
+    private:
+        double _p;
+        size_t _count = 0;
+        double _heights[5];
+        int _positions[5];
+        double _desired[5];
+        double _increments[5];
+
+        double parabolic(int i, int d) const
+        {
+            const double n0 = _positions[i - 1], n1 = _positions[i], n2 = _positions[i + 1];
+            return _heights[i] + double(d) / (n2 - n0) * (
+                (n1 - n0 + d) * (_heights[i + 1] - _heights[i]) / (n2 - n1) +
+                (n2 - n1 - d) * (_heights[i] - _heights[i - 1]) / (n1 - n0));
+        }
+
+        double linear(int i, int d) const
+        {
+            return _heights[i] + double(d) * (_heights[i + d] - _heights[i]) / double(_positions[i + d] - _positions[i]);
+        }
+    };
+
+    // the Stats quartiles in constant memory, for probes that run for hours
+    struct P2Stats
+    {
+        void push(double x)
+        {
+            _1stquart.push(x);
+            _median.push(x);
+            _3rdquart.push(x);
+        }
+
+        void push_many(const double* xs, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                push(xs[i]);
+        }
+
+        void reset()
+        {
+            _1stquart.reset();
+            _median.reset();
+            _3rdquart.reset();
+        }
+
+        double median() const { return _median.value(); }
+        double first_quartile() const { return _1stquart.value(); }
+        double third_quartile() const { return _3rdquart.value(); }
+
+        Stats::Shape shape() const { return Stats::shape_of(*this); }
+
+        size_t size() const { return _median.size(); }
+
+    private:
+        P2Quantile _1stquart{ 0.25 };
+        P2Quantile _median{ 0.5 };
+        P2Quantile _3rdquart{ 0.75 };
+    };
+
+    // Mergeable streaming estimate of arbitrary quantiles, using a merging t-digest;
+    // See Dunning & Ertl, "Computing extremely accurate quantiles using t-digests", 2019
+    // samples are buffered and then folded into a sorted set of weighted centroids whose size is bounded by the
+    // compression; centroids are kept small near the tails (scale function k1) so the extreme percentiles stay
+    // accurate. digests from different threads or runs can be merged
+    struct TDigest
+    {
+        explicit TDigest(double compression = 100.0)
+            : _compression(compression)
+        {
+            _buffer.reserve(buffer_limit());
+        }
+
+        void push(double x, double weight = 1.0)
+        {
+            if (_buffer.size() >= buffer_limit())
+                compress();
+            _buffer.emplace_back(Centroid{ x, weight });
+            _min = std::min(_min, x);
+            _max = std::max(_max, x);
+        }
+
+        void push_many(const double* xs, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                push(xs[i]);
+        }
+
+        void merge(const TDigest& other)
+        {
+            other.compress();
+            compress();
+            _buffer.insert(_buffer.end(), other._centroids.begin(), other._centroids.end());
+            _min = std::min(_min, other._min);
+            _max = std::max(_max, other._max);
+            compress();
+        }
+
+        void reset()
+        {
+            _centroids.clear();
+            _buffer.clear();
+            _min = std::numeric_limits<double>::infinity();
+            _max = -std::numeric_limits<double>::infinity();
+        }
+
+        // q in [0,1], interpolated between centroids
+        double quantile(double q) const
+        {
+            compress();
+            if (_centroids.empty())
+                return 0.0;
+            if (_centroids.size() == 1)
+                return _centroids[0]._mean;
+
+            double total = 0.0;
+            for (const auto& c : _centroids)
+                total += c._weight;
+            const double target = std::clamp(q, 0.0, 1.0) * total;
+
+            // each centroid's mean sits at the middle of its weight
+            double cumulative = 0.0;
+            double previous_center = 0.0;
+            for (size_t i = 0; i < _centroids.size(); ++i)
+            {
+                const double center = cumulative + _centroids[i]._weight / 2.0;
+                if (target < center)
+                {
+                    if (!i)
+                        return _min + (_centroids[0]._mean - _min) * (center > 0.0 ? target / center : 0.0);
+                    const double t = (target - previous_center) / (center - previous_center);
+                    return _centroids[i - 1]._mean + t * (_centroids[i]._mean - _centroids[i - 1]._mean);
+                }
+                cumulative += _centroids[i]._weight;
+                previous_center = center;
+            }
+            const double tail = total - previous_center;
+            return _centroids.back()._mean + (_max - _centroids.back()._mean) * (tail > 0.0 ? (target - previous_center) / tail : 1.0);
+        }
+
+        // p in [0,1], as for Stats
+        double percentile(double p) const { return quantile(p); }
+
+        double median() const { return quantile(0.5); }
+        double first_quartile() const { return quantile(0.25); }
+        double third_quartile() const { return quantile(0.75); }
+
+        Stats::Shape shape() const { return Stats::shape_of(*this); }
+
+        size_t size() const
+        {
+            double total = 0.0;
+            for (const auto& c : _centroids)
+                total += c._weight;
+            for (const auto& c : _buffer)
+                total += c._weight;
+            return size_t(total + 0.5);
+        }
+
+        size_t centroids() const
+        {
+            compress();
+            return _centroids.size();
+        }
+
+    private:
+        struct Centroid
+        {
+            double _mean;
+            double _weight;
+        };
+
+        double _compression;
+        double _min = std::numeric_limits<double>::infinity();
+        double _max = -std::numeric_limits<double>::infinity();
+        // compressed lazily, on query, so these are mutable
+        mutable std::vector<Centroid> _centroids;
+        mutable std::vector<Centroid> _buffer;
+
+        size_t buffer_limit() const
+        {
+            return size_t(_compression) * 5;
+        }
+
+        // scale function k1 and its inverse; a centroid may span at most one unit of k
+        double k_of_q(double q) const
+        {
+            return _compression / (2.0 * kPi) * std::asin(2.0 * q - 1.0);
+        }
+
+        double q_of_k(double k) const
+        {
+            return (std::sin(std::min(k * 2.0 * kPi / _compression, kPi / 2.0)) + 1.0) / 2.0;
+        }
+
+        void compress() const
+        {
+            if (_buffer.empty())
+                return;
+            _buffer.insert(_buffer.end(), _centroids.begin(), _centroids.end());
+            std::sort(_buffer.begin(), _buffer.end(), [](const Centroid& a, const Centroid& b) { return a._mean < b._mean; });
+
+            double total = 0.0;
+            for (const auto& c : _buffer)
+                total += c._weight;
+
+            _centroids.clear();
+            Centroid current = _buffer[0];
+            double so_far = 0.0;
+            double limit = q_of_k(k_of_q(0.0) + 1.0) * total;
+            for (size_t i = 1; i < _buffer.size(); ++i)
+            {
+                const auto& next = _buffer[i];
+                if (so_far + current._weight + next._weight <= limit)
+                {
+                    current._mean += (next._mean - current._mean) * next._weight / (current._weight + next._weight);
+                    current._weight += next._weight;
+                }
+                else
+                {
+                    so_far += current._weight;
+                    _centroids.push_back(current);
+                    limit = q_of_k(k_of_q(so_far / total) + 1.0) * total;
+                    current = next;
+                }
+            }
+            _centroids.push_back(current);
+            _buffer.clear();
+        }
+
+        static constexpr double kPi = 3.14159265358979323846;
+    };
+
+    // Incremental statistics class
+    // See https://www.johndcook.com/blog/standard_deviation/
+    // the quantiles come from the Quantiles base; Stats keeps every sample, P2Stats or TDigest keep constant memory,
+    // so a long running probe can switch by changing only the type
+    template<typename Quantiles>
+    struct BasicRunningStat : Quantiles
+    {
+        void push(double x)
+        {
+            Quantiles::push(x);
+
+            // See Knuth TAOCP vol 2, 3rd edition, page 232
+            const auto previousMean{ _mean };
+            _mean = _mean + (x - _mean) / size();
+            _S = _S + (x - previousMean) * (x - _mean);
+        }
+
+        // the same as pushing them one by one, but the batch's moments come from one (SIMD, compensated) pass and
+        // are folded in with Chan et al's parallel update, so it's both faster and more accurate
+        void push_many(const double* xs, size_t n)
+        {
+            if (!n)
+                return;
+            const auto na = double(size());
+            Quantiles::push_many(xs, n);
+
+            double sum, sum_sq;
+            shifted_sums(xs, n, xs[0], sum, sum_sq);
+            const auto nb = double(n);
+            const auto batchMean = xs[0] + sum / nb;
+            const auto batchS = std::max(0.0, sum_sq - sum * sum / nb);
+
+            const auto delta = batchMean - _mean;
+            _mean = _mean + delta * nb / (na + nb);
+            _S = _S + batchS + delta * delta * na * nb / (na + nb);
+        }
+
+        using Quantiles::size;
+
         void reset()
         {
             _mean = 0.0;
             _S = 0.0;
-            Stats::reset();
+            Quantiles::reset();
         }
 
         double mean() const
@@ -142,4 +656,239 @@ namespace perf
         double _mean{ 0.0 };
         double _S{ 0.0 };
     };
+
+    using RunningStat = BasicRunningStat<Stats>;
+    using StreamingRunningStat = BasicRunningStat<P2Stats>;
+
+    constexpr size_t kCacheLineSize = 64;
+
+    // Count, mean and variance that can be built up one sample at a time and combined;
+    // See Welford (1962) for the update, and Chan, Golub & LeVeque, "Updating formulae and a pairwise algorithm for
+    // computing sample variances" (1979) for the merge
+    struct Moments
+    {
+        void push(double x)
+        {
+            ++_count;
+            const double delta = x - _mean;
+            _mean += delta / double(_count);
+            _m2 += delta * (x - _mean);
+            _min = std::min(_min, x);
+            _max = std::max(_max, x);
+        }
+
+        void merge(const Moments& other)
+        {
+            if (!other._count)
+                return;
+            if (!_count)
+            {
+                *this = other;
+                return;
+            }
+            const double na = double(_count);
+            const double nb = double(other._count);
+            const double n = na + nb;
+            const double delta = other._mean - _mean;
+            _mean += delta * nb / n;
+            _m2 += other._m2 + delta * delta * na * nb / n;
+            _count += other._count;
+            _min = std::min(_min, other._min);
+            _max = std::max(_max, other._max);
+        }
+
+        void reset()
+        {
+            *this = Moments{};
+        }
+
+        size_t size() const { return _count; }
+        double mean() const { return _mean; }
+        double variance() const { return (_count > 1) ? _m2 / double(_count - 1) : 0.0; }
+        double stdev() const { return std::sqrt(variance()); }
+        double min() const { return _count ? _min : 0.0; }
+        double max() const { return _count ? _max : 0.0; }
+
+    private:
+        size_t _count = 0;
+        double _mean = 0.0;
+        double _m2 = 0.0;
+        double _min = std::numeric_limits<double>::infinity();
+        double _max = -std::numeric_limits<double>::infinity();
+    };
+
+    // Log-linear histogram of non-negative values, kSubBuckets linear buckets per power of two from 1 up to 2^63
+    // (anything below 1 goes in the first bucket), HDR style: a bucket is at most 1/kSubBuckets of its value wide, and
+    // quantiles interpolate inside the bucket, so e.g. 5 ms samples resolve to better than 40 us; merging is adding up
+    // the counts
+    struct LogHistogram
+    {
+        static constexpr size_t kSubBuckets = 128;
+        static constexpr size_t kBuckets = 64 * kSubBuckets;
+
+        void push(double x)
+        {
+            ++_counts[bucket_of(x)];
+        }
+
+        void merge(const LogHistogram& other)
+        {
+            for (size_t b = 0; b < kBuckets; ++b)
+                _counts[b] += other._counts[b];
+        }
+
+        void reset()
+        {
+            std::fill(std::begin(_counts), std::end(_counts), uint64_t(0));
+        }
+
+        // p in [0,1]; linear interpolation between the ranks, taking the samples of a bucket as spread evenly over it
+        double percentile(double p) const
+        {
+            uint64_t total = 0;
+            for (auto count : _counts)
+                total += count;
+            if (!total)
+                return 0.0;
+            const auto rank = std::clamp(p, 0.0, 1.0) * double(total - 1);
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < kBuckets; ++b)
+            {
+                if (!_counts[b])
+                    continue;
+                if (double(cumulative + _counts[b]) > rank)
+                {
+                    // the i'th of the bucket's n samples sits at (i + 0.5) / n of the way through it
+                    const auto position = (rank - double(cumulative) + 0.5) / double(_counts[b]);
+                    const auto low = lower_bound(b);
+                    return low + (lower_bound(b + 1) - low) * position;
+                }
+                cumulative += _counts[b];
+            }
+            return lower_bound(kBuckets);
+        }
+
+        double median() const { return percentile(0.5); }
+        double first_quartile() const { return percentile(0.25); }
+        double third_quartile() const { return percentile(0.75); }
+
+        uint64_t count(size_t bucket) const { return _counts[bucket]; }
+
+        static size_t bucket_of(double x)
+        {
+            if (!(x >= 1.0))
+                return 0;
+            int exponent;
+            // x = m * 2^exponent, m in [0.5, 1)
+            const double m = std::frexp(x, &exponent);
+            const auto b = size_t(exponent - 1) * kSubBuckets + size_t((m * 2.0 - 1.0) * double(kSubBuckets));
+            return std::min(b, kBuckets - 1);
+        }
+
+        static double lower_bound(size_t bucket)
+        {
+            const auto octave = bucket / kSubBuckets;
+            const auto step = bucket % kSubBuckets;
+            return std::ldexp(1.0 + double(step) / double(kSubBuckets), int(octave));
+        }
+
+    private:
+        uint64_t _counts[kBuckets] = {};
+    };
+
+    // Moments plus a histogram for the quantiles
+    struct StatAccumulator
+    {
+        void push(double x)
+        {
+            _moments.push(x);
+            _histogram.push(x);
+        }
+
+        void merge(const StatAccumulator& other)
+        {
+            _moments.merge(other._moments);
+            _histogram.merge(other._histogram);
+        }
+
+        void reset()
+        {
+            _moments.reset();
+            _histogram.reset();
+        }
+
+        size_t size() const { return _moments.size(); }
+        double mean() const { return _moments.mean(); }
+        double variance() const { return _moments.variance(); }
+        double stdev() const { return _moments.stdev(); }
+        double min() const { return _moments.min(); }
+        double max() const { return _moments.max(); }
+        // clamped to the exact extremes, so a quantile never falls outside the samples
+        double percentile(double p) const { return std::clamp(_histogram.percentile(p), min(), max()); }
+        double median() const { return percentile(0.5); }
+        double first_quartile() const { return percentile(0.25); }
+        double third_quartile() const { return percentile(0.75); }
+
+        Stats::Shape shape() const { return Stats::shape_of(*this); }
+
+        const LogHistogram& histogram() const { return _histogram; }
+
+    private:
+        Moments _moments;
+        LogHistogram _histogram;
+    };
+
+    // One StatAccumulator per thread, each in cache lines of its own, so that recording a sample is a handful of
+    // plain stores to memory no other thread touches; no atomics, no locks, no false sharing. reduce() once the
+    // threads are done.
+    // usage:
+    // perf::PerThreadStats stats{ thread_count };
+    // ...on thread t:
+    //     stats[t].push(sample);
+    // ...after joining:
+    // const auto all = stats.reduce();
+    class PerThreadStats
+    {
+    public:
+        explicit PerThreadStats(size_t threads)
+            : _slots(threads)
+        {
+        }
+
+        StatAccumulator& operator[](size_t thread)
+        {
+            return _slots[thread];
+        }
+
+        const StatAccumulator& operator[](size_t thread) const
+        {
+            return _slots[thread];
+        }
+
+        size_t size() const
+        {
+            return _slots.size();
+        }
+
+        StatAccumulator reduce() const
+        {
+            StatAccumulator all;
+            for (const auto& slot : _slots)
+                all.merge(slot);
+            return all;
+        }
+
+        void reset()
+        {
+            for (auto& slot : _slots)
+                slot.reset();
+        }
+
+    private:
+        struct alignas(kCacheLineSize) Slot : StatAccumulator
+        {
+        };
+
+        std::vector<Slot> _slots;
+    };
 }
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perfutils.h"
+#include "topology.h"
+
+// a look at the machine before we trust it with a benchmark run: frequency scaling, turbo, SMT, CPU isolation,
+// background load and transparent hugepages, plus a direct measurement of how much each CPU gets interrupted.
+// usage:
+// const auto report = system_info::preflight();
+// for (const auto& warning : report._warnings)
+//     std::cerr << "preflight: " << warning << "\n";
+namespace system_info
+{
+    struct preflight_report
+    {
+        // name/value pairs, in the order they were gathered, e.g. { "scaling_governor", "performance" }
+        std::vector<std::pair<std::string, std::string>> _properties;
+        // things that are likely to make results noisy or skewed
+        std::vector<std::string> _warnings;
+    };
+
+    // the spin kernel variance check; a CPU is flagged if its coefficient of variation is above the absolute limit
+    // and more than kRelativeLimit times the median over all CPUs, and the machine as a whole if the median is above
+    // the absolute limit
+    struct spin_noise_limits
+    {
+        static constexpr double kAbsoluteLimit = 0.01;
+        static constexpr double kRelativeLimit = 3.0;
+        static constexpr size_t kSamples = 200;
+        static constexpr size_t kKernelIterations = 20000;
+    };
+
+    namespace detail
+    {
+        // first line of a (sysfs or procfs) file, without trailing whitespace; empty if it can't be read
+        inline std::string read_first_line(const std::string& path)
+        {
+            std::ifstream file{ path };
+            std::string line;
+            if (!file || !std::getline(file, line))
+                return {};
+            line.erase(line.find_last_not_of(" \t\r\n") + 1);
+            return line;
+        }
+
+        // the value of name=value on the kernel command line, or empty
+        inline std::string kernel_parameter(const std::string& cmdline, const std::string& name)
+        {
+            std::istringstream words{ cmdline };
+            std::string word;
+            while (words >> word)
+            {
+                if (word.compare(0, name.size() + 1, name + "=") == 0)
+                    return word.substr(name.size() + 1);
+            }
+            return {};
+        }
+
+        // a kernel cpu list, e.g. "2-5,8", skipping any flags like isolcpus' "domain,managed_irq,"
+        inline std::vector<unsigned> parse_cpu_list(const std::string& list)
+        {
+            std::vector<unsigned> cpus;
+            std::istringstream ranges{ list };
+            std::string range;
+            while (std::getline(ranges, range, ','))
+            {
+                if (range.empty() || range[0] < '0' || range[0] > '9')
+                    continue;
+                char* end = nullptr;
+                const auto first = unsigned(std::strtoul(range.c_str(), &end, 10));
+                const auto last = (*end == '-') ? unsigned(std::strtoul(end + 1, nullptr, 10)) : first;
+                for (auto cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            }
+            return cpus;
+        }
+
+        // the selected option of a sysfs multiple choice file, e.g. "always [madvise] never" -> "madvise"
+        inline std::string selected_option(const std::string& choices)
+        {
+            const auto open = choices.find('[');
+            const auto close = choices.find(']', open);
+            if (open == std::string::npos || close == std::string::npos)
+                return choices;
+            return choices.substr(open + 1, close - open - 1);
+        }
+
+        // a fixed amount of dependent arithmetic; the same work every time, so any spread in its run time is
+        // something else getting in the way (interrupts, other tasks, SMT siblings, frequency changes)
+        inline uint64_t time_spin_kernel(size_t iterations)
+        {
+            volatile uint64_t seed = 1;
+            uint64_t x = seed;
+            const auto start = perf::rdtsc();
+            for (size_t n = 0; n < iterations; ++n)
+                x = x * 6364136223846793005ull + 1442695040888963407ull;
+            const auto ticks = perf::rdtsc() - start;
+            seed = x;
+            return ticks;
+        }
+
+        // coefficient of variation of the spin kernel on the given logical processor, or a negative value if we
+        // couldn't run there
+        inline double spin_kernel_cv(unsigned os_index)
+        {
+            if (!pin_this_thread(os_index))
+                return -1.0;
+            // warm up; get the core out of any idle state and up to speed
+            for (size_t n = 0; n < spin_noise_limits::kSamples / 10; ++n)
+                time_spin_kernel(spin_noise_limits::kKernelIterations);
+            std::vector<double> samples(spin_noise_limits::kSamples);
+            for (auto& sample : samples)
+                sample = double(time_spin_kernel(spin_noise_limits::kKernelIterations));
+            double mean = 0.0;
+            for (auto sample : samples)
+                mean += sample;
+            mean /= double(samples.size());
+            double variance = 0.0;
+            for (auto sample : samples)
+                variance += (sample - mean) * (sample - mean);
+            variance /= double(samples.size() - 1);
+            return mean > 0.0 ? std::sqrt(variance) / mean : -1.0;
+        }
+
+        inline std::string join(const std::vector<unsigned>& values)
+        {
+            std::string joined;
+            for (auto value : values)
+                joined += (joined.empty() ? "" : ",") + std::to_string(value);
+            return joined;
+        }
+    }
+
+    // gather the report; takes a few milliseconds per logical processor for the spin kernel check
+    inline preflight_report preflight()
+    {
+        preflight_report report;
+        auto property = [&report](std::string name, std::string value) {
+            report._properties.emplace_back(std::move(name), std::move(value));
+        };
+        const auto& procs = topology();
+
+#if defined(__linux__)
+        const std::string cpu_root = "/sys/devices/system/cpu/";
+
+        // frequency scaling governors; "performance" everywhere is what we want
+        std::vector<std::pair<std::string, std::vector<unsigned>>> governors;
+        for (const auto& lp : procs)
+        {
+            auto governor = detail::read_first_line(cpu_root + "cpu" + std::to_string(lp._os_index) + "/cpufreq/scaling_governor");
+            if (governor.empty())
+                continue;
+            auto it = std::find_if(governors.begin(), governors.end(), [&governor](const auto& g) { return g.first == governor; });
+            if (it == governors.end())
+                it = governors.emplace(governors.end(), governor, std::vector<unsigned>{});
+            it->second.push_back(lp._os_index);
+        }
+        if (!governors.empty())
+        {
+            std::string value;
+            for (const auto& governor : governors)
+            {
+                value += (value.empty() ? "" : " ") + governor.first;
+                if (governors.size() > 1)
+                    value += "(" + detail::join(governor.second) + ")";
+                if (governor.first != "performance")
+                    report._warnings.emplace_back("scaling governor is \"" + governor.first + "\" on cpu " + detail::join(governor.second) + "; results will depend on how quickly the clock ramps up");
+            }
+            property("scaling_governor", value);
+        }
+
+        // turbo; intel_pstate has its own knob, inverted, everything else uses cpufreq/boost
+        const auto pstate_status = detail::read_first_line(cpu_root + "intel_pstate/status");
+        if (!pstate_status.empty())
+        {
+            property("intel_pstate", pstate_status);
+            const auto no_turbo = detail::read_first_line(cpu_root + "intel_pstate/no_turbo");
+            if (!no_turbo.empty())
+            {
+                property("turbo", no_turbo == "0" ? "on" : "off");
+                if (no_turbo == "0")
+                    report._warnings.emplace_back("turbo is on; clock speed will depend on temperature and on how many cores are busy");
+            }
+        }
+        const auto boost = detail::read_first_line(cpu_root + "cpufreq/boost");
+        if (!boost.empty())
+        {
+            property("boost", boost == "1" ? "on" : "off");
+            if (boost == "1")
+                report._warnings.emplace_back("frequency boost is on; clock speed will depend on temperature and on how many cores are busy");
+        }
+
+        // SMT
+        const auto smt_control = detail::read_first_line(cpu_root + "smt/control");
+        if (!smt_control.empty())
+        {
+            property("smt_control", smt_control);
+            if (smt_control == "on" && detail::read_first_line(cpu_root + "smt/active") == "1")
+                report._warnings.emplace_back("SMT is active; anything running on a sibling hw thread competes with the benchmark for its core");
+        }
+
+        // CPU isolation
+        const auto cmdline = detail::read_first_line("/proc/cmdline");
+        const auto isolcpus = detail::kernel_parameter(cmdline, "isolcpus");
+        const auto nohz_full = detail::kernel_parameter(cmdline, "nohz_full");
+        property("isolcpus", isolcpus);
+        property("nohz_full", nohz_full);
+        if (!isolcpus.empty())
+        {
+            const auto isolated = detail::parse_cpu_list(isolcpus);
+            std::vector<unsigned> shared;
+            for (const auto& lp : procs)
+            {
+                if (std::find(isolated.begin(), isolated.end(), lp._os_index) == isolated.end())
+                    shared.push_back(lp._os_index);
+            }
+            if (!shared.empty())
+                report._warnings.emplace_back("isolcpus is set but we may also run on cpu " + detail::join(shared) + "; pin the run to the isolated CPUs with taskset");
+        }
+
+        // background load
+        const auto loadavg = detail::read_first_line("/proc/loadavg");
+        if (!loadavg.empty())
+        {
+            std::istringstream fields{ loadavg };
+            std::string one, five, fifteen;
+            fields >> one >> five >> fifteen;
+            property("loadavg", one + " " + five + " " + fifteen);
+            if (std::strtod(one.c_str(), nullptr) > 1.0)
+                report._warnings.emplace_back("1 minute load average is " + one + "; something else is keeping the machine busy");
+        }
+
+        // transparent hugepages; "always" means khugepaged and compaction can kick in in the middle of a run
+        const auto thp = detail::selected_option(detail::read_first_line("/sys/kernel/mm/transparent_hugepage/enabled"));
+        if (!thp.empty())
+        {
+            property("transparent_hugepage", thp);
+            if (thp == "always")
+                report._warnings.emplace_back("transparent hugepages are \"always\"; page faults and compaction may add noise to memory heavy benchmarks");
+        }
+#endif
+
+        // direct measurement; run the spin kernel on every CPU we're allowed on and flag the ones that are noisier
+        // than the rest
+#if defined(_WIN32)
+        DWORD_PTR process_mask = 0, system_mask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+        const auto previous = SetThreadAffinityMask(GetCurrentThread(), process_mask);
+#elif defined(__linux__)
+        cpu_set_t previous;
+        CPU_ZERO(&previous);
+        pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous);
+#endif
+        std::vector<std::pair<unsigned, double>> cvs;
+        for (const auto& lp : procs)
+        {
+            const auto cv = detail::spin_kernel_cv(lp._os_index);
+            if (cv >= 0.0)
+                cvs.emplace_back(lp._os_index, cv);
+        }
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), previous);
+#elif defined(__linux__)
+        pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+#endif
+
+        if (!cvs.empty())
+        {
+            std::vector<double> sorted;
+            for (const auto& cv : cvs)
+                sorted.push_back(cv.second);
+            std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+            const auto median_cv = sorted[sorted.size() / 2];
+            const auto limit = std::max(spin_noise_limits::kAbsoluteLimit, spin_noise_limits::kRelativeLimit * median_cv);
+
+            std::ostringstream percentages;
+            percentages.precision(3);
+            std::vector<unsigned> noisy;
+            for (const auto& cv : cvs)
+            {
+                percentages << (percentages.tellp() > 0 ? "," : "") << cv.first << ":" << cv.second * 100.0;
+                if (cv.second > limit)
+                    noisy.push_back(cv.first);
+            }
+            property("spin_cv_percent", percentages.str());
+            property("noisy_cpus", detail::join(noisy));
+            if (!noisy.empty())
+                report._warnings.emplace_back("cpu " + detail::join(noisy) + " showed abnormal run time variance for a fixed spin kernel; something is interrupting them");
+            if (median_cv > spin_noise_limits::kAbsoluteLimit)
+                report._warnings.emplace_back("a fixed spin kernel varies by " + std::to_string(int(median_cv * 100.0 + 0.5)) + "% (coefficient of variation) on a typical cpu; the whole machine is noisy");
+        }
+
+        return report;
+    }
+}
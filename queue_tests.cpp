@@ -0,0 +1,173 @@
+#include "thread_tests.h"
+#include "perfutils.h"
+#include "worker_pool.h"
+#include "queues.h"
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+
+using steady_clock = std::chrono::steady_clock;
+
+namespace perf::threads
+{
+	namespace
+	{
+		constexpr size_t kQueueCapacity = 1024;
+		constexpr size_t kThroughputMessages = 1u << 22;
+		constexpr size_t kLatencyMessages = 1u << 16;
+		// gap between messages in the latency runs so that we measure handover and not time spent queued behind other messages
+		constexpr auto kLatencyGap = std::chrono::microseconds(2);
+
+		struct message
+		{
+			// producer's rdtsc at push; NOTE: assumes an invariant TSC that's synchronised across packages
+			uint64_t _tsc = 0;
+			uint64_t _seq = 0;
+		};
+
+		// spin, but give the core away now and again in case both ends ended up on the same logical processor
+		struct backoff
+		{
+			void operator()()
+			{
+				if (++_spins & 63)
+					_mm_pause();
+				else
+					std::this_thread::yield();
+			}
+			unsigned _spins = 0;
+		};
+
+		struct run_result
+		{
+			double _msgs_per_s = 0.0;
+			Stats _latency_ns;
+		};
+
+		// workers [0, producers) push, the rest pop, until messages have gone through the queue
+		template<typename Queue>
+		void run_messages(worker_pool& pool, size_t producers, size_t messages, uint64_t gap_ticks, run_result& result)
+		{
+			Queue queue{ kQueueCapacity };
+			const auto consumers = pool.size() - producers;
+			std::atomic<size_t> consumed{ 0 };
+			// room for twice a fair share each, so recording never reallocates in the loop; a consumer that gets more
+			// than that stops recording, the latencies are a sample anyway
+			const auto latency_capacity = std::min(messages, 2 * (messages / consumers) + 1024);
+			std::vector<std::vector<uint64_t>> latencies(consumers);
+			for (auto& l : latencies)
+				l.reserve(latency_capacity);
+			std::vector<steady_clock::time_point> start(pool.size()), end(pool.size());
+
+			pool.run([&](size_t worker) {
+				start[worker] = steady_clock::now();
+				if (worker < producers)
+				{
+					const auto first = messages * worker / producers;
+					const auto last = messages * (worker + 1) / producers;
+					for (auto seq = first; seq < last; ++seq)
+					{
+						message msg;
+						msg._seq = seq;
+						msg._tsc = rdtsc();
+						backoff wait;
+						while (!queue.try_push(msg))
+							wait();
+						if (gap_ticks)
+						{
+							while (rdtsc() - msg._tsc < gap_ticks)
+								_mm_pause();
+						}
+					}
+				}
+				else
+				{
+					auto& mine = latencies[worker - producers];
+					message msg;
+					backoff wait;
+					while (consumed.load(std::memory_order_relaxed) < messages)
+					{
+						if (queue.try_pop(msg))
+						{
+							if (mine.size() < latency_capacity)
+								mine.emplace_back(rdtsc() - msg._tsc);
+							consumed.fetch_add(1, std::memory_order_relaxed);
+						}
+						else
+							wait();
+					}
+				}
+				end[worker] = steady_clock::now();
+			});
+
+			const auto elapsed = *std::max_element(end.begin(), end.end()) - *std::min_element(start.begin(), start.end());
+			result._msgs_per_s = double(messages) / std::chrono::duration<double>(elapsed).count();
+			const auto ticks_per_ns = tsc_ticks_per_ns();
+			for (const auto& l : latencies)
+				for (auto ticks : l)
+					result._latency_ns.push(double(ticks) / ticks_per_ns);
+		}
+
+		// throughput from a saturating run, latency from a paced one
+		template<typename Queue>
+		void run_queue(const char* name, const char* where, worker_pool& pool, size_t producers)
+		{
+			run_result saturated, paced;
+			run_messages<Queue>(pool, producers, kThroughputMessages, 0, saturated);
+			const auto gap_ticks = uint64_t(double(std::chrono::duration_cast<std::chrono::nanoseconds>(kLatencyGap).count()) * tsc_ticks_per_ns());
+			run_messages<Queue>(pool, producers, kLatencyMessages, gap_ticks, paced);
+
+			std::cout << "\t" << std::setw(8) << name
+				<< std::setw(15) << where
+				<< std::setw(4) << producers << "P" << std::setw(3) << pool.size() - producers << "C"
+				<< std::setw(12) << std::setprecision(3) << saturated._msgs_per_s / 1e6
+				<< std::setw(10) << std::setprecision(1) << paced._latency_ns.percentile(0.5)
+				<< std::setw(10) << paced._latency_ns.percentile(0.99)
+				<< std::setw(11) << paced._latency_ns.percentile(0.999)
+				<< std::setw(12) << saturated._latency_ns.percentile(0.5)
+				<< "\n";
+		}
+
+		void print_header()
+		{
+			std::cout << "\t" << std::setw(8) << "queue" << std::setw(15) << "placement" << std::setw(9) << "threads"
+				<< std::setw(12) << "Mmsg/s" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(11) << "p99.9 ns"
+				<< std::setw(12) << "sat p50 ns" << "\n" << std::fixed;
+		}
+	}
+
+	void test_queues()
+	{
+		std::cout << "queue shoot-out, capacity " << kQueueCapacity << ", " << kThroughputMessages << " messages for throughput, "
+			<< kLatencyMessages << " paced messages (" << std::chrono::duration_cast<std::chrono::nanoseconds>(kLatencyGap).count()
+			<< "ns apart) for one-way latency\n";
+		std::cout << "\tsat p50 is the median latency in the saturated run, i.e. including time spent queued\n";
+
+		std::cout << "\none producer, one consumer\n";
+		print_header();
+		for (auto where : { pair_placement::kSmtSiblings, pair_placement::kSameL3, pair_placement::kCrossPackage, pair_placement::kNone })
+		{
+			int producer_cpu, consumer_cpu;
+			if (!pair_cpus(where, producer_cpu, consumer_cpu))
+			{
+				std::cout << "\t" << pair_placement_name(where) << ": no such pair of logical processors on this system, skipping\n";
+				continue;
+			}
+			worker_pool pool{ std::vector<int>{ producer_cpu, consumer_cpu } };
+			run_queue<queues::spsc_ring<message>>("spsc", pair_placement_name(where), pool, 1);
+			run_queue<queues::mpmc_queue<message>>("mpmc", pair_placement_name(where), pool, 1);
+			run_queue<queues::locked_queue<message>>("mutex", pair_placement_name(where), pool, 1);
+		}
+
+		std::cout << "\nmany producers, many consumers, one thread per physical core first\n";
+		print_header();
+		for (auto threads : thread_count_sweep())
+		{
+			if (threads < 4)
+				continue;
+			worker_pool pool{ threads, placement::kScatter };
+			run_queue<queues::mpmc_queue<message>>("mpmc", placement_name(placement::kScatter), pool, threads / 2);
+			run_queue<queues::locked_queue<message>>("mutex", placement_name(placement::kScatter), pool, threads / 2);
+		}
+	}
+}
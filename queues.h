@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Bounded queues for passing work between threads. All of them share the same non-blocking interface:
+//   bool try_push(const T&)  - false if the queue is full
+//   bool try_pop(T&)         - false if the queue is empty
+// Capacities must be powers of two.
+namespace perf::queues
+{
+    constexpr size_t kCacheLineSize = 64;
+
+    // single producer, single consumer ring.
+    // Each side keeps a private copy of the other side's index and only re-reads the shared one when the copy says
+    // the ring is full (producer) or empty (consumer), so in steady state the two cores don't ping-pong index lines.
+    template<typename T>
+    class spsc_ring
+    {
+    public:
+        explicit spsc_ring(size_t capacity)
+            : _mask(capacity - 1)
+            , _slots(capacity)
+        {
+            assert(capacity && !(capacity & (capacity - 1)));
+        }
+
+        bool try_push(const T& value)
+        {
+            const auto tail = _producer._tail.load(std::memory_order_relaxed);
+            if (tail - _producer._cached_head > _mask)
+            {
+                _producer._cached_head = _consumer._head.load(std::memory_order_acquire);
+                if (tail - _producer._cached_head > _mask)
+                    return false;
+            }
+            _slots[tail & _mask] = value;
+            _producer._tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T& value)
+        {
+            const auto head = _consumer._head.load(std::memory_order_relaxed);
+            if (head == _consumer._cached_tail)
+            {
+                _consumer._cached_tail = _producer._tail.load(std::memory_order_acquire);
+                if (head == _consumer._cached_tail)
+                    return false;
+            }
+            value = _slots[head & _mask];
+            _consumer._head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        struct alignas(kCacheLineSize) producer_side
+        {
+            std::atomic<size_t> _tail{ 0 };
+            size_t _cached_head = 0;
+        };
+        struct alignas(kCacheLineSize) consumer_side
+        {
+            std::atomic<size_t> _head{ 0 };
+            size_t _cached_tail = 0;
+        };
+
+        producer_side _producer;
+        consumer_side _consumer;
+        const size_t _mask;
+        std::vector<T> _slots;
+    };
+
+    // Dmitry Vyukov's bounded MPMC queue; every cell carries a sequence number which tells producers and consumers
+    // whether it's theirs to use, so the only shared RMWs are the CASes on the enqueue/dequeue positions.
+    template<typename T>
+    class mpmc_queue
+    {
+    public:
+        explicit mpmc_queue(size_t capacity)
+            : _mask(capacity - 1)
+            , _cells(capacity)
+        {
+            assert(capacity >= 2 && !(capacity & (capacity - 1)));
+            for (size_t n = 0; n < capacity; ++n)
+                _cells[n]._sequence.store(n, std::memory_order_relaxed);
+        }
+
+        bool try_push(const T& value)
+        {
+            auto pos = _enqueue_pos._value.load(std::memory_order_relaxed);
+            cell* c;
+            for (;;)
+            {
+                c = &_cells[pos & _mask];
+                const auto seq = c->_sequence.load(std::memory_order_acquire);
+                const auto diff = intptr_t(seq) - intptr_t(pos);
+                if (diff == 0)
+                {
+                    if (_enqueue_pos._value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = _enqueue_pos._value.load(std::memory_order_relaxed);
+            }
+            c->_data = value;
+            c->_sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T& value)
+        {
+            auto pos = _dequeue_pos._value.load(std::memory_order_relaxed);
+            cell* c;
+            for (;;)
+            {
+                c = &_cells[pos & _mask];
+                const auto seq = c->_sequence.load(std::memory_order_acquire);
+                const auto diff = intptr_t(seq) - intptr_t(pos + 1);
+                if (diff == 0)
+                {
+                    if (_dequeue_pos._value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = _dequeue_pos._value.load(std::memory_order_relaxed);
+            }
+            value = c->_data;
+            c->_sequence.store(pos + _mask + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        struct cell
+        {
+            std::atomic<size_t> _sequence{ 0 };
+            T _data{};
+        };
+        struct alignas(kCacheLineSize) position
+        {
+            std::atomic<size_t> _value{ 0 };
+        };
+
+        const size_t _mask;
+        std::vector<cell> _cells;
+        position _enqueue_pos;
+        position _dequeue_pos;
+    };
+
+    // the baseline; std::deque behind a std::mutex, bounded to the same capacity as the others
+    template<typename T>
+    class locked_queue
+    {
+    public:
+        explicit locked_queue(size_t capacity)
+            : _capacity(capacity)
+        {
+        }
+
+        bool try_push(const T& value)
+        {
+            std::lock_guard lock{ _mtx };
+            if (_queue.size() == _capacity)
+                return false;
+            _queue.push_back(value);
+            return true;
+        }
+
+        bool try_pop(T& value)
+        {
+            std::lock_guard lock{ _mtx };
+            if (_queue.empty())
+                return false;
+            value = _queue.front();
+            _queue.pop_front();
+            return true;
+        }
+
+    private:
+        const size_t _capacity;
+        std::mutex _mtx;
+        std::deque<T> _queue;
+    };
+}
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "worker_pool.h"
+#include "queues.h"
+
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+// A small fork-join task scheduler on top of threads::worker_pool, with pluggable task distribution so that
+// designs can be compared like for like.
+// usage:
+// scheduler<work_stealing_policy> s{ pool };
+// s.run([&]() {
+//     task_group g;
+//     s.spawn(g, [&]() { ... });
+//     ...
+//     s.wait(g);
+// });
+namespace perf::sched
+{
+    constexpr size_t kCacheLineSize = 64;
+
+    // Chase & Lev's dynamic circular work-stealing deque, with the C11 memory orders from
+    // Le, Pop, Cohen & Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models" (2013).
+    // The owner pushes and pops at the bottom, thieves take from the top.
+    template<typename T>
+    class chase_lev_deque
+    {
+    public:
+        explicit chase_lev_deque(size_t capacity = 1024)
+        {
+            _retired.emplace_back(new array(capacity));
+            _array.store(_retired.back().get(), std::memory_order_relaxed);
+        }
+
+        chase_lev_deque(const chase_lev_deque&) = delete;
+        chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+        // owner only
+        void push(T value)
+        {
+            const auto b = _bottom.load(std::memory_order_relaxed);
+            const auto t = _top.load(std::memory_order_acquire);
+            auto a = _array.load(std::memory_order_relaxed);
+            if (b - t > int64_t(a->_size) - 1)
+                a = grow(a, b, t);
+            a->put(b, value);
+            std::atomic_thread_fence(std::memory_order_release);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        // owner only
+        bool pop(T& value)
+        {
+            const auto b = _bottom.load(std::memory_order_relaxed) - 1;
+            const auto a = _array.load(std::memory_order_relaxed);
+            _bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = _top.load(std::memory_order_relaxed);
+            if (t > b)
+            {
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            value = a->get(b);
+            if (t == b)
+            {
+                // last element; race the thieves for it
+                const auto won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // any thread; false if empty or if we lost a race with the owner or another thief
+        bool steal(T& value)
+        {
+            auto t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto b = _bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return false;
+            const auto a = _array.load(std::memory_order_acquire);
+            value = a->get(t);
+            return _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+    private:
+        struct array
+        {
+            explicit array(size_t size)
+                : _size(size)
+                , _slots(new std::atomic<T>[size])
+            {
+            }
+
+            T get(int64_t i) const
+            {
+                return _slots[size_t(i) & (_size - 1)].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t i, T value)
+            {
+                _slots[size_t(i) & (_size - 1)].store(value, std::memory_order_relaxed);
+            }
+
+            const size_t _size;
+            std::unique_ptr<std::atomic<T>[]> _slots;
+        };
+
+        array* grow(array* a, int64_t b, int64_t t)
+        {
+            auto bigger = new array(a->_size * 2);
+            for (auto i = t; i < b; ++i)
+                bigger->put(i, a->get(i));
+            // thieves may still be reading the old array so it stays alive until we're destroyed
+            _retired.emplace_back(bigger);
+            _array.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+
+        alignas(kCacheLineSize) std::atomic<int64_t> _top{ 0 };
+        alignas(kCacheLineSize) std::atomic<int64_t> _bottom{ 0 };
+        std::atomic<array*> _array{ nullptr };
+        std::vector<std::unique_ptr<array>> _retired;
+    };
+
+    class task_group;
+
+    struct task
+    {
+        virtual ~task() = default;
+        virtual void execute() = 0;
+        task_group* _group = nullptr;
+    };
+
+    // completion counter for a set of spawned tasks
+    class task_group
+    {
+    public:
+        bool done() const
+        {
+            return _pending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        template<typename Policy> friend class scheduler;
+        std::atomic<size_t> _pending{ 0 };
+    };
+
+    // one deque per worker; spawn pushes to your own, idle workers steal from a random victim
+    class work_stealing_policy
+    {
+    public:
+        explicit work_stealing_policy(size_t workers)
+            : _deques(workers)
+        {
+        }
+
+        static const char* name() { return "work stealing"; }
+
+        bool push(size_t worker, task* t)
+        {
+            _deques[worker].push(t);
+            return true;
+        }
+
+        task* pop(size_t worker)
+        {
+            task* t = nullptr;
+            return _deques[worker].pop(t) ? t : nullptr;
+        }
+
+        task* steal(size_t worker, uint64_t& rng)
+        {
+            if (_deques.size() < 2)
+                return nullptr;
+            // xorshift
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            auto victim = size_t(rng % (_deques.size() - 1));
+            if (victim >= worker)
+                ++victim;
+            task* t = nullptr;
+            return _deques[victim].steal(t) ? t : nullptr;
+        }
+
+    private:
+        std::vector<chase_lev_deque<task*>> _deques;
+    };
+
+    // the classic thread pool; everybody pushes to and pops from one mutex protected queue.
+    // If the queue is full spawn runs the task inline.
+    class shared_queue_policy
+    {
+    public:
+        explicit shared_queue_policy(size_t)
+        {
+        }
+
+        static const char* name() { return "shared queue"; }
+
+        bool push(size_t, task* t)
+        {
+            return _queue.try_push(t);
+        }
+
+        task* pop(size_t)
+        {
+            task* t = nullptr;
+            return _queue.try_pop(t) ? t : nullptr;
+        }
+
+        task* steal(size_t, uint64_t&)
+        {
+            return nullptr;
+        }
+
+    private:
+        queues::locked_queue<task*> _queue{ 1u << 16 };
+    };
+
+    template<typename Policy>
+    class scheduler
+    {
+    public:
+        struct alignas(kCacheLineSize) worker_stats
+        {
+            uint64_t _executed = 0;
+            uint64_t _steals = 0;
+            uint64_t _steal_attempts = 0;
+        };
+
+        explicit scheduler(threads::worker_pool& pool)
+            : _pool(pool)
+            , _policy(pool.size())
+            , _stats(pool.size())
+        {
+        }
+
+        static const char* name() { return Policy::name(); }
+
+        // run root on worker 0 and let the rest of the pool help until it returns
+        template<typename F>
+        void run(F&& root)
+        {
+            _done.store(false);
+            _pool.run([this, &root](size_t worker) {
+                _worker = worker;
+                _rng = 0x9e3779b97f4a7c15ull * (worker + 1);
+                if (worker == 0)
+                {
+                    root();
+                    _done.store(true, std::memory_order_release);
+                    return;
+                }
+                unsigned idle = 0;
+                while (!_done.load(std::memory_order_acquire))
+                {
+                    if (auto t = find_work())
+                    {
+                        execute(t);
+                        idle = 0;
+                    }
+                    else if (++idle & 63)
+                        _mm_pause();
+                    else
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        // must be called from inside run()
+        template<typename F>
+        void spawn(task_group& group, F&& fn)
+        {
+            auto t = new fn_task<std::decay_t<F>>(std::forward<F>(fn));
+            t->_group = &group;
+            group._pending.fetch_add(1, std::memory_order_relaxed);
+            if (!_policy.push(_worker, t))
+                execute(t);
+        }
+
+        // help out until everything spawned into the group has finished
+        void wait(task_group& group)
+        {
+            while (!group.done())
+            {
+                if (auto t = find_work())
+                    execute(t);
+                else
+                    _mm_pause();
+            }
+        }
+
+        worker_stats totals() const
+        {
+            worker_stats total;
+            for (const auto& s : _stats)
+            {
+                total._executed += s._executed;
+                total._steals += s._steals;
+                total._steal_attempts += s._steal_attempts;
+            }
+            return total;
+        }
+
+        void reset_stats()
+        {
+            for (auto& s : _stats)
+                s = worker_stats{};
+        }
+
+    private:
+        template<typename F>
+        struct fn_task : task
+        {
+            template<typename G>
+            explicit fn_task(G&& fn)
+                : _fn(std::forward<G>(fn))
+            {
+            }
+
+            void execute() override
+            {
+                _fn();
+            }
+
+            F _fn;
+        };
+
+        task* find_work()
+        {
+            if (auto t = _policy.pop(_worker))
+                return t;
+            auto& stats = _stats[_worker];
+            ++stats._steal_attempts;
+            auto t = _policy.steal(_worker, _rng);
+            if (t)
+                ++stats._steals;
+            return t;
+        }
+
+        void execute(task* t)
+        {
+            auto group = t->_group;
+            t->execute();
+            delete t;
+            ++_stats[_worker]._executed;
+            group->_pending.fetch_sub(1, std::memory_order_release);
+        }
+
+        threads::worker_pool& _pool;
+        Policy _policy;
+        std::vector<worker_stats> _stats;
+        std::atomic<bool> _done{ false };
+
+        static inline thread_local size_t _worker = 0;
+        static inline thread_local uint64_t _rng = 0;
+    };
+}
@@ -0,0 +1,276 @@
+#include "thread_tests.h"
+#include "perfutils.h"
+#include "scheduler.h"
+#include <future>
+#include <random>
+#include <iostream>
+#include <iomanip>
+
+using steady_clock = std::chrono::steady_clock;
+
+namespace perf::threads
+{
+	namespace
+	{
+		constexpr unsigned kFibN = 36;
+		// below this fib runs serially; keeps std::async down to a few thousand threads
+		constexpr unsigned kFibCutoff = 20;
+
+		constexpr size_t kForItems = 1u << 16;
+		constexpr size_t kForGrain = 64;
+
+		constexpr size_t kTreeNodes = 1u << 20;
+		// subtrees are reduced serially below this depth
+		constexpr unsigned kTreeSpawnDepth = 14;
+
+		constexpr unsigned kRepeats = 3;
+
+		// -------------------------------------------------------------------------------------------------
+		// workloads, each in serial, std::async and scheduler flavours
+
+		uint64_t fib_serial(unsigned n)
+		{
+			return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+		}
+
+		uint64_t fib_async(unsigned n)
+		{
+			if (n < kFibCutoff)
+				return fib_serial(n);
+			auto a = std::async(std::launch::async, fib_async, n - 1);
+			const auto b = fib_async(n - 2);
+			return a.get() + b;
+		}
+
+		template<typename Scheduler>
+		uint64_t fib_tasks(Scheduler& s, unsigned n)
+		{
+			if (n < kFibCutoff)
+				return fib_serial(n);
+			uint64_t a = 0;
+			sched::task_group g;
+			s.spawn(g, [&s, &a, n]() { a = fib_tasks(s, n - 1); });
+			const auto b = fib_tasks(s, n - 2);
+			s.wait(g);
+			return a + b;
+		}
+
+		// the cost of an item varies wildly; most are cheap, one in 32 is 64x more expensive
+		uint64_t for_item(size_t i)
+		{
+			const auto rounds = ((i * 0x9e3779b97f4a7c15ull) >> 59) == 0 ? 4096u : 64u;
+			uint64_t x = i;
+			for (auto r = 0u; r < rounds; ++r)
+				x = x * 6364136223846793005ull + 1442695040888963407ull;
+			return x >> 32;
+		}
+
+		uint64_t for_serial(size_t lo, size_t hi)
+		{
+			uint64_t sum = 0;
+			for (auto i = lo; i < hi; ++i)
+				sum += for_item(i);
+			return sum;
+		}
+
+		uint64_t for_async(size_t lo, size_t hi)
+		{
+			// std::async can't sensibly take one task per grain, so split once per hardware thread
+			const auto chunks = size_t(std::max(1u, std::thread::hardware_concurrency()));
+			std::vector<std::future<uint64_t>> futures;
+			for (size_t c = 0; c < chunks; ++c)
+				futures.emplace_back(std::async(std::launch::async, for_serial, lo + (hi - lo) * c / chunks, lo + (hi - lo) * (c + 1) / chunks));
+			uint64_t sum = 0;
+			for (auto& f : futures)
+				sum += f.get();
+			return sum;
+		}
+
+		// recursive binary splitting down to the grain size
+		template<typename Scheduler>
+		uint64_t for_tasks(Scheduler& s, size_t lo, size_t hi)
+		{
+			if (hi - lo <= kForGrain)
+				return for_serial(lo, hi);
+			const auto mid = lo + (hi - lo) / 2;
+			uint64_t left = 0;
+			sched::task_group g;
+			s.spawn(g, [&s, &left, lo, mid]() { left = for_tasks(s, lo, mid); });
+			const auto right = for_tasks(s, mid, hi);
+			s.wait(g);
+			return left + right;
+		}
+
+		// randomly shaped binary tree (a BST of random keys), so subtree sizes are uneven
+		struct tree_node
+		{
+			uint64_t _value = 0;
+			tree_node* _left = nullptr;
+			tree_node* _right = nullptr;
+		};
+
+		struct tree
+		{
+			tree()
+				: _nodes(kTreeNodes)
+			{
+				std::mt19937_64 rng{ 42 };
+				for (auto& n : _nodes)
+					n._value = rng() & 0xffff;
+				_root = &_nodes[0];
+				for (size_t i = 1; i < _nodes.size(); ++i)
+				{
+					auto key = rng();
+					_nodes[i]._value = key & 0xffff;
+					auto at = _root;
+					for (;;)
+					{
+						auto& child = (key & 1) ? at->_left : at->_right;
+						if (!child)
+						{
+							child = &_nodes[i];
+							break;
+						}
+						at = child;
+						key >>= 1;
+						if (!key)
+							key = rng();
+					}
+				}
+			}
+
+			std::vector<tree_node> _nodes;
+			tree_node* _root = nullptr;
+		};
+
+		uint64_t reduce_serial(const tree_node* n)
+		{
+			if (!n)
+				return 0;
+			// a little work per node so it isn't purely a pointer chase
+			return for_item(n->_value) + reduce_serial(n->_left) + reduce_serial(n->_right);
+		}
+
+		uint64_t reduce_async(const tree_node* n, unsigned depth)
+		{
+			if (!n)
+				return 0;
+			// limit std::async to the top few levels, it'd be thousands of threads otherwise
+			if (depth >= 6)
+				return reduce_serial(n);
+			auto left = std::async(std::launch::async, reduce_async, n->_left, depth + 1);
+			const auto right = reduce_async(n->_right, depth + 1);
+			return for_item(n->_value) + left.get() + right;
+		}
+
+		template<typename Scheduler>
+		uint64_t reduce_tasks(Scheduler& s, const tree_node* n, unsigned depth)
+		{
+			if (!n)
+				return 0;
+			if (depth >= kTreeSpawnDepth)
+				return reduce_serial(n);
+			uint64_t left = 0;
+			sched::task_group g;
+			s.spawn(g, [&s, &left, n, depth]() { left = reduce_tasks(s, n->_left, depth + 1); });
+			const auto right = reduce_tasks(s, n->_right, depth + 1);
+			s.wait(g);
+			return for_item(n->_value) + left + right;
+		}
+
+		// -------------------------------------------------------------------------------------------------
+
+		// best of kRepeats, in seconds
+		template<typename F>
+		double best_time(F&& f, uint64_t& result)
+		{
+			double best = std::numeric_limits<double>::max();
+			for (auto r = 0u; r < kRepeats; ++r)
+			{
+				const auto start = steady_clock::now();
+				result = f();
+				best = std::min(best, std::chrono::duration<double>(steady_clock::now() - start).count());
+			}
+			return best;
+		}
+
+		void print_row(const char* scheduler, const char* threads, double seconds, double serial_seconds, uint64_t result, uint64_t expected)
+		{
+			std::cout << "\t" << std::setw(14) << scheduler << std::setw(8) << threads
+				<< std::setw(11) << std::setprecision(2) << seconds * 1000.0
+				<< std::setw(9) << serial_seconds / seconds;
+			if (result != expected)
+				std::cout << "  WRONG RESULT (" << result << " != " << expected << ")";
+		}
+
+		template<typename Scheduler, typename Workload>
+		void run_scheduler(worker_pool& pool, Workload&& workload, double serial_seconds, uint64_t expected)
+		{
+			Scheduler s{ pool };
+			uint64_t result = 0;
+			const auto seconds = best_time([&]() {
+				s.reset_stats();
+				uint64_t r = 0;
+				s.run([&]() { r = workload(s); });
+				return r;
+			}, result);
+
+			const auto stats = s.totals();
+			print_row(Scheduler::name(), std::to_string(pool.size()).c_str(), seconds, serial_seconds, result, expected);
+			std::cout << std::setw(10) << stats._executed;
+			if (stats._steals)
+				std::cout << std::setw(10) << stats._steals
+					<< std::setw(12) << std::setprecision(0) << double(stats._steals) / seconds
+					<< std::setw(9) << std::setprecision(2) << 100.0 * double(stats._steals) / double(stats._executed);
+			std::cout << "\n";
+		}
+
+		template<typename Serial, typename Async, typename Tasks>
+		void run_workload(const std::string& name, Serial&& serial, Async&& async, Tasks&& tasks)
+		{
+			std::cout << "\n" << name << "\n";
+			std::cout << "\t" << std::setw(14) << "scheduler" << std::setw(8) << "threads" << std::setw(11) << "ms" << std::setw(9) << "speedup"
+				<< std::setw(10) << "tasks" << std::setw(10) << "steals" << std::setw(12) << "steals/s" << std::setw(9) << "stolen%"
+				<< "\n" << std::fixed;
+
+			uint64_t expected = 0;
+			const auto serial_seconds = best_time(serial, expected);
+			print_row("serial", "1", serial_seconds, serial_seconds, expected, expected);
+			std::cout << "\n";
+
+			uint64_t result = 0;
+			const auto async_seconds = best_time(async, result);
+			print_row("std::async", "os", async_seconds, serial_seconds, result, expected);
+			std::cout << "\n";
+
+			for (auto threads : thread_count_sweep())
+			{
+				worker_pool pool{ threads, placement::kScatter };
+				run_scheduler<sched::scheduler<sched::work_stealing_policy>>(pool, tasks, serial_seconds, expected);
+				run_scheduler<sched::scheduler<sched::shared_queue_policy>>(pool, tasks, serial_seconds, expected);
+			}
+		}
+	}
+
+	void test_scheduler()
+	{
+		std::cout << "fork-join schedulers, best of " << kRepeats << " runs, workers placed one per physical core first (scatter)\n";
+		std::cout << "\tspeedup is relative to the serial version, stolen% is the fraction of executed tasks that were stolen\n";
+
+		run_workload("recursive fib(" + std::to_string(kFibN) + "), serial below " + std::to_string(kFibCutoff),
+			[]() { return fib_serial(kFibN); },
+			[]() { return fib_async(kFibN); },
+			[](auto& s) { return fib_tasks(s, kFibN); });
+
+		run_workload("parallel for over " + std::to_string(kForItems) + " items of uneven cost, grain " + std::to_string(kForGrain),
+			[]() { return for_serial(0, kForItems); },
+			[]() { return for_async(0, kForItems); },
+			[](auto& s) { return for_tasks(s, 0, kForItems); });
+
+		const tree t;
+		run_workload("tree reduce over " + std::to_string(kTreeNodes) + " nodes, spawning down to depth " + std::to_string(kTreeSpawnDepth),
+			[&t]() { return reduce_serial(t._root); },
+			[&t]() { return reduce_async(t._root, 0); },
+			[&t](auto& s) { return reduce_tasks(s, t._root, 0); });
+	}
+}
@@ -0,0 +1,457 @@
+#include "simd_kernels.h"
+
+#include "cpu_features.h"
+
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+// MSVC lets you use any intrinsic anywhere, GCC and Clang need to be told per function.
+// The scalar versions are kept scalar so that the comparison means something; without this GCC happily
+// vectorises saxpy and sine with SSE2 and the "scalar" column is really a second SSE column.
+#if defined(__clang__)
+#define PERF_TARGET(isa) __attribute__((target(isa)))
+#define PERF_SCALAR
+#define PERF_SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+#define PERF_TARGET(isa) __attribute__((target(isa)))
+#define PERF_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#define PERF_SCALAR_LOOP
+#else
+#define PERF_TARGET(isa)
+#define PERF_SCALAR
+#define PERF_SCALAR_LOOP __pragma(loop(no_vector))
+#endif
+
+namespace perf::simd
+{
+    namespace
+    {
+        // sin(x) = (-1)^k sin(r), x = k*pi + r, |r| <= pi/2, then an odd Taylor polynomial to r^9
+        // (truncation error < 4e-6 at the ends of the interval, much less towards 0).
+        // pi is split in two (Cody & Waite) so that r stays accurate for larger |x|.
+        constexpr float kInvPi = 0.318309886183790671538f;
+        constexpr float kPiHi = 3.14159274101257324219f;
+        constexpr float kPiLo = -8.74227800037248300e-8f;
+        constexpr float kS3 = -1.0f / 6.0f;
+        constexpr float kS5 = 1.0f / 120.0f;
+        constexpr float kS7 = -1.0f / 5040.0f;
+        constexpr float kS9 = 1.0f / 362880.0f;
+
+        // -------------------------------------------------------------------------------------------------
+        // scalar; also used for the tails of the SIMD versions
+
+        inline float sin_one(float x)
+        {
+            // round half away from zero; ties don't matter, sin(+-pi/2) comes out the same either way
+            const auto k = float(int(x * kInvPi + (x < 0.0f ? -0.5f : 0.5f)));
+            const auto r = (x - k * kPiHi) - k * kPiLo;
+            const auto r2 = r * r;
+            const auto s = r + r * r2 * (kS3 + r2 * (kS5 + r2 * (kS7 + r2 * kS9)));
+            return (int(k) & 1) ? -s : s;
+        }
+
+        PERF_SCALAR float sum_scalar(const float* x, size_t n)
+        {
+            float sum = 0.0f;
+            PERF_SCALAR_LOOP
+            for (size_t i = 0; i < n; ++i)
+                sum += x[i];
+            return sum;
+        }
+
+        PERF_SCALAR float dot_scalar(const float* x, const float* y, size_t n)
+        {
+            float sum = 0.0f;
+            PERF_SCALAR_LOOP
+            for (size_t i = 0; i < n; ++i)
+                sum += x[i] * y[i];
+            return sum;
+        }
+
+        PERF_SCALAR void saxpy_scalar(float a, const float* x, float* y, size_t n)
+        {
+            PERF_SCALAR_LOOP
+            for (size_t i = 0; i < n; ++i)
+                y[i] = a * x[i] + y[i];
+        }
+
+        PERF_SCALAR void sin_scalar(const float* x, float* y, size_t n)
+        {
+            PERF_SCALAR_LOOP
+            for (size_t i = 0; i < n; ++i)
+                y[i] = sin_one(x[i]);
+        }
+
+        // carry is the running total of everything before x[0]
+        PERF_SCALAR void prefix_sum_scalar(const float* x, float* y, size_t n, float carry)
+        {
+            PERF_SCALAR_LOOP
+            for (size_t i = 0; i < n; ++i)
+            {
+                carry += x[i];
+                y[i] = carry;
+            }
+        }
+
+        void prefix_sum_scalar(const float* x, float* y, size_t n)
+        {
+            prefix_sum_scalar(x, y, n, 0.0f);
+        }
+
+        // -------------------------------------------------------------------------------------------------
+        // SSE4.2 (the rounding instruction is SSE4.1, nothing here needs 4.2 proper, but it's the usual baseline tier)
+
+        PERF_TARGET("sse4.2") inline float hsum(__m128 v)
+        {
+            v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+            return _mm_cvtss_f32(v);
+        }
+
+        // four independent accumulators to cover the latency of addps
+        PERF_TARGET("sse4.2") float sum_sse42(const float* x, size_t n)
+        {
+            auto a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                a0 = _mm_add_ps(a0, _mm_loadu_ps(x + i));
+                a1 = _mm_add_ps(a1, _mm_loadu_ps(x + i + 4));
+                a2 = _mm_add_ps(a2, _mm_loadu_ps(x + i + 8));
+                a3 = _mm_add_ps(a3, _mm_loadu_ps(x + i + 12));
+            }
+            for (; i + 4 <= n; i += 4)
+                a0 = _mm_add_ps(a0, _mm_loadu_ps(x + i));
+            return hsum(_mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3))) + sum_scalar(x + i, n - i);
+        }
+
+        PERF_TARGET("sse4.2") float dot_sse42(const float* x, const float* y, size_t n)
+        {
+            auto a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+                a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(y + i + 4)));
+                a2 = _mm_add_ps(a2, _mm_mul_ps(_mm_loadu_ps(x + i + 8), _mm_loadu_ps(y + i + 8)));
+                a3 = _mm_add_ps(a3, _mm_mul_ps(_mm_loadu_ps(x + i + 12), _mm_loadu_ps(y + i + 12)));
+            }
+            for (; i + 4 <= n; i += 4)
+                a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+            return hsum(_mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3))) + dot_scalar(x + i, y + i, n - i);
+        }
+
+        PERF_TARGET("sse4.2") void saxpy_sse42(float a, const float* x, float* y, size_t n)
+        {
+            const auto va = _mm_set1_ps(a);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(x + i)), _mm_loadu_ps(y + i)));
+            saxpy_scalar(a, x + i, y + i, n - i);
+        }
+
+        PERF_TARGET("sse4.2") void sin_sse42(const float* x, float* y, size_t n)
+        {
+            const auto inv_pi = _mm_set1_ps(kInvPi);
+            const auto pi_hi = _mm_set1_ps(kPiHi);
+            const auto pi_lo = _mm_set1_ps(kPiLo);
+            const auto s3 = _mm_set1_ps(kS3), s5 = _mm_set1_ps(kS5), s7 = _mm_set1_ps(kS7), s9 = _mm_set1_ps(kS9);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                const auto v = _mm_loadu_ps(x + i);
+                const auto k = _mm_round_ps(_mm_mul_ps(v, inv_pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                const auto r = _mm_sub_ps(_mm_sub_ps(v, _mm_mul_ps(k, pi_hi)), _mm_mul_ps(k, pi_lo));
+                const auto r2 = _mm_mul_ps(r, r);
+                auto p = _mm_add_ps(_mm_mul_ps(r2, s9), s7);
+                p = _mm_add_ps(_mm_mul_ps(r2, p), s5);
+                p = _mm_add_ps(_mm_mul_ps(r2, p), s3);
+                p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, r2), p), r);
+                // odd k flips the sign
+                const auto sign = _mm_slli_epi32(_mm_cvtps_epi32(k), 31);
+                _mm_storeu_ps(y + i, _mm_xor_ps(p, _mm_castsi128_ps(sign)));
+            }
+            sin_scalar(x + i, y + i, n - i);
+        }
+
+        // log-step scan inside the register, then add the running total from the previous block
+        PERF_TARGET("sse4.2") void prefix_sum_sse42(const float* x, float* y, size_t n)
+        {
+            auto carry = _mm_setzero_ps();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                auto v = _mm_loadu_ps(x + i);
+                v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+                v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+                v = _mm_add_ps(v, carry);
+                _mm_storeu_ps(y + i, v);
+                carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+            }
+            prefix_sum_scalar(x + i, y + i, n - i, _mm_cvtss_f32(carry));
+        }
+
+        // -------------------------------------------------------------------------------------------------
+        // AVX2 + FMA; every AVX2 part has FMA3 so there's no point in a separate tier
+
+        PERF_TARGET("avx2,fma") inline float hsum(__m256 v)
+        {
+            auto s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+            return _mm_cvtss_f32(s);
+        }
+
+        PERF_TARGET("avx2,fma") float sum_avx2(const float* x, size_t n)
+        {
+            auto a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                a0 = _mm256_add_ps(a0, _mm256_loadu_ps(x + i));
+                a1 = _mm256_add_ps(a1, _mm256_loadu_ps(x + i + 8));
+                a2 = _mm256_add_ps(a2, _mm256_loadu_ps(x + i + 16));
+                a3 = _mm256_add_ps(a3, _mm256_loadu_ps(x + i + 24));
+            }
+            for (; i + 8 <= n; i += 8)
+                a0 = _mm256_add_ps(a0, _mm256_loadu_ps(x + i));
+            return hsum(_mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3))) + sum_scalar(x + i, n - i);
+        }
+
+        PERF_TARGET("avx2,fma") float dot_avx2(const float* x, const float* y, size_t n)
+        {
+            auto a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                a0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), a0);
+                a1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), a1);
+                a2 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 16), _mm256_loadu_ps(y + i + 16), a2);
+                a3 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 24), _mm256_loadu_ps(y + i + 24), a3);
+            }
+            for (; i + 8 <= n; i += 8)
+                a0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), a0);
+            return hsum(_mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3))) + dot_scalar(x + i, y + i, n - i);
+        }
+
+        PERF_TARGET("avx2,fma") void saxpy_avx2(float a, const float* x, float* y, size_t n)
+        {
+            const auto va = _mm256_set1_ps(a);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+            saxpy_scalar(a, x + i, y + i, n - i);
+        }
+
+        PERF_TARGET("avx2,fma") void sin_avx2(const float* x, float* y, size_t n)
+        {
+            const auto inv_pi = _mm256_set1_ps(kInvPi);
+            const auto pi_hi = _mm256_set1_ps(kPiHi);
+            const auto pi_lo = _mm256_set1_ps(kPiLo);
+            const auto s3 = _mm256_set1_ps(kS3), s5 = _mm256_set1_ps(kS5), s7 = _mm256_set1_ps(kS7), s9 = _mm256_set1_ps(kS9);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                const auto v = _mm256_loadu_ps(x + i);
+                const auto k = _mm256_round_ps(_mm256_mul_ps(v, inv_pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                const auto r = _mm256_fnmadd_ps(k, pi_lo, _mm256_fnmadd_ps(k, pi_hi, v));
+                const auto r2 = _mm256_mul_ps(r, r);
+                auto p = _mm256_fmadd_ps(r2, s9, s7);
+                p = _mm256_fmadd_ps(r2, p, s5);
+                p = _mm256_fmadd_ps(r2, p, s3);
+                p = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), p, r);
+                const auto sign = _mm256_slli_epi32(_mm256_cvtps_epi32(k), 31);
+                _mm256_storeu_ps(y + i, _mm256_xor_ps(p, _mm256_castsi256_ps(sign)));
+            }
+            sin_scalar(x + i, y + i, n - i);
+        }
+
+        // the byte shifts only work within 128 bit lanes, so scan each half and then add the low half's total to the high half
+        PERF_TARGET("avx2,fma") void prefix_sum_avx2(const float* x, float* y, size_t n)
+        {
+            const auto last = _mm256_set1_epi32(7);
+            auto carry = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                auto v = _mm256_loadu_ps(x + i);
+                v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 4)));
+                v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 8)));
+                const auto low_total = _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+                v = _mm256_add_ps(v, _mm256_permute2f128_ps(low_total, low_total, 0x08));
+                v = _mm256_add_ps(v, carry);
+                _mm256_storeu_ps(y + i, v);
+                carry = _mm256_permutevar8x32_ps(v, last);
+            }
+            prefix_sum_scalar(x + i, y + i, n - i, _mm256_cvtss_f32(carry));
+        }
+
+        // -------------------------------------------------------------------------------------------------
+        // AVX-512F
+
+        PERF_TARGET("avx512f") float sum_avx512(const float* x, size_t n)
+        {
+            auto a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps(), a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64)
+            {
+                a0 = _mm512_add_ps(a0, _mm512_loadu_ps(x + i));
+                a1 = _mm512_add_ps(a1, _mm512_loadu_ps(x + i + 16));
+                a2 = _mm512_add_ps(a2, _mm512_loadu_ps(x + i + 32));
+                a3 = _mm512_add_ps(a3, _mm512_loadu_ps(x + i + 48));
+            }
+            for (; i + 16 <= n; i += 16)
+                a0 = _mm512_add_ps(a0, _mm512_loadu_ps(x + i));
+            // the tail is a masked load rather than a scalar loop
+            if (i < n)
+                a1 = _mm512_add_ps(a1, _mm512_maskz_loadu_ps(__mmask16((1u << (n - i)) - 1), x + i));
+            return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a2, a3)));
+        }
+
+        PERF_TARGET("avx512f") float dot_avx512(const float* x, const float* y, size_t n)
+        {
+            auto a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps(), a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64)
+            {
+                a0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), a0);
+                a1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), a1);
+                a2 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 32), _mm512_loadu_ps(y + i + 32), a2);
+                a3 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 48), _mm512_loadu_ps(y + i + 48), a3);
+            }
+            for (; i + 16 <= n; i += 16)
+                a0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), a0);
+            if (i < n)
+            {
+                const auto m = __mmask16((1u << (n - i)) - 1);
+                a1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i), a1);
+            }
+            return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a2, a3)));
+        }
+
+        PERF_TARGET("avx512f") void saxpy_avx512(float a, const float* x, float* y, size_t n)
+        {
+            const auto va = _mm512_set1_ps(a);
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+                _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+            if (i < n)
+            {
+                const auto m = __mmask16((1u << (n - i)) - 1);
+                _mm512_mask_storeu_ps(y + i, m, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i)));
+            }
+        }
+
+        PERF_TARGET("avx512f") inline __m512 sin16(__m512 v)
+        {
+            const auto k = _mm512_roundscale_ps(_mm512_mul_ps(v, _mm512_set1_ps(kInvPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            const auto r = _mm512_fnmadd_ps(k, _mm512_set1_ps(kPiLo), _mm512_fnmadd_ps(k, _mm512_set1_ps(kPiHi), v));
+            const auto r2 = _mm512_mul_ps(r, r);
+            auto p = _mm512_fmadd_ps(r2, _mm512_set1_ps(kS9), _mm512_set1_ps(kS7));
+            p = _mm512_fmadd_ps(r2, p, _mm512_set1_ps(kS5));
+            p = _mm512_fmadd_ps(r2, p, _mm512_set1_ps(kS3));
+            p = _mm512_fmadd_ps(_mm512_mul_ps(r, r2), p, r);
+            const auto sign = _mm512_slli_epi32(_mm512_cvtps_epi32(k), 31);
+            return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(p), sign));
+        }
+
+        PERF_TARGET("avx512f") void sin_avx512(const float* x, float* y, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+                _mm512_storeu_ps(y + i, sin16(_mm512_loadu_ps(x + i)));
+            if (i < n)
+            {
+                const auto m = __mmask16((1u << (n - i)) - 1);
+                _mm512_mask_storeu_ps(y + i, m, sin16(_mm512_maskz_loadu_ps(m, x + i)));
+            }
+        }
+
+        // valignd against zero shifts whole elements across the full register, so it's a plain 4 step scan
+        PERF_TARGET("avx512f") void prefix_sum_avx512(const float* x, float* y, size_t n)
+        {
+            const auto zero = _mm512_setzero_si512();
+            const auto last = _mm512_set1_epi32(15);
+            auto carry = _mm512_setzero_ps();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                auto v = _mm512_loadu_ps(x + i);
+                v = _mm512_add_ps(v, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), zero, 15)));
+                v = _mm512_add_ps(v, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), zero, 14)));
+                v = _mm512_add_ps(v, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), zero, 12)));
+                v = _mm512_add_ps(v, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), zero, 8)));
+                v = _mm512_add_ps(v, carry);
+                _mm512_storeu_ps(y + i, v);
+                carry = _mm512_permutexvar_ps(last, v);
+            }
+            prefix_sum_scalar(x + i, y + i, n - i, _mm512_cvtss_f32(carry));
+        }
+
+        // -------------------------------------------------------------------------------------------------
+
+        const kernels kScalarKernels = { sum_scalar, dot_scalar, saxpy_scalar, sin_scalar, prefix_sum_scalar };
+        const kernels kSSE42Kernels = { sum_sse42, dot_sse42, saxpy_sse42, sin_sse42, prefix_sum_sse42 };
+        const kernels kAVX2Kernels = { sum_avx2, dot_avx2, saxpy_avx2, sin_avx2, prefix_sum_avx2 };
+        const kernels kAVX512Kernels = { sum_avx512, dot_avx512, saxpy_avx512, sin_avx512, prefix_sum_avx512 };
+
+        constexpr auto kSSE42Needs = system_info::features{} | system_info::feature::kSSE42;
+        constexpr auto kAVX2Needs = system_info::features{} | system_info::feature::kAVX2 | system_info::feature::kFMA;
+        constexpr auto kAVX512Needs = system_info::features{} | system_info::feature::kAVX512F;
+    }
+
+    const char* isa_name(isa i)
+    {
+        switch (i)
+        {
+        case isa::kScalar: return "scalar";
+        case isa::kSSE42: return "sse4.2";
+        case isa::kAVX2: return "avx2";
+        case isa::kAVX512: return "avx512";
+        }
+        return "?";
+    }
+
+    bool isa_supported(isa i)
+    {
+        const auto& f = system_info::cpu_features();
+        switch (i)
+        {
+        case isa::kScalar: return true;
+        case isa::kSSE42: return f.has_all(kSSE42Needs);
+        case isa::kAVX2: return f.has_all(kAVX2Needs);
+        case isa::kAVX512: return f.has_all(kAVX512Needs);
+        }
+        return false;
+    }
+
+    const kernels& kernels_for(isa i)
+    {
+        switch (i)
+        {
+        case isa::kSSE42: return kSSE42Kernels;
+        case isa::kAVX2: return kAVX2Kernels;
+        case isa::kAVX512: return kAVX512Kernels;
+        default: return kScalarKernels;
+        }
+    }
+
+    isa best_isa()
+    {
+        static const isa _best = []() {
+            for (auto i : { isa::kAVX512, isa::kAVX2, isa::kSSE42 })
+                if (isa_supported(i))
+                    return i;
+            return isa::kScalar;
+        }();
+        return _best;
+    }
+
+    const kernels& best_kernels()
+    {
+        return kernels_for(best_isa());
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+// A handful of single precision compute kernels, each in scalar, SSE4.2, AVX2 (+FMA) and AVX-512 flavours.
+// The SIMD variants are compiled with per-function target attributes so one binary runs on every host;
+// which ones can actually be used is decided at runtime from cpuid.
+// usage:
+// const auto& k = perf::simd::best_kernels();
+// const auto s = k._sum(data, count);
+namespace perf::simd
+{
+    enum class isa
+    {
+        kScalar,
+        kSSE42,
+        kAVX2,
+        kAVX512,
+    };
+
+    constexpr isa kAllIsas[] = { isa::kScalar, isa::kSSE42, isa::kAVX2, isa::kAVX512 };
+
+    const char* isa_name(isa i);
+
+    // true if both the CPU and the OS (saved register state) support it
+    bool isa_supported(isa i);
+
+    struct kernels
+    {
+        // sum of x[0..n)
+        float (*_sum)(const float* x, size_t n);
+        // sum of x[i]*y[i]
+        float (*_dot)(const float* x, const float* y, size_t n);
+        // y[i] = a*x[i] + y[i]
+        void (*_saxpy)(float a, const float* x, float* y, size_t n);
+        // y[i] = sin(x[i]), polynomial approximation, absolute error ~1e-6 for any x within a few thousand radians of 0
+        void (*_sin)(const float* x, float* y, size_t n);
+        // inclusive prefix sum; y[i] = x[0] + ... + x[i]
+        void (*_prefix_sum)(const float* x, float* y, size_t n);
+    };
+
+    // the kernels for a given ISA, regardless of whether this host supports it
+    const kernels& kernels_for(isa i);
+
+    // the widest supported variant
+    isa best_isa();
+    const kernels& best_kernels();
+}
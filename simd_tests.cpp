@@ -0,0 +1,150 @@
+#include "thread_tests.h"
+#include "perfutils.h"
+#include "simd_kernels.h"
+#include <cmath>
+#include <random>
+#include <string>
+#include <iostream>
+#include <iomanip>
+
+using steady_clock = std::chrono::steady_clock;
+
+namespace perf::threads
+{
+	namespace
+	{
+		// roughly L1, L2 and "memory" sized working sets (per input array)
+		constexpr size_t kSizes[] = { 1u << 12, 1u << 16, 1u << 22 };
+		// keep calling the kernel until a batch has taken at least this long, report the best of kBatches
+		constexpr auto kMinBatchTime = std::chrono::milliseconds(20);
+		constexpr unsigned kBatches = 5;
+
+		struct kernel_desc
+		{
+			const char* _name;
+			// nominal floating point operations per element, FMA counts as two
+			double _flops_per_element;
+			// run once over the buffers, return something to keep the optimiser honest
+			float (*_run)(const simd::kernels& k, const float* x, float* y, size_t n);
+		};
+
+		const kernel_desc kKernels[] = {
+			{ "sum", 1.0, [](const simd::kernels& k, const float* x, float*, size_t n) { return k._sum(x, n); } },
+			{ "dot", 2.0, [](const simd::kernels& k, const float* x, float* y, size_t n) { return k._dot(x, y, n); } },
+			{ "saxpy", 2.0, [](const simd::kernels& k, const float* x, float* y, size_t n) { k._saxpy(1e-6f, x, y, n); return y[n - 1]; } },
+			// range reduction (mul, round, 2 fma) + 4 fma + 2 mul
+			{ "sine", 15.0, [](const simd::kernels& k, const float* x, float* y, size_t n) { k._sin(x, y, n); return y[n - 1]; } },
+			{ "prefix sum", 1.0, [](const simd::kernels& k, const float* x, float* y, size_t n) { k._prefix_sum(x, y, n); return y[n - 1]; } },
+		};
+
+		volatile float _sink;
+
+		// elements per second
+		double measure(const kernel_desc& kernel, const simd::kernels& k, const std::vector<float>& x, std::vector<float>& y)
+		{
+			double best = 0.0;
+			for (auto b = 0u; b < kBatches; ++b)
+			{
+				size_t calls = 0;
+				float keep = 0.0f;
+				const auto start = steady_clock::now();
+				auto elapsed = steady_clock::duration{};
+				do
+				{
+					keep += kernel._run(k, x.data(), y.data(), x.size());
+					++calls;
+					elapsed = steady_clock::now() - start;
+				} while (elapsed < kMinBatchTime);
+				_sink = keep;
+				best = std::max(best, double(calls) * double(x.size()) / std::chrono::duration<double>(elapsed).count());
+			}
+			return best;
+		}
+
+		// each variant against the scalar version (and the sine against libm); returns the worst relative error
+		double validate(const char* name, const simd::kernels& k, const std::vector<float>& x, const std::vector<float>& y0)
+		{
+			const auto& ref = simd::kernels_for(simd::isa::kScalar);
+			const auto n = x.size();
+			const auto rel = [](double a, double b) { return std::abs(a - b) / std::max(1.0, std::abs(b)); };
+			std::string which{ name };
+			if (which == "sum")
+				return rel(k._sum(x.data(), n), ref._sum(x.data(), n));
+			if (which == "dot")
+				return rel(k._dot(x.data(), y0.data(), n), ref._dot(x.data(), y0.data(), n));
+
+			std::vector<float> got(y0), expected(y0);
+			if (which == "saxpy")
+			{
+				k._saxpy(0.5f, x.data(), got.data(), n);
+				ref._saxpy(0.5f, x.data(), expected.data(), n);
+			}
+			else if (which == "sine")
+			{
+				k._sin(x.data(), got.data(), n);
+				for (size_t i = 0; i < n; ++i)
+					expected[i] = float(std::sin(double(x[i])));
+			}
+			else
+			{
+				k._prefix_sum(x.data(), got.data(), n);
+				ref._prefix_sum(x.data(), expected.data(), n);
+			}
+			double worst = 0.0;
+			for (size_t i = 0; i < n; ++i)
+				worst = std::max(worst, rel(got[i], expected[i]));
+			return worst;
+		}
+	}
+
+	void test_simd_kernels()
+	{
+		std::cout << "SIMD kernels, best of " << kBatches << " batches of at least " << kMinBatchTime.count() << "ms, host's best ISA is "
+			<< simd::isa_name(simd::best_isa()) << "\n";
+		std::cout << "\tGFLOP/s uses a nominal flop count per element; speedup is relative to scalar, error relative to scalar (sine: to libm)\n";
+
+		std::mt19937 rng{ 42 };
+		std::uniform_real_distribution<float> dist{ -100.0f, 100.0f };
+		std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+		for (const auto& kernel : kKernels)
+		{
+			std::cout << "\n" << kernel._name << "\n";
+			std::cout << "\t" << std::setw(10) << "elements" << std::setw(8) << "isa" << std::setw(12) << "Melem/s" << std::setw(10) << "GFLOP/s"
+				<< std::setw(9) << "speedup" << std::setw(10) << "error" << "\n";
+			for (auto size : kSizes)
+			{
+				// a prefix sum over +-100 is mostly cancellation, which makes the error column meaningless
+				const auto positive = std::string{ kernel._name } == "prefix sum";
+				std::vector<float> x(size), y(size);
+				for (auto& v : x)
+					v = positive ? unit(rng) : dist(rng);
+				for (auto& v : y)
+					v = unit(rng);
+
+				double scalar_rate = 0.0;
+				for (auto isa : simd::kAllIsas)
+				{
+					if (!simd::isa_supported(isa))
+					{
+						std::cout << "\t" << std::setw(10) << size << std::setw(8) << simd::isa_name(isa) << "  not supported on this host\n";
+						continue;
+					}
+					const auto& k = simd::kernels_for(isa);
+					const auto error = validate(kernel._name, k, x, y);
+					auto scratch = y;
+					const auto rate = measure(kernel, k, x, scratch);
+					if (isa == simd::isa::kScalar)
+						scalar_rate = rate;
+
+					std::cout << "\t" << std::setw(10) << size << std::setw(8) << simd::isa_name(isa)
+						<< std::fixed << std::setprecision(1) << std::setw(12) << rate / 1e6
+						<< std::setprecision(2) << std::setw(10) << rate * kernel._flops_per_element / 1e9
+						<< std::setw(9) << rate / scalar_rate
+						<< std::scientific << std::setprecision(1) << std::setw(10) << error << "\n";
+				}
+			}
+		}
+		std::cout << std::defaultfloat;
+	}
+}
@@ -1,8 +1,12 @@
 
 #include "thread_tests.h"
 #include "perfutils.h"
+#include "wait_strategies.h"
+#include "worker_pool.h"
 #include <atomic>
+#include <fstream>
 #include <iostream>
+#include <iomanip>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -16,67 +20,215 @@ using microseconds = std::chrono::microseconds;
 
 namespace perf::threads
 {
-	void test_wait_loops()
+	namespace
 	{
-		std::vector<double>	stats;
-		std::mutex stat_mtx;
+		// package energy counter from RAPL via powercap, in microjoules; false if we can't read it
+		//NOTE: Linux only and usually root only, it wraps every few minutes which we don't bother with
+		bool read_package_energy(uint64_t& uj)
+		{
+			std::ifstream file{ "/sys/class/powercap/intel-rapl:0/energy_uj" };
+			return bool(file >> uj);
+		}
+
+		// average package power in W between two energy readings, or "n/a"
+		void print_package_power(bool have_energy, uint64_t energy_start, double seconds, int width)
+		{
+			uint64_t energy_end = 0;
+			if (have_energy && read_package_energy(energy_end) && energy_end >= energy_start)
+				std::cout << std::setw(width) << std::fixed << std::setprecision(2) << double(energy_end - energy_start) / 1e6 / seconds << std::defaultfloat;
+			else
+				std::cout << std::setw(width) << "n/a";
+		}
 
-		const auto tf = [&stats, &stat_mtx]() {
-			double stat = 0.0;
-			constexpr auto kRuns = 4000u;
-			for (auto n = 0u; n < kRuns; ++n)
+		// every thread waits out a 5ms deadline kRuns times with the strategy, nothing ever wakes it early; reports how
+		// long the waits really took, and the package power while they did
+		template<typename Strategy>
+		void run_wait_loop(const Strategy& strategy)
+		{
+			std::cout << strategy.name() << "\n";
+			if (!strategy.supported())
 			{
-				const auto start = hi_res_clock::now();
-				for (;;)
+				std::cout << "\tnot supported on this host (no WAITPKG), skipping\n";
+				return;
+			}
+
+			const auto thread_count = std::thread::hardware_concurrency();
+			// a slot per thread so that recording a run doesn't disturb the other threads' waits
+			perf::PerThreadStats stats{ thread_count };
+			const auto wait_ticks = uint64_t(5e6 * tsc_ticks_per_ns());
+
+			const auto tf = [&stats, &strategy, wait_ticks](unsigned t) {
+				constexpr auto kRuns = 4000u;
+				const std::atomic<unsigned> never{ 0 };
+				for (auto n = 0u; n < kRuns; ++n)
 				{
-					const auto now = hi_res_clock::now();
-					if (std::chrono::duration_cast<milliseconds>(now - start).count() >= 5)
-						break;
-					std::this_thread::yield();
+					const auto start = hi_res_clock::now();
+					strategy.wait_for_change(never, 0u, rdtsc() + wait_ticks);
+					const auto end = hi_res_clock::now();
+					stats[t].push(double(std::chrono::duration_cast<nanoseconds>(end - start).count()));
 				}
-				const auto end = hi_res_clock::now();
-				stat += (end - start).count();
+			};
+
+			uint64_t energy_start = 0;
+			const auto have_energy = read_package_energy(energy_start);
+			const auto start = hi_res_clock::now();
+
+			std::vector<std::thread>	_threads;
+			std::cout << "\tcreating/starting " << thread_count << " threads\n";
+			for (auto t = 0u; t < thread_count; ++t)
+			{
+				_threads.emplace_back(tf, t);
 			}
-			std::lock_guard lock{ stat_mtx };
-			stats.emplace_back(stat / kRuns);
-		};
 
-		std::vector<std::thread>	_threads;
-		std::cout << "creating/starting " << std::thread::hardware_concurrency() << " threads\n";
-		for (auto t = 0u; t < std::thread::hardware_concurrency(); ++t)
-		{
-			_threads.emplace_back(tf);
-		}
+			std::cout << "\twaiting for threads to finish...";
+			for (auto& t : _threads)
+			{
+				t.join();
+			}
+			std::cout << "done" << std::endl;
 
-		std::cout << "waiting for threads to finish...";
-		for (auto& t : _threads)
-		{
-			t.join();
+			const auto seconds = std::chrono::duration<double>(hi_res_clock::now() - start).count();
+			const auto total_stat = stats.reduce();
+
+			std::cout << "\tMean " << total_stat.mean() / 1000000 << "ms, standard deviation " << total_stat.stdev() / 1000 << "us\n";
+			std::cout << "\tMedian " << total_stat.median() / 1000000 << "ms, 1st quartile " << total_stat.first_quartile() / 1000000 << "ms, 3rd quartile " << total_stat.third_quartile() / 1000000 << "ms" << std::endl;
+			switch (total_stat.shape())
+			{
+			case perf::Stats::Shape::kSymmetric:
+				std::cout << "\tdistribution is ~symmetric\n";
+				break;
+			case perf::Stats::Shape::kLeft:
+				std::cout << "\tdistribution is skewed towards the first quartile\n";
+				break;
+			case perf::Stats::Shape::kRight:
+				std::cout << "\tdistribution is skewed towards the third quartile\n";
+				break;
+			}
+			std::cout << "\tpackage W ";
+			print_package_power(have_energy, energy_start, seconds, 0);
+			std::cout << "\n";
 		}
-		std::cout << "done" << std::endl;
 
-		perf::RunningStat total_stat;
-		for (auto d : stats)
+		// a waker thread stores to a flag every kWakeGap, the waiter waits for it with the strategy under test and
+		// records how long after the store it noticed
+		template<typename Strategy>
+		void run_wake_latency(const Strategy& strategy)
 		{
-			total_stat.push(d);
+			constexpr auto kRounds = 2000u;
+			constexpr auto kWakeGap = microseconds(100);
+
+			std::cout << "\t" << std::setw(12) << strategy.name();
+			if (!strategy.supported())
+			{
+				std::cout << "  not supported on this host (no WAITPKG), skipping\n";
+				return;
+			}
+
+			const auto ticks_per_ns = tsc_ticks_per_ns();
+			// far longer than the gap, so a timeout means the strategy missed the wake-up
+			const auto timeout_ticks = uint64_t(10.0 * double(std::chrono::duration_cast<nanoseconds>(kWakeGap).count()) * ticks_per_ns);
+
+			std::atomic<unsigned> flag{ 0 };
+			std::atomic<unsigned> ack{ 0 };
+			std::atomic<uint64_t> stamp{ 0 };
+			std::vector<double> latencies;
+			unsigned timeouts = 0;
+
+			uint64_t energy_start = 0;
+			const auto have_energy = read_package_energy(energy_start);
+			const auto start = hi_res_clock::now();
+			std::thread waiter{ [&]() {
+				std::vector<double> mine;
+				mine.reserve(kRounds);
+				for (auto round = 0u; round < kRounds; ++round)
+				{
+					if (strategy.wait_for_change(flag, round, rdtsc() + timeout_ticks))
+						mine.emplace_back(double(rdtsc() - stamp.load(std::memory_order_relaxed)) / ticks_per_ns);
+					else
+					{
+						++timeouts;
+						while (flag.load(std::memory_order_acquire) == round)
+							std::this_thread::yield();
+					}
+					ack.store(round + 1, std::memory_order_release);
+				}
+				latencies = std::move(mine);
+			} };
+
+			std::thread waker{ [&]() {
+				for (auto round = 0u; round < kRounds; ++round)
+				{
+					std::this_thread::sleep_for(kWakeGap);
+					stamp.store(rdtsc(), std::memory_order_relaxed);
+					flag.store(round + 1, std::memory_order_release);
+					while (ack.load(std::memory_order_acquire) != round + 1)
+						std::this_thread::yield();
+				}
+			} };
+
+			// on separate cores if we can, otherwise a spinning waiter just delays the wake-up it's waiting for
+			int waiter_cpu, waker_cpu;
+			if (pair_cpus(pair_placement::kSameL3, waiter_cpu, waker_cpu))
+			{
+				system_info::pin_thread(waiter, unsigned(waiter_cpu));
+				system_info::pin_thread(waker, unsigned(waker_cpu));
+			}
+			waker.join();
+			waiter.join();
+
+			const auto seconds = std::chrono::duration<double>(hi_res_clock::now() - start).count();
+
+			Stats latency;
+			latency.push_many(latencies.data(), latencies.size());
+			const double ps[] = { 0.5, 0.99 };
+			double p50_p99[2];
+			latency.percentiles(ps, p50_p99, 2);
+			std::cout << std::fixed << std::setprecision(0)
+				<< std::setw(10) << p50_p99[0]
+				<< std::setw(10) << p50_p99[1]
+				<< std::setw(10) << timeouts << std::defaultfloat;
+			print_package_power(have_energy, energy_start, seconds, 10);
+			std::cout << "\n";
 		}
 
-		std::cout << "\tMean " << total_stat.mean() / 1000000 << "ms, standard deviation " << total_stat.stdev() / 1000 << "us\n";
-		std::cout << "\tMedian " << total_stat.median() / 1000000 << "ms, 1st quartile " << total_stat.first_quartile() / 1000000 << "ms, 3rd quartile " << total_stat.third_quartile() / 1000000 << "ms" << std::endl;
-		switch (total_stat.shape())
+		// every strategy, the power states of the WAITPKG ones included, in the same order for both measurements
+		template<typename Fn>
+		void for_each_wait_strategy(Fn fn)
 		{
-		case perf::Stats::Shape::kSymmetric:
-			std::cout << "\tdistribution is ~symmetric\n";
-			break;
-		case perf::Stats::Shape::kLeft:
-			std::cout << "\tdistribution is skewed towards the first quartile\n";
-			break;
-		case perf::Stats::Shape::kRight:
-			std::cout << "\tdistribution is skewed towards the third quartile\n";
-			break;
+			fn(wait::yield_spin{});
+			fn(wait::pause_spin{});
+			for (auto state : { wait::power_state::kC01, wait::power_state::kC02 })
+			{
+				wait::tpause_wait tpause;
+				tpause._state = state;
+				fn(tpause);
+			}
+			for (auto state : { wait::power_state::kC01, wait::power_state::kC02 })
+			{
+				wait::umwait_wait umwait;
+				umwait._state = state;
+				fn(umwait);
+			}
 		}
 	}
 
+	// how each way of waiting behaves; first every thread waits out 5ms deadlines, then a single waiter is woken by
+	// another thread every 100us. The yield spin is the loop this always measured, the rest are the pause spin and the
+	// WAITPKG (tpause/umwait) light sleep states, skipped where the CPU hasn't got them
+	void test_wait_loops()
+	{
+		std::cout << "waiting out 5ms on every thread, 4000 times\n";
+		std::cout << "\tpackage W is the whole package's average power over the run (RAPL)\n";
+		for_each_wait_strategy([](const auto& strategy) { run_wait_loop(strategy); });
+
+		std::cout << "\nwaking a waiting thread every 100us, 2000 times\n";
+		std::cout << "\tpackage W includes the waker\n";
+		std::cout << "\twaiter and waker are pinned to two cores sharing an L3 when there are any\n";
+		std::cout << "\t" << std::setw(12) << "strategy" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+			<< std::setw(10) << "timeouts" << std::setw(10) << "package W" << "\n";
+		for_each_wait_strategy([](const auto& strategy) { run_wake_latency(strategy); });
+	}
+
 	bool has_ht_cores()
 	{
 		return false;
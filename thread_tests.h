@@ -10,4 +10,9 @@ namespace perf::threads
 {
 	void test_wait_loops();
 	void test_ht_workers();
+	void test_atomic_contention();
+	void test_locks();
+	void test_queues();
+	void test_scheduler();
+	void test_simd_kernels();
 }
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "cpuid.h"
+#include "cpu_features.h"
+
+namespace system_info
+{
+    // core type on hybrid parts (cpuid leaf 0x1a), kUnknown everywhere else
+    enum class core_type
+    {
+        kUnknown,
+        kPerformance,
+        kEfficient,
+    };
+
+    inline const char* core_type_name(core_type type)
+    {
+        switch (type)
+        {
+        case core_type::kPerformance: return "P-core";
+        case core_type::kEfficient: return "E-core";
+        default: return "core";
+        }
+    }
+
+    // one entry per logical processor this process is allowed to run on
+    struct logical_processor
+    {
+        // index used by the OS scheduler, i.e. what we pass to the affinity calls
+        unsigned _os_index = 0;
+        unsigned _x2apic_id = 0;
+        // hw thread index within the core
+        unsigned _smt_id = 0;
+        // physical core, unique within the package
+        unsigned _core_id = 0;
+        unsigned _package_id = 0;
+        // logical processors with the same id share a last level cache
+        unsigned _l3_id = 0;
+        core_type _core_type = core_type::kUnknown;
+    };
+
+    // pin the calling thread to a single logical processor
+    // returns false if the platform doesn't support it or the call failed
+    inline bool pin_this_thread(unsigned os_index)
+    {
+#if defined(_WIN32)
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << os_index) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(os_index, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)os_index;
+        return false;
+#endif
+    }
+
+    inline bool pin_thread(std::thread& t, unsigned os_index)
+    {
+#if defined(_WIN32)
+        return SetThreadAffinityMask(HANDLE(t.native_handle()), DWORD_PTR(1) << os_index) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(os_index, &set);
+        return pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0;
+#else
+        (void)t;
+        (void)os_index;
+        return false;
+#endif
+    }
+
+    namespace detail
+    {
+        // decode the x2APIC id of whichever processor we're currently running on
+        // into SMT/core/package ids using leaf 0x1f (or 0xb), falling back to leaf 1 for old hardware
+        inline void decode_current_processor(logical_processor& lp)
+        {
+            cpuid cpu_id{ 0 };
+            const auto max_leaf = cpu_id.eax();
+
+            // native model id; EAX[31:24] is 0x20 for Atom and 0x40 for Core
+            if (max_leaf >= 0x1a && cpu_features().has(feature::kHybrid))
+            {
+                cpu_id = { 0x1a, 0 };
+                switch (cpu_id.eax() >> 24)
+                {
+                case 0x20: lp._core_type = core_type::kEfficient; break;
+                case 0x40: lp._core_type = core_type::kPerformance; break;
+                default: break;
+                }
+            }
+            if (max_leaf < 0xb)
+            {
+                cpu_id = 1;
+                lp._x2apic_id = cpu_id.extract_reg_field(cpuid::regs::ebx, 24, 31) & 0xff;
+                lp._core_id = lp._x2apic_id;
+                return;
+            }
+
+            auto leaf = 0xb;
+            if (max_leaf >= 0x1f)
+            {
+                cpu_id = { 0x1f, 0 };
+                if (cpu_id.ebx())
+                    leaf = 0x1f;
+            }
+
+            auto smt_shift = 0u;
+            auto package_shift = 0u;
+            for (auto sub_leaf = 0; ; ++sub_leaf)
+            {
+                cpu_id = { leaf, sub_leaf };
+                if (!cpu_id.ebx() && !cpu_id.eax())
+                    break;
+                const auto level_type = (cpu_id.ecx() >> 8) & 0xff;
+                const auto level_shift = cpu_id.eax() & 0x1f;
+                if (level_type == 1)
+                    smt_shift = level_shift;
+                package_shift = level_shift;
+                lp._x2apic_id = cpu_id.edx();
+            }
+
+            lp._smt_id = lp._x2apic_id & ((1u << smt_shift) - 1u);
+            // NOTE: on 0x1f systems this includes module/die bits, which keeps it unique within the package
+            lp._core_id = (lp._x2apic_id >> smt_shift) & ((1u << (package_shift - smt_shift)) - 1u);
+            lp._package_id = package_shift < 32 ? (lp._x2apic_id >> package_shift) : 0;
+
+            // deterministic cache parameters; leaf 4 on Intel, 0x8000001d on AMD. Same layout, EAX[25:14] is the
+            // max number of addressable ids sharing the cache
+            lp._l3_id = lp._package_id;
+            auto cache_leaf = 4;
+            cpu_id = int(0x80000000);
+            if (cpu_id.eax() >= 0x8000001d)
+            {
+                cpu_id = int(0x80000001);
+                // TopologyExtensions
+                if (cpu_id.bits_set(cpuid::regs::ecx, 1 << 22))
+                    cache_leaf = int(0x8000001d);
+            }
+            for (auto sub_leaf = 0; sub_leaf < 16; ++sub_leaf)
+            {
+                cpu_id = { cache_leaf, sub_leaf };
+                const auto cache_type = cpu_id.eax() & 0x1f;
+                if (!cache_type)
+                    break;
+                const auto cache_level = (cpu_id.eax() >> 5) & 0x7;
+                if (cache_level == 3)
+                {
+                    const auto sharing = ((cpu_id.eax() >> 14) & 0xfff) + 1;
+                    auto shift = 0u;
+                    while ((1u << shift) < sharing)
+                        ++shift;
+                    lp._l3_id = shift < 32 ? (lp._x2apic_id >> shift) : 0;
+                    break;
+                }
+            }
+        }
+
+        inline std::vector<logical_processor> build_topology()
+        {
+            std::vector<logical_processor> procs;
+#if defined(_WIN32)
+            DWORD_PTR process_mask = 0, system_mask = 0;
+            GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+            const auto previous = SetThreadAffinityMask(GetCurrentThread(), process_mask);
+            for (unsigned cpu = 0; cpu < sizeof(DWORD_PTR) * 8; ++cpu)
+            {
+                if (!(process_mask & (DWORD_PTR(1) << cpu)))
+                    continue;
+                logical_processor lp;
+                lp._os_index = cpu;
+                if (pin_this_thread(cpu))
+                    decode_current_processor(lp);
+                procs.emplace_back(lp);
+            }
+            SetThreadAffinityMask(GetCurrentThread(), previous);
+#elif defined(__linux__)
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed);
+            for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (!CPU_ISSET(cpu, &allowed))
+                    continue;
+                logical_processor lp;
+                lp._os_index = cpu;
+                if (pin_this_thread(cpu))
+                    decode_current_processor(lp);
+                procs.emplace_back(lp);
+            }
+            pthread_setaffinity_np(pthread_self(), sizeof(allowed), &allowed);
+#else
+            // no affinity control; pretend every logical processor is its own core
+            for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu)
+            {
+                logical_processor lp;
+                lp._os_index = cpu;
+                lp._core_id = cpu;
+                procs.emplace_back(lp);
+            }
+#endif
+            if (procs.empty())
+                procs.emplace_back(logical_processor{});
+            return procs;
+        }
+    }
+
+    // the topology map; built once, on first use, by visiting every logical processor we're allowed to run on
+    inline const std::vector<logical_processor>& topology()
+    {
+        static const std::vector<logical_processor> _topology = detail::build_topology();
+        return _topology;
+    }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "perfutils.h"
+#include "cpu_features.h"
+
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PERF_WAITPKG_TARGET __attribute__((target("waitpkg")))
+#else
+#define PERF_WAITPKG_TARGET
+#endif
+
+// Ways for a thread to wait for another one to change a word in memory, from burning the core to the WAITPKG
+// (umonitor/umwait/tpause) light sleep states. They all have the same interface:
+//   bool supported() const
+//   std::string name() const
+//   template<typename T> bool wait_for_change(const std::atomic<T>& word, T old, uint64_t deadline_tsc) const
+// where wait_for_change returns true once word != old, or false if the TSC got to deadline_tsc first.
+// usage:
+// perf::wait::umwait_wait w{ perf::wait::power_state::kC01 };
+// if (w.supported())
+//     w.wait_for_change(flag, 0u, rdtsc() + timeout_ticks);
+namespace perf::wait
+{
+    // the control operand of umwait/tpause; bit 0 clear asks for the deeper state
+    enum class power_state : unsigned
+    {
+        // deeper; slower to wake up, but gives more of the core to an SMT sibling and saves more power
+        kC02 = 0,
+        // lighter; faster to wake up
+        kC01 = 1,
+    };
+
+    inline const char* power_state_name(power_state s)
+    {
+        return s == power_state::kC02 ? "C0.2" : "C0.1";
+    }
+
+    inline bool waitpkg_supported()
+    {
+        return system_info::cpu_features().has(system_info::feature::kWaitPkg);
+    }
+
+    namespace detail
+    {
+        PERF_WAITPKG_TARGET inline void umonitor(const volatile void* address)
+        {
+            _umonitor(const_cast<void*>(address));
+        }
+
+        // returns true if the OS imposed time limit (IA32_UMWAIT_CONTROL) cut the wait short
+        PERF_WAITPKG_TARGET inline bool umwait(power_state state, uint64_t deadline_tsc)
+        {
+            return _umwait(unsigned(state), deadline_tsc) != 0;
+        }
+
+        PERF_WAITPKG_TARGET inline void tpause(power_state state, uint64_t deadline_tsc)
+        {
+            _tpause(unsigned(state), deadline_tsc);
+        }
+    }
+
+    // the classic; spin on the word with a pause in between loads
+    struct pause_spin
+    {
+        bool supported() const
+        {
+            return true;
+        }
+
+        std::string name() const
+        {
+            return "pause";
+        }
+
+        template<typename T>
+        bool wait_for_change(const std::atomic<T>& word, T old, uint64_t deadline_tsc) const
+        {
+            while (word.load(std::memory_order_acquire) == old)
+            {
+                if (rdtsc() >= deadline_tsc)
+                    return false;
+                _mm_pause();
+            }
+            return true;
+        }
+    };
+
+    // spin, but offer the core to the OS scheduler on every iteration
+    struct yield_spin
+    {
+        bool supported() const
+        {
+            return true;
+        }
+
+        std::string name() const
+        {
+            return "yield";
+        }
+
+        template<typename T>
+        bool wait_for_change(const std::atomic<T>& word, T old, uint64_t deadline_tsc) const
+        {
+            while (word.load(std::memory_order_acquire) == old)
+            {
+                if (rdtsc() >= deadline_tsc)
+                    return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+    };
+
+    // tpause doesn't watch memory, it just naps until a TSC deadline, so we nap in short slices and check the
+    // word in between; the slice length bounds the wake-up latency
+    struct tpause_wait
+    {
+        power_state _state = power_state::kC01;
+        uint64_t _slice_ticks = 2000;
+
+        bool supported() const
+        {
+            return waitpkg_supported();
+        }
+
+        std::string name() const
+        {
+            return std::string{ "tpause " } + power_state_name(_state);
+        }
+
+        template<typename T>
+        bool wait_for_change(const std::atomic<T>& word, T old, uint64_t deadline_tsc) const
+        {
+            while (word.load(std::memory_order_acquire) == old)
+            {
+                const auto now = rdtsc();
+                if (now >= deadline_tsc)
+                    return false;
+                detail::tpause(_state, std::min(deadline_tsc, now + _slice_ticks));
+            }
+            return true;
+        }
+    };
+
+    // arm the address monitor on the word's cache line and sleep until somebody writes to it (or the deadline, or
+    // the OS limit, or an interrupt; so always re-check)
+    //NOTE: the OS can disallow C0.2, in which case umwait quietly uses C0.1; on Linux see
+    //      /sys/devices/system/cpu/umwait_control
+    struct umwait_wait
+    {
+        power_state _state = power_state::kC01;
+
+        bool supported() const
+        {
+            return waitpkg_supported();
+        }
+
+        std::string name() const
+        {
+            return std::string{ "umwait " } + power_state_name(_state);
+        }
+
+        template<typename T>
+        bool wait_for_change(const std::atomic<T>& word, T old, uint64_t deadline_tsc) const
+        {
+            for (;;)
+            {
+                detail::umonitor(&word);
+                // the store may have landed before the monitor was armed
+                if (word.load(std::memory_order_acquire) != old)
+                    return true;
+                if (rdtsc() >= deadline_tsc)
+                    return false;
+                detail::umwait(_state, deadline_tsc);
+            }
+        }
+    };
+}
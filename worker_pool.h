@@ -0,0 +1,301 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+
+#include "topology.h"
+
+namespace perf::threads
+{
+    // how to map N worker threads onto the logical processors in the topology map
+    enum class placement
+    {
+        // leave it to the OS scheduler
+        kNone,
+        // fill all SMT siblings of a core before moving to the next core, and the next package
+        kCompact,
+        // one thread per physical core, round robin across packages, before doubling up on siblings
+        kScatter,
+    };
+
+    inline const char* placement_name(placement p)
+    {
+        switch (p)
+        {
+        case placement::kNone: return "none";
+        case placement::kCompact: return "compact";
+        case placement::kScatter: return "scatter";
+        }
+        return "?";
+    }
+
+    // points in a worker_pool's life a timeline recorder can hook into
+    enum class pool_event
+    {
+        // a worker thread started
+        kWorkerStart,
+        // run() is waking the workers
+        kWake,
+        // a worker got through the start barrier
+        kBarrierRelease,
+        // a worker starts the task
+        kTaskBegin,
+        // a worker finished the task
+        kTaskEnd,
+    };
+
+    // called on the thread the event happens on, with the index of the worker (0 for kWake); keeps the pool free of
+    // any particular recorder, e.g. hayai_tests.cpp puts the workers on a hayai::Trace timeline
+    using pool_trace_hook = void (*)(pool_event event, size_t worker);
+
+    inline std::atomic<pool_trace_hook>& trace_hook()
+    {
+        static std::atomic<pool_trace_hook> hook{ nullptr };
+        return hook;
+    }
+
+    // nullptr to stop tracing; pools that are running pick it up on their next event
+    inline void set_trace_hook(pool_trace_hook hook)
+    {
+        trace_hook().store(hook);
+    }
+
+    // returns the OS processor index for each of count threads, or -1 for "don't pin"
+    // wraps around if there are more threads than logical processors
+    inline std::vector<int> placement_cpus(placement p, size_t count)
+    {
+        std::vector<int> cpus(count, -1);
+        if (p == placement::kNone || !count)
+            return cpus;
+
+        auto procs = system_info::topology();
+        using lp_t = system_info::logical_processor;
+        if (p == placement::kCompact)
+        {
+            std::sort(procs.begin(), procs.end(), [](const lp_t& a, const lp_t& b) {
+                return std::make_tuple(a._package_id, a._core_id, a._smt_id) < std::make_tuple(b._package_id, b._core_id, b._smt_id);
+            });
+        }
+        else
+        {
+            // rank cores within each package so that core n of package 0 is followed by core n of package 1 etc.
+            std::sort(procs.begin(), procs.end(), [](const lp_t& a, const lp_t& b) {
+                return std::make_tuple(a._package_id, a._core_id) < std::make_tuple(b._package_id, b._core_id);
+            });
+            std::vector<std::tuple<unsigned, unsigned, unsigned, unsigned>> keys;
+            unsigned rank = 0;
+            for (size_t n = 0; n < procs.size(); ++n)
+            {
+                if (n && procs[n]._package_id != procs[n - 1]._package_id)
+                    rank = 0;
+                else if (n && procs[n]._core_id != procs[n - 1]._core_id)
+                    ++rank;
+                keys.emplace_back(procs[n]._smt_id, rank, procs[n]._package_id, unsigned(n));
+            }
+            std::sort(keys.begin(), keys.end());
+            std::vector<lp_t> scattered;
+            for (const auto& key : keys)
+                scattered.emplace_back(procs[std::get<3>(key)]);
+            procs.swap(scattered);
+        }
+
+        for (size_t n = 0; n < count; ++n)
+            cpus[n] = int(procs[n % procs.size()]._os_index);
+        return cpus;
+    }
+
+    // where to put the two ends of a producer/consumer style pair
+    enum class pair_placement
+    {
+        kNone,
+        // two hw threads of the same physical core
+        kSmtSiblings,
+        // different cores sharing a last level cache
+        kSameL3,
+        // different packages
+        kCrossPackage,
+    };
+
+    inline const char* pair_placement_name(pair_placement p)
+    {
+        switch (p)
+        {
+        case pair_placement::kNone: return "unpinned";
+        case pair_placement::kSmtSiblings: return "SMT siblings";
+        case pair_placement::kSameL3: return "same L3";
+        case pair_placement::kCrossPackage: return "cross package";
+        }
+        return "?";
+    }
+
+    // OS processor indices for the two ends of a pair, {-1,-1} for kNone
+    // returns false if the topology doesn't have such a pair
+    inline bool pair_cpus(pair_placement p, int& first, int& second)
+    {
+        first = second = -1;
+        if (p == pair_placement::kNone)
+            return true;
+
+        const auto& procs = system_info::topology();
+        for (const auto& a : procs)
+        {
+            for (const auto& b : procs)
+            {
+                bool match = false;
+                switch (p)
+                {
+                case pair_placement::kSmtSiblings:
+                    match = a._package_id == b._package_id && a._core_id == b._core_id && a._smt_id != b._smt_id;
+                    break;
+                case pair_placement::kSameL3:
+                    match = a._l3_id == b._l3_id && (a._package_id != b._package_id || a._core_id != b._core_id);
+                    break;
+                case pair_placement::kCrossPackage:
+                    match = a._package_id != b._package_id;
+                    break;
+                default:
+                    break;
+                }
+                if (match)
+                {
+                    first = int(a._os_index);
+                    second = int(b._os_index);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // thread counts to sweep in scaling experiments; 1, 2, 4, ... and finally every logical processor we have
+    inline std::vector<size_t> thread_count_sweep()
+    {
+        const auto max_threads = system_info::topology().size();
+        std::vector<size_t> counts;
+        for (size_t n = 1; n < max_threads; n *= 2)
+            counts.emplace_back(n);
+        counts.emplace_back(max_threads);
+        return counts;
+    }
+
+    // A fixed set of worker threads, pinned according to a placement policy.
+    // usage:
+    // worker_pool pool{ 4, placement::kScatter };
+    // pool.run([](size_t worker) { ... });
+    //
+    // run() releases all workers together from a spin barrier and returns when every one of them is done.
+    // Idle workers block on a condition variable so a pool can be kept around between experiments.
+    // Every worker reports its start, barrier release and task to the trace hook, if one is set.
+    class worker_pool
+    {
+    public:
+        worker_pool(size_t count, placement policy)
+            : worker_pool(placement_cpus(policy, count))
+        {
+        }
+
+        ~worker_pool()
+        {
+            {
+                std::lock_guard lock{ _mtx };
+                _quit = true;
+                ++_generation;
+            }
+            _wake.notify_all();
+            for (auto& t : _threads)
+                t.join();
+        }
+
+        // one worker per entry, pinned to that OS processor index (or not at all for -1)
+        explicit worker_pool(std::vector<int> cpus)
+            : _count(cpus.size())
+            , _cpus(std::move(cpus))
+        {
+            for (size_t n = 0; n < _count; ++n)
+            {
+                _threads.emplace_back([this, n]() { worker(n); });
+                if (_cpus[n] >= 0)
+                    system_info::pin_thread(_threads.back(), unsigned(_cpus[n]));
+            }
+        }
+
+        worker_pool(const worker_pool&) = delete;
+        worker_pool& operator=(const worker_pool&) = delete;
+
+        size_t size() const { return _count; }
+
+        // OS processor index of a worker, or -1 if it isn't pinned
+        int cpu(size_t worker) const { return _cpus[worker]; }
+
+        // run task(worker_index) on every worker, returns when all have finished
+        void run(std::function<void(size_t)> task)
+        {
+            std::unique_lock lock{ _mtx };
+            _task = std::move(task);
+            _arrived.store(0);
+            _pending = _count;
+            ++_generation;
+            trace(pool_event::kWake, 0);
+            _wake.notify_all();
+            _done.wait(lock, [this]() { return _pending == 0; });
+            _task = nullptr;
+        }
+
+    private:
+        void worker(size_t index)
+        {
+            trace(pool_event::kWorkerStart, index);
+            size_t seen = 0;
+            for (;;)
+            {
+                std::function<void(size_t)>* task;
+                {
+                    std::unique_lock lock{ _mtx };
+                    _wake.wait(lock, [this, seen]() { return _generation != seen; });
+                    seen = _generation;
+                    if (_quit)
+                        return;
+                    task = &_task;
+                }
+
+                // start barrier, so that the workers hit the task as close together as we can get them
+                _arrived.fetch_add(1);
+                while (_arrived.load() != _count)
+                    std::this_thread::yield();
+                trace(pool_event::kBarrierRelease, index);
+
+                trace(pool_event::kTaskBegin, index);
+                (*task)(index);
+                trace(pool_event::kTaskEnd, index);
+
+                std::lock_guard lock{ _mtx };
+                if (--_pending == 0)
+                    _done.notify_one();
+            }
+        }
+
+        static void trace(pool_event event, size_t worker)
+        {
+            if (const auto hook = trace_hook().load(std::memory_order_relaxed))
+                hook(event, worker);
+        }
+
+        const size_t _count;
+        std::vector<int> _cpus;
+        std::vector<std::thread> _threads;
+        std::mutex _mtx;
+        std::condition_variable _wake;
+        std::condition_variable _done;
+        std::function<void(size_t)> _task;
+        std::atomic<size_t> _arrived{ 0 };
+        size_t _pending = 0;
+        size_t _generation = 0;
+        bool _quit = false;
+    };
+}